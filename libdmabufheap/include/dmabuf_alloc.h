@@ -62,6 +62,14 @@ int DmabufHeapBufferSyncStart(unsigned int bufferFd, DmabufHeapBufferSyncType sy
 
 int DmabufHeapBufferSyncEnd(unsigned int bufferFd, DmabufHeapBufferSyncType syncType);
 
+/*
+ * Publish count and bytes of buffers allocated and not freed by this process in a stats page,
+ * see mem_stats_page.h of libmeminfo. Buffers allocated before are not counted.
+ * A child forked later publishes a page of its own, which starts from the counters of its parent.
+ * Return 0 on success, calling it again is a no-op.
+ */
+int DmabufHeapStatsPageEnable(void);
+
 #ifdef __cplusplus
 #if __cplusplus
 }
@@ -20,9 +20,11 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <pthread.h>
 #include "securec.h"
 #include "hilog/log.h"
 #include "dmabuf_alloc.h"
+#include "mem_stats_page.h"
 #include "memory_trace.h"
 
 #define DMA_BUF_HEAP_ROOT "/dev/dma_heap/"
@@ -30,6 +32,11 @@
 #define HEAP_NAME_MAX_LEN 128
 #define HEAP_PATH_LEN (HEAP_ROOT_LEN + HEAP_NAME_MAX_LEN + 1)
 
+static pthread_mutex_t g_statsPageLock = PTHREAD_MUTEX_INITIALIZER;
+static struct MemStatsPage *g_statsPage = NULL;
+static int g_statsPageFd = -1;
+static bool g_statsAtForkRegistered = false;
+
 static bool IsHeapNameValid(const char *heapName)
 {
     if ((heapName == NULL) || (strlen(heapName) == 0) ||
@@ -52,6 +59,26 @@ static bool IsSyncTypeValid(DmabufHeapBufferSyncType syncType)
     }
 }
 
+static void StatsPageAddBuffer(size_t size, bool alloc)
+{
+    struct MemStatsPage *page = __atomic_load_n(&g_statsPage, __ATOMIC_ACQUIRE);
+    if (page == NULL) {
+        return;
+    }
+    /* count and bytes are updated in one write, so that readers see them consistent */
+    uint64_t *buffers = &page->counters.dmabufBuffers;
+    uint64_t *bytes = &page->counters.dmabufBytes;
+    MemStatsPageWriteBegin(page);
+    if (alloc) {
+        __atomic_store_n(buffers, __atomic_load_n(buffers, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(bytes, __atomic_load_n(bytes, __ATOMIC_RELAXED) + size, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(buffers, __atomic_load_n(buffers, __ATOMIC_RELAXED) - 1, __ATOMIC_RELAXED);
+        __atomic_store_n(bytes, __atomic_load_n(bytes, __ATOMIC_RELAXED) - size, __ATOMIC_RELAXED);
+    }
+    MemStatsPageWriteEnd(page);
+}
+
 void SetOwnerIdForHeapFlags(DmabufHeapBuffer *buffer, enum DmaHeapFlagOwnerId ownerId)
 {
     if (buffer) {
@@ -106,6 +133,7 @@ int DmabufHeapBufferAlloc(unsigned int heapFd, DmabufHeapBuffer *buffer)
         return ret;
     }
     memtrace((void *)buffer, buffer->size, "DmabufHeap", true);
+    StatsPageAddBuffer(buffer->size, true);
     buffer->fd = data.fd;
     return ret;
 }
@@ -117,6 +145,7 @@ int DmabufHeapBufferFree(DmabufHeapBuffer *buffer)
         return -EINVAL;
     }
     memtrace((void *)buffer, buffer->size, "DmabufHeap", false);
+    StatsPageAddBuffer(buffer->size, false);
     return close(buffer->fd);
 }
 
@@ -142,4 +171,55 @@ int DmabufHeapBufferSyncEnd(unsigned int fd, DmabufHeapBufferSyncType syncType)
     struct dma_buf_sync sync = {0};
     sync.flags = DMA_BUF_SYNC_END | syncType;
     return ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+static void StatsPageAtForkPrepare(void)
+{
+    pthread_mutex_lock(&g_statsPageLock);
+}
+
+static void StatsPageAtForkParent(void)
+{
+    pthread_mutex_unlock(&g_statsPageLock);
+}
+
+/* the child inherits the page of its parent, publish its own one so that readers do not count both */
+static void StatsPageAtForkChild(void)
+{
+    if (g_statsPage != NULL) {
+        /* buffers are inherited by the child, it counts them until they are freed */
+        const unsigned int readTries = 64;
+        struct MemStatsCounters counters;
+        bool read = MemStatsPageRead(g_statsPage, &counters, readTries);
+        struct MemStatsPage *page = MemStatsPageRecreate(g_statsPage, &g_statsPageFd);
+        if (page != NULL && read) {
+            page->counters.dmabufBuffers = counters.dmabufBuffers;
+            page->counters.dmabufBytes = counters.dmabufBytes;
+        }
+        __atomic_store_n(&g_statsPage, page, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_statsPageLock);
+}
+
+int DmabufHeapStatsPageEnable(void)
+{
+    int ret = 0;
+    pthread_mutex_lock(&g_statsPageLock);
+    if (!g_statsAtForkRegistered) {
+        ret = -pthread_atfork(StatsPageAtForkPrepare, StatsPageAtForkParent, StatsPageAtForkChild);
+        g_statsAtForkRegistered = ret == 0;
+        if (ret != 0) {
+            HILOG_ERROR(LOG_CORE, "register atfork handlers failed, ret = %d.", ret);
+        }
+    }
+    if (g_statsPage == NULL && g_statsAtForkRegistered) {
+        struct MemStatsPage *page = MemStatsPageCreate(MEM_STATS_SOURCE_DMABUF_HEAP, &g_statsPageFd);
+        if (page == NULL) {
+            HILOG_ERROR(LOG_CORE, "create stats page failed, errno = %d.", errno);
+            ret = -errno;
+        }
+        __atomic_store_n(&g_statsPage, page, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_statsPageLock);
+    return ret;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_MEM_CGROUP_H
+#define LIB_MEM_CGROUP_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OHOS {
+namespace MemInfo {
+// memory of a cgroup v2, sizes in KB. It includes kernel memory charged to the cgroup,
+// and is hierarchical: a cgroup counts all cgroups below it.
+struct CgroupMemInfo {
+    // memory.current
+    uint64_t current = 0;
+
+    // memory.stat
+    uint64_t anon = 0;
+    uint64_t file = 0;
+    uint64_t kernel = 0; // sum of kernel stack, page tables, percpu, slab and sock before linux 5.18
+    uint64_t kernelStack = 0;
+    uint64_t pagetables = 0;
+    uint64_t percpu = 0;
+    uint64_t slab = 0;
+    uint64_t sock = 0;
+    uint64_t shmem = 0;
+    uint64_t fileMapped = 0;
+    uint64_t fileDirty = 0;
+    uint64_t swapcached = 0;
+    uint64_t pgfault = 0; // count
+    uint64_t pgmajfault = 0; // count
+    uint64_t workingsetRefaultAnon = 0; // count
+    uint64_t workingsetRefaultFile = 0; // count
+
+    // memory.events, counts
+    uint64_t eventLow = 0;
+    uint64_t eventHigh = 0;
+    uint64_t eventMax = 0;
+    uint64_t eventOom = 0;
+    uint64_t eventOomKill = 0;
+
+    // memory.pressure, percentages of time stalled and total stall time in us
+    double someAvg10 = 0;
+    double someAvg60 = 0;
+    double someAvg300 = 0;
+    uint64_t someTotal = 0;
+    double fullAvg10 = 0;
+    double fullAvg60 = 0;
+    double fullAvg300 = 0;
+    uint64_t fullTotal = 0;
+};
+
+// reads memory files of a cgroup, which are kept open between reads.
+// Read() parses them in place without allocation.
+class CgroupMemReader {
+public:
+    CgroupMemReader() = default;
+    ~CgroupMemReader();
+    CgroupMemReader(const CgroupMemReader &) = delete;
+    CgroupMemReader &operator=(const CgroupMemReader &) = delete;
+
+    // open memory files of the cgroup directory @path, false if it has no memory controller
+    bool Open(const std::string &path);
+    void Close();
+    bool Read(CgroupMemInfo &info) const;
+    const std::string &Path() const;
+
+private:
+    int currentFd_ = -1;
+    int statFd_ = -1;
+    int eventsFd_ = -1; // -1 if absent, the same below
+    int pressureFd_ = -1;
+    std::string path_;
+};
+
+// readers of a cgroup and all cgroups below it, to read a tree of app cgroups in one pass
+class CgroupMemTree {
+public:
+    // open cgroups at most @maxDepth levels below @root(0), return count opened
+    size_t Open(const std::string &root, int maxDepth);
+    void Close();
+
+    // read all cgroups opened, parents before children, and call @func for each one.
+    // @total sums sizes and event counts of cgroups at depth 1, i.e. all cgroups below @root.
+    // Return count read.
+    size_t ReadAll(const std::function<void(const std::string &path, int depth, const CgroupMemInfo &info)> &func,
+        CgroupMemInfo *total = nullptr) const;
+
+private:
+    void OpenDir(const std::string &path, int depth, int maxDepth);
+    struct Node {
+        std::unique_ptr<CgroupMemReader> reader;
+        int depth;
+    };
+    std::vector<Node> nodes_;
+};
+} /* namespace MemInfo */
+} /* namespace OHOS */
+#endif /* LIB_MEM_CGROUP_H */
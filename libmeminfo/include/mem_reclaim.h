@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_MEM_RECLAIM_H
+#define LIB_MEM_RECLAIM_H
+
+#include <cstdint>
+
+namespace OHOS {
+namespace MemInfo {
+struct ReclaimPolicy {
+    bool anon = true; // private anonymous memory, which is paged out to swap
+    bool file = true; // file-backed memory, which is dropped or written back
+    bool shmem = false; // shared memory like memfd and ashmem, which may be used by other processes
+    bool pageout = true; // true for MADV_PAGEOUT to reclaim now, false for MADV_COLD to reclaim first later
+};
+
+// in KB
+struct ReclaimResult {
+    uint64_t advised = 0; // resident memory of VMAs advised
+    uint64_t reclaimed = 0; // drop of resident memory of VMAs advised, by MADV_PAGEOUT only
+};
+
+// advise resident VMAs of @pid chosen by @policy by process_madvise(), by batches of VMAs.
+// Purgeable, locked and special VMAs are skipped. VMAs are advised by a pidfd opened first, and
+// read from smaps by pid, which is checked to be still the process of the pidfd after each read.
+// It needs the privilege to madvise other processes.
+// Return false if the process is not found, exits meanwhile or it can not be advised.
+bool ReclaimProcessMemory(const int pid, const ReclaimPolicy &policy, ReclaimResult &result);
+} /* namespace MemInfo */
+} /* namespace OHOS */
+#endif /* LIB_MEM_RECLAIM_H */
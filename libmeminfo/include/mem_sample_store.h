@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_MEM_SAMPLE_STORE_H
+#define LIB_MEM_SAMPLE_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OHOS {
+namespace MemInfo {
+// memory of a process at a time, sizes in KB as returned by libmeminfo
+struct MemSample {
+    uint64_t timestamp = 0; // ms, CLOCK_REALTIME if 0 when appended
+    int pid = 0;
+    uint64_t rss = 0;
+    uint64_t pss = 0;
+    uint64_t swapPss = 0;
+    uint64_t gl = 0;
+    uint64_t graph = 0;
+};
+
+// time series of MemSample in a memory-mapped circular file, the oldest samples are overwritten.
+// Each sample takes a 32-byte record, whose timestamp is the delta to the previous record.
+// Samples are in the page cache once appended, so the file keeps them if the writer dies.
+// One process appends, others may open the file read-only and query it meanwhile.
+class MemSampleStore {
+public:
+    MemSampleStore() = default;
+    ~MemSampleStore();
+    MemSampleStore(const MemSampleStore &) = delete;
+    MemSampleStore &operator=(const MemSampleStore &) = delete;
+
+    // open @path for append, samples in it are kept if it was created with the same @capacity
+    bool Open(const std::string &path, uint32_t capacity);
+
+    // open @path created by Open() to query only
+    bool OpenReadOnly(const std::string &path);
+    void Close();
+
+    // false if not opened for append, sizes over 4T KB are saturated
+    bool Append(const MemSample &sample);
+
+    // samples of @pid(all if -1) with timestamp in [begin, end], oldest first, return count found
+    size_t Query(const int pid, uint64_t begin, uint64_t end, std::vector<MemSample> &samples) const;
+
+    // count of samples stored
+    uint32_t Size() const;
+    uint32_t Capacity() const;
+
+private:
+    struct Header;
+    struct Record;
+    bool Map(int fd, size_t len, bool writable);
+    Header *header_ = nullptr;
+    Record *records_ = nullptr;
+    size_t mapLen_ = 0;
+    bool writable_ = false;
+};
+} /* namespace MemInfo */
+} /* namespace OHOS */
+#endif /* LIB_MEM_SAMPLE_STORE_H */
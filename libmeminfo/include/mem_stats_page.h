@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_MEM_STATS_PAGE_H
+#define LIB_MEM_STATS_PAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+/*
+ * Stats page: counters that a library publishes in a memfd of one page per process,
+ * so that libmeminfo reads them by a memory read instead of IPC.
+ * The writer keeps the memfd open, and the reader finds it by its name in /proc/pid/fd
+ * and maps it read-only. Each library publishes its own page, the reader sums them.
+ * Counters are updated under a seqlock: @seq is odd while a writer updates them,
+ * a reader retries if @seq is odd or changed during its copy.
+ * A child forked by the writer inherits the memfd and the mapping of its page, so writers
+ * re-create the page in the child by MemStatsPageRecreate() from a pthread_atfork handler.
+ * Readers count a page once by its inode and attribute it to @pid of the page.
+ * Later versions only append counters, readers check @size before reading them.
+ */
+#define MEM_STATS_PAGE_NAME "mem_stats_page"
+#define MEM_STATS_PAGE_MAGIC 0x4d535047U /* "MSPG" */
+#define MEM_STATS_PAGE_VERSION 1
+#define MEM_STATS_PAGE_LEN 4096
+
+enum MemStatsSource {
+    MEM_STATS_SOURCE_PURGEABLE = 1, /* libpurgeablemem */
+    MEM_STATS_SOURCE_DMABUF_HEAP = 2, /* libdmabufheap */
+};
+
+struct MemStatsCounters {
+    uint64_t purgeableBytes; /* bytes of purgeable objects, purged or not */
+    uint64_t purgeableBuilds; /* successful first builds of purgeable content */
+    uint64_t purgeableRebuilds; /* successful rebuilds after purge */
+    uint64_t purgeableBuildFails;
+    uint64_t dmabufBuffers; /* buffers allocated by libdmabufheap and not freed */
+    uint64_t dmabufBytes;
+    uint64_t purgeablePinnedBytes; /* bytes of purgeable objects pinned by readers or writers */
+    uint64_t purgeablePurgedBytes; /* bytes of purgeable objects known purged and not rebuilt yet */
+};
+
+struct MemStatsPage {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t source; /* enum MemStatsSource */
+    uint32_t size; /* bytes of counters valid in this page */
+    int32_t pid;
+    uint32_t seq;
+    uint32_t reserved;
+    struct MemStatsCounters counters;
+};
+
+/*
+ * MemStatsPageCreate: create and publish a page of this process, return NULL on failure.
+ * The memfd is kept open, by which the reader finds the page. It is returned in @fd
+ * if @fd is not NULL, or -1 on failure.
+ */
+static inline struct MemStatsPage *MemStatsPageCreate(enum MemStatsSource source, int *fd)
+{
+    if (fd != NULL) {
+        *fd = -1;
+    }
+    int memfd = (int)syscall(__NR_memfd_create, MEM_STATS_PAGE_NAME, 1U); /* MFD_CLOEXEC */
+    if (memfd < 0) {
+        return NULL;
+    }
+    if (ftruncate(memfd, MEM_STATS_PAGE_LEN) != 0) {
+        close(memfd);
+        return NULL;
+    }
+    void *addr = mmap(NULL, MEM_STATS_PAGE_LEN, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (addr == MAP_FAILED) {
+        close(memfd);
+        return NULL;
+    }
+    if (fd != NULL) {
+        *fd = memfd;
+    }
+    struct MemStatsPage *page = (struct MemStatsPage *)addr;
+    page->version = MEM_STATS_PAGE_VERSION;
+    page->source = (uint16_t)source;
+    page->size = (uint32_t)sizeof(struct MemStatsCounters);
+    page->pid = (int32_t)getpid();
+    __atomic_store_n(&page->magic, MEM_STATS_PAGE_MAGIC, __ATOMIC_RELEASE);
+    return page;
+}
+
+/*
+ * MemStatsPageRecreate: call in a child after fork, which inherits @page and its memfd @fd
+ * of the parent. Publish a new page of the child with the source of @page, and drop @page
+ * and @fd. Counters of the new page are 0, the caller sets those which the child inherits.
+ * Return:  the new page and its memfd in @fd, NULL and -1 on failure.
+ */
+static inline struct MemStatsPage *MemStatsPageRecreate(struct MemStatsPage *page, int *fd)
+{
+    enum MemStatsSource source = (enum MemStatsSource)page->source;
+    int oldFd = *fd;
+    munmap(page, MEM_STATS_PAGE_LEN);
+    if (oldFd >= 0) {
+        close(oldFd);
+    }
+    return MemStatsPageCreate(source, fd);
+}
+
+/* MemStatsPageWriteBegin: lock the page against other writers and make @seq odd */
+static inline void MemStatsPageWriteBegin(struct MemStatsPage *page)
+{
+    uint32_t seq = __atomic_load_n(&page->seq, __ATOMIC_RELAXED);
+    while ((seq & 1) != 0 ||
+        !__atomic_compare_exchange_n(&page->seq, &seq, seq + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        seq = __atomic_load_n(&page->seq, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void MemStatsPageWriteEnd(struct MemStatsPage *page)
+{
+    __atomic_add_fetch(&page->seq, 1, __ATOMIC_RELEASE);
+}
+
+/* MemStatsPageAdd: add @delta to the counter @field of @page, @delta may be negative */
+static inline void MemStatsPageAdd(struct MemStatsPage *page, uint64_t *field, int64_t delta)
+{
+    MemStatsPageWriteBegin(page);
+    __atomic_store_n(field, __atomic_load_n(field, __ATOMIC_RELAXED) + (uint64_t)delta, __ATOMIC_RELAXED);
+    MemStatsPageWriteEnd(page);
+}
+
+/*
+ * MemStatsPageRead: copy a consistent snapshot of counters of @page, which may be written
+ * by another process. Counters unknown to the page are 0 in @counters.
+ * Return:  false if @page is invalid or keeps being written after @maxTries.
+ */
+static inline bool MemStatsPageRead(const struct MemStatsPage *page, struct MemStatsCounters *counters,
+    unsigned int maxTries)
+{
+    if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != MEM_STATS_PAGE_MAGIC) {
+        return false;
+    }
+    size_t size = page->size < sizeof(*counters) ? page->size : sizeof(*counters);
+    size_t count = size / sizeof(uint64_t);
+    const uint64_t *src = (const uint64_t *)&page->counters;
+    uint64_t *dst = (uint64_t *)counters;
+    for (unsigned int i = 0; i < maxTries; i++) {
+        uint32_t seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        if ((seq & 1) != 0) {
+            continue;
+        }
+        memset(counters, 0, sizeof(*counters));
+        for (size_t j = 0; j < count; j++) {
+            dst[j] = __atomic_load_n(&src[j], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+#endif /* LIB_MEM_STATS_PAGE_H */
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_MEM_STATS_READER_H
+#define LIB_MEM_STATS_READER_H
+
+#include <sys/types.h>
+#include <vector>
+
+#include "mem_stats_page.h"
+
+namespace OHOS {
+namespace MemInfo {
+// get counters of all stats pages published by the process, false if it publishes none.
+// Pages which the process inherited from its parent by fork are not counted.
+bool GetMemStatsByPid(const int pid, MemStatsCounters &stats);
+
+// keeps stats pages of all processes mapped, so that reading them costs memory reads only
+class MemStatsReader {
+public:
+    MemStatsReader() = default;
+    ~MemStatsReader();
+    MemStatsReader(const MemStatsReader &) = delete;
+    MemStatsReader &operator=(const MemStatsReader &) = delete;
+
+    // map pages of new processes and unmap pages of exited ones, return count of pages mapped
+    size_t Refresh();
+
+    // sum counters of pages of @pid mapped by Refresh(), false if there is none
+    bool Read(const int pid, MemStatsCounters &stats) const;
+
+    // sum counters of all pages mapped by Refresh(), return count of pages read
+    size_t Aggregate(MemStatsCounters &total) const;
+
+    // pids of pages mapped by Refresh(), in ascending order
+    std::vector<int> GetPids() const;
+
+private:
+    struct Page {
+        int pid; // writer of the page, not a child which inherited it by fork
+        ino_t ino;
+        const MemStatsPage *addr;
+    };
+    std::vector<Page> pages_; // sorted by pid, one per inode
+};
+} /* namespace MemInfo */
+} /* namespace OHOS */
+#endif /* LIB_MEM_STATS_READER_H */
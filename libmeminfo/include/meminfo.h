@@ -21,6 +21,19 @@
 
 namespace OHOS {
 namespace MemInfo {
+// purgeable memory of a process, in KB
+struct PurgeableInfo {
+    uint64_t purgSum = 0; // resident purgeable memory, PurgSum of status
+    uint64_t purgPin = 0; // pinned part of purgSum, which cannot be reclaimed, PurgPin of status
+    uint64_t purged = 0; // purgeable memory already reclaimed, which has to be rebuilt before use
+
+    // memory reclaimable without killing the process
+    uint64_t Reclaimable() const
+    {
+        return purgSum > purgPin ? purgSum - purgPin : 0;
+    }
+};
+
 // get Rss from statm
 uint64_t GetRssByPid(const int pid);
 
@@ -30,6 +43,27 @@ uint64_t GetPssByPid(const int pid);
 // get SwapPss from smaps_rollup
 uint64_t GetSwapPssByPid(const int pid);
 
+// PSS estimated from sampled pages, in KB
+struct PssEstimate {
+    uint64_t pss = 0;
+    uint64_t low = 0; // 95% confidence interval of pss
+    uint64_t high = 0;
+    uint64_t pagesSampled = 0; // virtual pages whose pagemap entries are read
+    uint64_t pagesTotal = 0; // virtual pages of the process
+};
+
+// estimate Pss by mapcounts of a @fraction of pages from pagemap and kpagecount, without
+// walking all page tables as smaps_rollup does. @fraction is in (0, 1], 1 reads all pages.
+// It needs the privilege to read PFNs, false if not.
+bool EstimatePssByPid(const int pid, double fraction, PssEstimate &estimate);
+
+// get purgeable memory from status, or from the stats page of libpurgeablemem if the kernel
+// does not report it. purged is from the stats page only. Return false if neither has it.
+bool GetPurgeableMemInfo(const int pid, PurgeableInfo &info);
+
+// get purgeable memory reclaimable without kill by GetPurgeableMemInfo
+uint64_t GetPurgeableByPid(const int pid);
+
 // get graphics memory from hdi
 bool GetGraphicsMemory(const int pid, uint64_t &gl, uint64_t &graph);
 } /* namespace MemInfo */
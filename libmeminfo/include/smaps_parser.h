@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_SMAPS_PARSER_H
+#define LIB_SMAPS_PARSER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace OHOS {
+namespace MemInfo {
+// a VMA of smaps, sizes in KB
+struct SmapsVma {
+    uint64_t start = 0;
+    uint64_t end = 0;
+    char perms[5] = {0}; // like "rw-p"
+    uint64_t offset = 0;
+    uint64_t inode = 0;
+    std::string name; // path or like "[heap]", "[anon:libc_malloc]", empty for anonymous
+    uint64_t rss = 0;
+    uint64_t pss = 0;
+    uint64_t sharedClean = 0;
+    uint64_t sharedDirty = 0;
+    uint64_t privateClean = 0;
+    uint64_t privateDirty = 0;
+    uint64_t anonymous = 0;
+    uint64_t swap = 0;
+    uint64_t swapPss = 0;
+    std::string vmFlags; // two-letter flags like "rd wr mr mw me ac"
+
+    // @flag is a two-letter flag of VmFlags, like "lo"
+    bool HasVmFlag(const char *flag) const;
+
+    // backed by a regular file, false for anonymous and shared memory like memfd and ashmem
+    bool IsFileBacked() const;
+
+    // memory of libpurgeablemem or of VM_PURGEABLE, reclaimed by the kernel when unpinned
+    bool IsPurgeable() const;
+};
+
+// call @func for each VMA of smaps at @path, in ascending address order. @vma is reused,
+// copy it to keep. Return false if the file can not be read.
+bool ParseSmaps(const std::string &path, const std::function<void(const SmapsVma &vma)> &func);
+
+// ParseSmaps of /proc/@pid/smaps
+bool ParseSmapsByPid(const int pid, const std::function<void(const SmapsVma &vma)> &func);
+} /* namespace MemInfo */
+} /* namespace OHOS */
+#endif /* LIB_SMAPS_PARSER_H */
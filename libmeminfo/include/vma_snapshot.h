@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_VMA_SNAPSHOT_H
+#define LIB_VMA_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace MemInfo {
+// interned VMA names, shared by snapshots of all processes so that each name is stored once
+class VmaNameTable {
+public:
+    static constexpr uint32_t ANON_ID = 0; // VMAs without name
+
+    VmaNameTable();
+    uint32_t Intern(const std::string &name);
+    const std::string &Name(uint32_t id) const;
+    size_t Size() const;
+
+private:
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<const std::string *> names_; // keys of ids_, by id
+};
+
+// a VMA in a snapshot, sizes in KB saturated at 4T KB
+struct VmaRecord {
+    uint64_t start;
+    uint64_t end;
+    uint32_t nameId;
+    uint32_t rss;
+    uint32_t pss;
+    uint32_t swap;
+};
+
+// VMAs of a process at a time, 32 bytes per VMA in one array sorted by start
+class VmaSnapshot {
+public:
+    // read smaps of @pid, return false if it can not be read
+    bool Capture(const int pid, VmaNameTable &names);
+    const std::vector<VmaRecord> &Records() const;
+    uint64_t TotalPss() const;
+
+private:
+    std::vector<VmaRecord> records_;
+};
+
+// change of a VMA or a category between two snapshots, in KB
+struct VmaGrowth {
+    uint64_t start = 0; // of the newer VMA, or the older one if it is gone, 0 for a category
+    uint64_t end = 0;
+    uint32_t nameId = VmaNameTable::ANON_ID;
+    int64_t rss = 0;
+    int64_t pss = 0;
+    int64_t swap = 0;
+};
+
+struct VmaDiff {
+    std::vector<VmaGrowth> mappings; // the most growing VMAs, by pss + swap descending
+    std::vector<VmaGrowth> categories; // the most growing names, by pss + swap descending
+    VmaGrowth total;
+};
+
+// diff @newer against @older by a merge walk over VMAs, VMAs match if both start and name are equal.
+// VMAs which only grew in size, like heap, match. Only growing entries are reported, at most @top.
+void DiffVmaSnapshots(const VmaSnapshot &older, const VmaSnapshot &newer, size_t top, VmaDiff &diff);
+} /* namespace MemInfo */
+} /* namespace OHOS */
+#endif /* LIB_VMA_SNAPSHOT_H */
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mem_cgroup.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "hilog/log.h"
+
+#undef LOG_TAG
+#define LOG_TAG "MemInfo"
+
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD001799
+
+namespace OHOS {
+namespace MemInfo {
+namespace {
+constexpr size_t READ_BUF_LEN = 8192; // memory.stat is about 1.5K
+constexpr uint64_t BYTE_PER_KB = 1024;
+constexpr int BASE_DEC = 10;
+
+struct CgroupField {
+    const char *key;
+    size_t keyLen;
+    uint64_t CgroupMemInfo::*value;
+    bool bytes; // converted to KB
+};
+
+#define CGROUP_FIELD(key, member, bytes) { key, sizeof(key) - 1, &CgroupMemInfo::member, bytes }
+const CgroupField STAT_FIELDS[] = {
+    CGROUP_FIELD("anon", anon, true),
+    CGROUP_FIELD("file", file, true),
+    CGROUP_FIELD("kernel", kernel, true),
+    CGROUP_FIELD("kernel_stack", kernelStack, true),
+    CGROUP_FIELD("pagetables", pagetables, true),
+    CGROUP_FIELD("percpu", percpu, true),
+    CGROUP_FIELD("slab", slab, true),
+    CGROUP_FIELD("sock", sock, true),
+    CGROUP_FIELD("shmem", shmem, true),
+    CGROUP_FIELD("file_mapped", fileMapped, true),
+    CGROUP_FIELD("file_dirty", fileDirty, true),
+    CGROUP_FIELD("swapcached", swapcached, true),
+    CGROUP_FIELD("pgfault", pgfault, false),
+    CGROUP_FIELD("pgmajfault", pgmajfault, false),
+    CGROUP_FIELD("workingset_refault_anon", workingsetRefaultAnon, false),
+    CGROUP_FIELD("workingset_refault_file", workingsetRefaultFile, false),
+};
+
+const CgroupField EVENT_FIELDS[] = {
+    CGROUP_FIELD("low", eventLow, false),
+    CGROUP_FIELD("high", eventHigh, false),
+    CGROUP_FIELD("max", eventMax, false),
+    CGROUP_FIELD("oom", eventOom, false),
+    CGROUP_FIELD("oom_kill", eventOomKill, false),
+};
+#undef CGROUP_FIELD
+
+// fields summed by CgroupMemTree, pressure is not additive
+uint64_t CgroupMemInfo::*const SUM_FIELDS[] = {
+    &CgroupMemInfo::current, &CgroupMemInfo::anon, &CgroupMemInfo::file, &CgroupMemInfo::kernel,
+    &CgroupMemInfo::kernelStack, &CgroupMemInfo::pagetables, &CgroupMemInfo::percpu, &CgroupMemInfo::slab,
+    &CgroupMemInfo::sock, &CgroupMemInfo::shmem, &CgroupMemInfo::fileMapped, &CgroupMemInfo::fileDirty,
+    &CgroupMemInfo::swapcached, &CgroupMemInfo::pgfault, &CgroupMemInfo::pgmajfault,
+    &CgroupMemInfo::workingsetRefaultAnon, &CgroupMemInfo::workingsetRefaultFile, &CgroupMemInfo::eventLow,
+    &CgroupMemInfo::eventHigh, &CgroupMemInfo::eventMax, &CgroupMemInfo::eventOom, &CgroupMemInfo::eventOomKill,
+};
+
+// read the whole file from its start into @buf as a string, return its length or -1
+ssize_t ReadFd(int fd, char *buf, size_t size)
+{
+    ssize_t len = pread(fd, buf, size - 1, 0);
+    if (len < 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+int OpenFile(const std::string &dir, const char *name)
+{
+    return open((dir + "/" + name).c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+// parse lines of "key value" by @fields, format like:
+// anon 1048576
+// file 2097152
+template <size_t N>
+bool ParseKeyValues(char *buf, const CgroupField (&fields)[N], CgroupMemInfo &info)
+{
+    bool hasKernel = false;
+    for (char *line = buf; *line != '\0';) {
+        char *next = strchr(line, '\n');
+        next = next != nullptr ? next + 1 : line + strlen(line);
+        for (const auto &field : fields) {
+            if (strncmp(line, field.key, field.keyLen) == 0 && line[field.keyLen] == ' ') {
+                uint64_t value = strtoull(line + field.keyLen + 1, nullptr, BASE_DEC);
+                info.*(field.value) = field.bytes ? value / BYTE_PER_KB : value;
+                hasKernel = hasKernel || field.value == &CgroupMemInfo::kernel;
+                break;
+            }
+        }
+        line = next;
+    }
+    return hasKernel;
+}
+
+// format like:
+// some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+// full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+void ParsePressure(const char *buf, CgroupMemInfo &info)
+{
+    const char *some = strstr(buf, "some ");
+    if (some != nullptr) {
+        sscanf(some, "some avg10=%lf avg60=%lf avg300=%lf total=%" SCNu64, &info.someAvg10, &info.someAvg60,
+            &info.someAvg300, &info.someTotal);
+    }
+    const char *full = strstr(buf, "full ");
+    if (full != nullptr) {
+        sscanf(full, "full avg10=%lf avg60=%lf avg300=%lf total=%" SCNu64, &info.fullAvg10, &info.fullAvg60,
+            &info.fullAvg300, &info.fullTotal);
+    }
+}
+
+void CloseFd(int &fd)
+{
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+} /* namespace */
+
+CgroupMemReader::~CgroupMemReader()
+{
+    Close();
+}
+
+bool CgroupMemReader::Open(const std::string &path)
+{
+    Close();
+    currentFd_ = OpenFile(path, "memory.current");
+    statFd_ = OpenFile(path, "memory.stat");
+    if (currentFd_ < 0 || statFd_ < 0) {
+        HILOG_DEBUG(LOG_CORE, "no memory controller in %{public}s", path.c_str());
+        Close();
+        return false;
+    }
+    eventsFd_ = OpenFile(path, "memory.events");
+    pressureFd_ = OpenFile(path, "memory.pressure");
+    path_ = path;
+    return true;
+}
+
+void CgroupMemReader::Close()
+{
+    CloseFd(currentFd_);
+    CloseFd(statFd_);
+    CloseFd(eventsFd_);
+    CloseFd(pressureFd_);
+    path_.clear();
+}
+
+bool CgroupMemReader::Read(CgroupMemInfo &info) const
+{
+    info = CgroupMemInfo();
+    if (currentFd_ < 0) {
+        return false;
+    }
+    char buf[READ_BUF_LEN];
+    if (ReadFd(currentFd_, buf, sizeof(buf)) < 0) {
+        HILOG_ERROR(LOG_CORE, "read memory.current of %{public}s failed.", path_.c_str());
+        return false;
+    }
+    info.current = strtoull(buf, nullptr, BASE_DEC) / BYTE_PER_KB;
+    if (ReadFd(statFd_, buf, sizeof(buf)) < 0) {
+        HILOG_ERROR(LOG_CORE, "read memory.stat of %{public}s failed.", path_.c_str());
+        return false;
+    }
+    if (!ParseKeyValues(buf, STAT_FIELDS, info)) {
+        info.kernel = info.kernelStack + info.pagetables + info.percpu + info.slab + info.sock;
+    }
+    if (eventsFd_ >= 0 && ReadFd(eventsFd_, buf, sizeof(buf)) >= 0) {
+        ParseKeyValues(buf, EVENT_FIELDS, info);
+    }
+    if (pressureFd_ >= 0 && ReadFd(pressureFd_, buf, sizeof(buf)) >= 0) {
+        ParsePressure(buf, info);
+    }
+    return true;
+}
+
+const std::string &CgroupMemReader::Path() const
+{
+    return path_;
+}
+
+size_t CgroupMemTree::Open(const std::string &root, int maxDepth)
+{
+    Close();
+    OpenDir(root, 0, maxDepth);
+    return nodes_.size();
+}
+
+void CgroupMemTree::OpenDir(const std::string &path, int depth, int maxDepth)
+{
+    auto reader = std::make_unique<CgroupMemReader>();
+    if (reader->Open(path)) {
+        nodes_.push_back({ std::move(reader), depth });
+    }
+    if (depth >= maxDepth) {
+        return;
+    }
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        HILOG_ERROR(LOG_CORE, "open %{public}s failed.", path.c_str());
+        return;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        if (ent->d_type == DT_DIR && ent->d_name[0] != '.') {
+            OpenDir(path + "/" + ent->d_name, depth + 1, maxDepth);
+        }
+    }
+    closedir(dir);
+}
+
+void CgroupMemTree::Close()
+{
+    nodes_.clear();
+}
+
+size_t CgroupMemTree::ReadAll(
+    const std::function<void(const std::string &path, int depth, const CgroupMemInfo &info)> &func,
+    CgroupMemInfo *total) const
+{
+    if (total != nullptr) {
+        *total = CgroupMemInfo();
+    }
+    size_t count = 0;
+    CgroupMemInfo info;
+    for (const auto &node : nodes_) {
+        if (!node.reader->Read(info)) {
+            continue;
+        }
+        count++;
+        if (total != nullptr && node.depth == 1) {
+            for (const auto field : SUM_FIELDS) {
+                (*total).*field += info.*field;
+            }
+        }
+        if (func) {
+            func(node.reader->Path(), node.depth, info);
+        }
+    }
+    return count;
+}
+} /* namespace MemInfo */
+} /* namespace OHOS */
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mem_reclaim.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits> /* INT_MAX */
+#include <cstring>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "hilog/log.h"
+#include "smaps_parser.h"
+
+#undef LOG_TAG
+#define LOG_TAG "MemInfo"
+
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD001799
+
+#ifndef __NR_pidfd_send_signal
+#define __NR_pidfd_send_signal 424 /* linux 5.1 */
+#endif
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434 /* linux 5.3 */
+#endif
+#ifndef __NR_process_madvise
+#define __NR_process_madvise 440 /* linux 5.10 */
+#endif
+#ifndef MADV_COLD
+#define MADV_COLD 20
+#endif
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT 21
+#endif
+
+namespace OHOS {
+namespace MemInfo {
+namespace {
+constexpr size_t MAX_IOVECS = 1024; // UIO_MAXIOV
+
+struct ReclaimVma {
+    uint64_t start;
+    uint64_t end;
+    uint64_t rss;
+};
+
+bool ShouldReclaim(const SmapsVma &vma, const ReclaimPolicy &policy)
+{
+    if (vma.rss == 0 || vma.IsPurgeable()) {
+        return false;
+    }
+    // locked, io, pfn-mapped VMAs and vdso-like ones can not be paged out
+    if (vma.HasVmFlag("lo") || vma.HasVmFlag("io") || vma.HasVmFlag("pf") ||
+        vma.name.compare(0, strlen("[v"), "[v") == 0) {
+        return false;
+    }
+    if (vma.IsFileBacked()) {
+        return policy.file;
+    }
+    if (vma.inode != 0 || vma.HasVmFlag("sh")) {
+        return policy.shmem;
+    }
+    return policy.anon;
+}
+
+bool CollectVmas(const int pid, const ReclaimPolicy &policy, std::vector<ReclaimVma> &vmas)
+{
+    return ParseSmapsByPid(pid, [&policy, &vmas](const SmapsVma &vma) {
+        if (ShouldReclaim(vma, policy)) {
+            vmas.push_back({ vma.start, vma.end, vma.rss });
+        }
+    });
+}
+
+// whether the process of @pidfd is alive, so that its pid still refers to it
+bool IsAlive(int pidfd)
+{
+    return syscall(__NR_pidfd_send_signal, pidfd, 0, nullptr, 0) == 0 || errno != ESRCH;
+}
+
+// bytes advised by one process_madvise() at most: MAX_RW_COUNT, INT_MAX rounded down to pages
+size_t MaxAdviseBytes()
+{
+    static const size_t maxBytes = static_cast<size_t>(INT_MAX) & ~(static_cast<size_t>(getpagesize()) - 1);
+    return maxBytes;
+}
+
+// ranges of @vmas, a VMA larger than MaxAdviseBytes() is split
+std::vector<struct iovec> SplitRanges(const std::vector<ReclaimVma> &vmas)
+{
+    const uint64_t maxBytes = MaxAdviseBytes();
+    std::vector<struct iovec> ranges;
+    ranges.reserve(vmas.size());
+    for (const auto &vma : vmas) {
+        for (uint64_t start = vma.start; start < vma.end; start += maxBytes) {
+            ranges.push_back({ reinterpret_cast<void *>(start), std::min(vma.end - start, maxBytes) });
+        }
+    }
+    return ranges;
+}
+
+// advise @ranges by batches of at most MAX_IOVECS ranges and MaxAdviseBytes() bytes, as the kernel
+// truncates a longer batch. A range which fails is skipped. Return false if the process can not be advised.
+bool Advise(int pidfd, std::vector<struct iovec> &ranges, int advice)
+{
+    const size_t maxBytes = MaxAdviseBytes();
+    size_t next = 0;
+    while (next < ranges.size()) {
+        size_t batchEnd = next;
+        size_t batchBytes = 0;
+        while (batchEnd < ranges.size() && batchEnd - next < MAX_IOVECS &&
+            batchBytes + ranges[batchEnd].iov_len <= maxBytes) {
+            batchBytes += ranges[batchEnd].iov_len;
+            batchEnd++;
+        }
+        ssize_t ret = syscall(__NR_process_madvise, pidfd, &ranges[next], batchEnd - next, advice, 0);
+        if (ret < 0 && (errno == ESRCH || errno == ENOSYS || errno == EPERM)) {
+            HILOG_ERROR(LOG_CORE, "process_madvise failed, errno = %{public}d.", errno);
+            return false;
+        }
+        // a batch stops at the first range which fails, e.g. unmapped meanwhile. Ranges before it
+        // are done, and the range at the cut-off is continued if partly advised, or skipped.
+        size_t advised = ret < 0 ? 0 : static_cast<size_t>(ret);
+        while (next < batchEnd && advised >= ranges[next].iov_len) {
+            advised -= ranges[next].iov_len;
+            next++;
+        }
+        if (next == batchEnd) {
+            continue;
+        }
+        if (advised > 0) {
+            ranges[next].iov_base = static_cast<char *>(ranges[next].iov_base) + advised;
+            ranges[next].iov_len -= advised;
+        } else {
+            next++;
+        }
+    }
+    return true;
+}
+} /* namespace */
+
+bool ReclaimProcessMemory(const int pid, const ReclaimPolicy &policy, ReclaimResult &result)
+{
+    result = ReclaimResult();
+    int pidfd = static_cast<int>(syscall(__NR_pidfd_open, pid, 0));
+    if (pidfd < 0) {
+        HILOG_ERROR(LOG_CORE, "pidfd_open %{public}d failed, errno = %{public}d.", pid, errno);
+        return false;
+    }
+    // smaps is read by pid, which refers to the process of @pidfd only while that one is alive
+    std::vector<ReclaimVma> vmas;
+    if (!CollectVmas(pid, policy, vmas) || !IsAlive(pidfd)) {
+        close(pidfd);
+        return false;
+    }
+    for (const auto &vma : vmas) {
+        result.advised += vma.rss;
+    }
+    std::vector<struct iovec> ranges = SplitRanges(vmas);
+    bool ret = Advise(pidfd, ranges, policy.pageout ? MADV_PAGEOUT : MADV_COLD);
+    if (!ret || !policy.pageout) {
+        close(pidfd);
+        return ret;
+    }
+
+    // match VMAs of both reads by start, VMAs gone meanwhile count as reclaimed
+    uint64_t rss = 0;
+    ParseSmapsByPid(pid, [&vmas, &rss](const SmapsVma &vma) {
+        auto it = std::lower_bound(vmas.begin(), vmas.end(), vma.start,
+            [](const ReclaimVma &reclaimVma, uint64_t start) { return reclaimVma.start < start; });
+        if (it != vmas.end() && it->start == vma.start) {
+            rss += vma.rss;
+        }
+    });
+    bool alive = IsAlive(pidfd);
+    close(pidfd);
+    if (!alive) {
+        return false;
+    }
+    result.reclaimed = result.advised > rss ? result.advised - rss : 0;
+    return true;
+}
+} /* namespace MemInfo */
+} /* namespace OHOS */
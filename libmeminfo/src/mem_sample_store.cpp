@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mem_sample_store.h"
+
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hilog/log.h"
+
+#undef LOG_TAG
+#define LOG_TAG "MemInfo"
+
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD001799
+
+namespace OHOS {
+namespace MemInfo {
+// file layout: Header, padded to HEADER_LEN, then @capacity Records
+struct MemSampleStore::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t seq; // odd while a record is appended
+    uint32_t head; // slot of the next record, which is the oldest one if full
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t baseTime; // timestamp of the oldest record minus its delta
+    uint64_t lastTime; // timestamp of the newest record
+};
+
+struct MemSampleStore::Record {
+    uint32_t delta; // ms since the previous record
+    int32_t pid;
+    uint32_t rss;
+    uint32_t pss;
+    uint32_t swapPss;
+    uint32_t gl;
+    uint32_t graph;
+    uint32_t reserved;
+};
+
+namespace {
+constexpr uint32_t STORE_MAGIC = 0x4d535354; // "MSST"
+constexpr uint32_t STORE_VERSION = 1;
+constexpr size_t HEADER_LEN = 64;
+constexpr size_t RECORD_LEN = 32;
+constexpr unsigned int READ_TRIES = 64;
+constexpr uint64_t MS_PER_SECOND = 1000;
+constexpr uint64_t NS_PER_MS = 1000000;
+
+uint64_t NowMs()
+{
+    struct timespec ts = {0, 0};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * MS_PER_SECOND + static_cast<uint64_t>(ts.tv_nsec) / NS_PER_MS;
+}
+
+uint32_t Saturate(uint64_t value)
+{
+    return value > std::numeric_limits<uint32_t>::max() ? std::numeric_limits<uint32_t>::max() :
+        static_cast<uint32_t>(value);
+}
+
+template <typename T>
+T Load(const T &field)
+{
+    return __atomic_load_n(&field, __ATOMIC_RELAXED);
+}
+
+template <typename T>
+void Store(T &field, T value)
+{
+    __atomic_store_n(&field, value, __ATOMIC_RELAXED);
+}
+} /* namespace */
+
+MemSampleStore::~MemSampleStore()
+{
+    Close();
+}
+
+bool MemSampleStore::Map(int fd, size_t len, bool writable)
+{
+    int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void *addr = mmap(nullptr, len, prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        HILOG_ERROR(LOG_CORE, "mmap sample store failed.");
+        return false;
+    }
+    header_ = static_cast<Header *>(addr);
+    records_ = reinterpret_cast<Record *>(static_cast<char *>(addr) + HEADER_LEN);
+    mapLen_ = len;
+    writable_ = writable;
+    return true;
+}
+
+bool MemSampleStore::Open(const std::string &path, uint32_t capacity)
+{
+    static_assert(sizeof(Header) <= HEADER_LEN, "header exceeds its space");
+    static_assert(sizeof(Record) == RECORD_LEN, "record size is a part of the format");
+    Close();
+    if (capacity == 0) {
+        HILOG_ERROR(LOG_CORE, "sample store capacity is 0.");
+        return false;
+    }
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP);
+    if (fd < 0) {
+        HILOG_ERROR(LOG_CORE, "open %{public}s failed.", path.c_str());
+        return false;
+    }
+    size_t len = HEADER_LEN + static_cast<size_t>(capacity) * RECORD_LEN;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (static_cast<size_t>(st.st_size) != len && ftruncate(fd, len) != 0)) {
+        HILOG_ERROR(LOG_CORE, "resize %{public}s failed.", path.c_str());
+        close(fd);
+        return false;
+    }
+    if (!Map(fd, len, true)) {
+        return false;
+    }
+    if (header_->magic != STORE_MAGIC || header_->version != STORE_VERSION ||
+        header_->recordSize != RECORD_LEN || header_->capacity != capacity || header_->head >= capacity ||
+        header_->count > capacity) {
+        memset(header_, 0, HEADER_LEN);
+        header_->version = STORE_VERSION;
+        header_->recordSize = RECORD_LEN;
+        header_->capacity = capacity;
+        __atomic_store_n(&header_->magic, STORE_MAGIC, __ATOMIC_RELEASE);
+    } else if ((header_->seq & 1) != 0) {
+        // the last writer died while appending, its record may be torn
+        HILOG_WARN(LOG_CORE, "%{public}s was not closed cleanly.", path.c_str());
+        header_->seq++;
+    }
+    return true;
+}
+
+bool MemSampleStore::OpenReadOnly(const std::string &path)
+{
+    Close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        HILOG_ERROR(LOG_CORE, "open %{public}s failed.", path.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_LEN + RECORD_LEN) {
+        HILOG_ERROR(LOG_CORE, "%{public}s is not a sample store.", path.c_str());
+        close(fd);
+        return false;
+    }
+    if (!Map(fd, st.st_size, false)) {
+        return false;
+    }
+    if (__atomic_load_n(&header_->magic, __ATOMIC_ACQUIRE) != STORE_MAGIC || header_->version != STORE_VERSION ||
+        header_->recordSize != RECORD_LEN ||
+        HEADER_LEN + static_cast<size_t>(header_->capacity) * RECORD_LEN != mapLen_) {
+        HILOG_ERROR(LOG_CORE, "%{public}s is not a sample store.", path.c_str());
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MemSampleStore::Close()
+{
+    if (header_ != nullptr) {
+        munmap(header_, mapLen_);
+    }
+    header_ = nullptr;
+    records_ = nullptr;
+    mapLen_ = 0;
+    writable_ = false;
+}
+
+bool MemSampleStore::Append(const MemSample &sample)
+{
+    if (!writable_) {
+        return false;
+    }
+    uint64_t now = sample.timestamp != 0 ? sample.timestamp : NowMs();
+    Header &header = *header_;
+    uint32_t seq = header.seq;
+    Store(header.seq, seq + 1);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint32_t head = header.head;
+    uint32_t count = header.count;
+    uint32_t delta = 0;
+    if (count == 0) {
+        Store(header.baseTime, now);
+    } else {
+        // a clock going back is stored as no time passed
+        delta = Saturate(now > header.lastTime ? now - header.lastTime : 0);
+        if (count == header.capacity) {
+            Store(header.baseTime, header.baseTime + records_[head].delta);
+        }
+    }
+    Record &record = records_[head];
+    Store(record.delta, delta);
+    Store(record.pid, static_cast<int32_t>(sample.pid));
+    Store(record.rss, Saturate(sample.rss));
+    Store(record.pss, Saturate(sample.pss));
+    Store(record.swapPss, Saturate(sample.swapPss));
+    Store(record.gl, Saturate(sample.gl));
+    Store(record.graph, Saturate(sample.graph));
+    Store(header.lastTime, count == 0 ? now : header.lastTime + delta);
+    Store(header.head, head + 1 == header.capacity ? 0 : head + 1);
+    if (count < header.capacity) {
+        Store(header.count, count + 1);
+    }
+
+    __atomic_store_n(&header.seq, seq + 2, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t MemSampleStore::Query(const int pid, uint64_t begin, uint64_t end, std::vector<MemSample> &samples) const
+{
+    samples.clear();
+    if (header_ == nullptr || begin > end) {
+        return 0;
+    }
+    uint32_t capacity = header_->capacity;
+    for (unsigned int tries = 0; tries < READ_TRIES; tries++) {
+        uint32_t seq = __atomic_load_n(&header_->seq, __ATOMIC_ACQUIRE);
+        if ((seq & 1) != 0) {
+            continue;
+        }
+        samples.clear();
+        uint32_t count = Load(header_->count);
+        uint32_t index = (Load(header_->head) + capacity - count % capacity) % capacity;
+        uint64_t time = Load(header_->baseTime);
+        for (uint32_t i = 0; i < count; i++) {
+            const Record &record = records_[index];
+            index = index + 1 == capacity ? 0 : index + 1;
+            time += Load(record.delta);
+            if (time > end) {
+                break;
+            }
+            int32_t recordPid = Load(record.pid);
+            if (time < begin || (pid != -1 && recordPid != pid)) {
+                continue;
+            }
+            MemSample sample;
+            sample.timestamp = time;
+            sample.pid = recordPid;
+            sample.rss = Load(record.rss);
+            sample.pss = Load(record.pss);
+            sample.swapPss = Load(record.swapPss);
+            sample.gl = Load(record.gl);
+            sample.graph = Load(record.graph);
+            samples.push_back(sample);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (Load(header_->seq) == seq) {
+            return samples.size();
+        }
+    }
+    HILOG_ERROR(LOG_CORE, "sample store keeps changing while queried.");
+    samples.clear();
+    return 0;
+}
+
+uint32_t MemSampleStore::Size() const
+{
+    return header_ != nullptr ? Load(header_->count) : 0;
+}
+
+uint32_t MemSampleStore::Capacity() const
+{
+    return header_ != nullptr ? header_->capacity : 0;
+}
+} /* namespace MemInfo */
+} /* namespace OHOS */
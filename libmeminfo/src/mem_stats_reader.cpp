@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mem_stats_reader.h"
+
+#include <algorithm>
+#include <climits> /* PATH_MAX */
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+#include "hilog/log.h"
+
+#undef LOG_TAG
+#define LOG_TAG "MemInfo"
+
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD001799
+
+namespace OHOS {
+namespace MemInfo {
+namespace {
+constexpr unsigned int READ_TRIES = 64;
+const std::string PAGE_LINK = std::string("/memfd:") + MEM_STATS_PAGE_NAME;
+
+void AddCounters(MemStatsCounters &total, const MemStatsCounters &counters)
+{
+    uint64_t *dst = reinterpret_cast<uint64_t *>(&total);
+    const uint64_t *src = reinterpret_cast<const uint64_t *>(&counters);
+    for (size_t i = 0; i < sizeof(MemStatsCounters) / sizeof(uint64_t); i++) {
+        dst[i] += src[i];
+    }
+}
+
+bool ParsePid(const char *name, int &pid)
+{
+    char *end = nullptr;
+    const int base = 10;
+    long value = strtol(name, &end, base);
+    if (end == name || *end != '\0' || value <= 0) {
+        return false;
+    }
+    pid = static_cast<int>(value);
+    return true;
+}
+
+// call @func(path, ino) for each fd of @pid linked to a stats page
+template <typename Func>
+void ForEachPageFd(const int pid, Func &&func)
+{
+    std::string fdDir = "/proc/" + std::to_string(pid) + "/fd";
+    DIR *dir = opendir(fdDir.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent *ent;
+    char link[PATH_MAX];
+    while ((ent = readdir(dir)) != nullptr) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        std::string path = fdDir + "/" + ent->d_name;
+        ssize_t len = readlink(path.c_str(), link, sizeof(link) - 1);
+        if (len <= 0) {
+            continue;
+        }
+        link[len] = '\0';
+        // format like: /memfd:mem_stats_page (deleted)
+        if (strncmp(link, PAGE_LINK.c_str(), PAGE_LINK.size()) != 0 ||
+            (link[PAGE_LINK.size()] != '\0' && link[PAGE_LINK.size()] != ' ')) {
+            continue;
+        }
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            continue;
+        }
+        func(path, st.st_ino);
+    }
+    closedir(dir);
+}
+
+const MemStatsPage *MapPage(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        HILOG_ERROR(LOG_CORE, "open %{public}s failed.", path.c_str());
+        return nullptr;
+    }
+    void *addr = mmap(nullptr, MEM_STATS_PAGE_LEN, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        HILOG_ERROR(LOG_CORE, "mmap %{public}s failed.", path.c_str());
+        return nullptr;
+    }
+    return static_cast<const MemStatsPage *>(addr);
+}
+
+void UnmapPage(const MemStatsPage *addr)
+{
+    munmap(const_cast<MemStatsPage *>(addr), MEM_STATS_PAGE_LEN);
+}
+
+// pid of the writer of @addr, false if the page is not published yet
+bool GetPageOwner(const MemStatsPage *addr, int &pid)
+{
+    if (__atomic_load_n(&addr->magic, __ATOMIC_ACQUIRE) != MEM_STATS_PAGE_MAGIC) {
+        return false;
+    }
+    pid = addr->pid;
+    return true;
+}
+} /* namespace */
+
+bool GetMemStatsByPid(const int pid, MemStatsCounters &stats)
+{
+    stats = MemStatsCounters();
+    bool found = false;
+    std::unordered_set<ino_t> seen;
+    ForEachPageFd(pid, [pid, &stats, &found, &seen](const std::string &path, ino_t ino) {
+        if (!seen.insert(ino).second) {
+            return;
+        }
+        const MemStatsPage *addr = MapPage(path);
+        if (addr == nullptr) {
+            return;
+        }
+        // a page inherited from the parent by fork is not counted for the child
+        int owner = 0;
+        MemStatsCounters counters;
+        if (GetPageOwner(addr, owner) && owner == pid && MemStatsPageRead(addr, &counters, READ_TRIES)) {
+            AddCounters(stats, counters);
+            found = true;
+        }
+        UnmapPage(addr);
+    });
+    return found;
+}
+
+MemStatsReader::~MemStatsReader()
+{
+    for (const auto &page : pages_) {
+        UnmapPage(page.addr);
+    }
+}
+
+size_t MemStatsReader::Refresh()
+{
+    DIR *dir = opendir("/proc");
+    if (dir == nullptr) {
+        HILOG_ERROR(LOG_CORE, "open /proc failed.");
+        return pages_.size();
+    }
+    std::vector<Page> oldPages;
+    oldPages.swap(pages_);
+    std::sort(oldPages.begin(), oldPages.end(), [](const Page &a, const Page &b) { return a.ino < b.ino; });
+    std::vector<bool> kept(oldPages.size(), false);
+    // a child forked without re-creating the page shares it with its parent, map it once
+    std::unordered_set<ino_t> seen;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        int pid = 0;
+        if (!ParsePid(ent->d_name, pid)) {
+            continue;
+        }
+        ForEachPageFd(pid, [this, &oldPages, &kept, &seen](const std::string &path, ino_t ino) {
+            if (!seen.insert(ino).second) {
+                return;
+            }
+            auto it = std::lower_bound(oldPages.begin(), oldPages.end(), ino,
+                [](const Page &page, ino_t value) { return page.ino < value; });
+            if (it != oldPages.end() && it->ino == ino) {
+                kept[it - oldPages.begin()] = true;
+                pages_.push_back(*it);
+                return;
+            }
+            const MemStatsPage *addr = MapPage(path);
+            if (addr == nullptr) {
+                return;
+            }
+            int owner = 0;
+            if (!GetPageOwner(addr, owner)) {
+                UnmapPage(addr);
+                return;
+            }
+            pages_.push_back({ owner, ino, addr });
+        });
+    }
+    closedir(dir);
+    for (size_t i = 0; i < oldPages.size(); i++) {
+        if (!kept[i]) {
+            UnmapPage(oldPages[i].addr);
+        }
+    }
+    std::sort(pages_.begin(), pages_.end(), [](const Page &a, const Page &b) { return a.pid < b.pid; });
+    return pages_.size();
+}
+
+bool MemStatsReader::Read(const int pid, MemStatsCounters &stats) const
+{
+    stats = MemStatsCounters();
+    bool found = false;
+    auto it = std::lower_bound(pages_.begin(), pages_.end(), pid,
+        [](const Page &page, int value) { return page.pid < value; });
+    for (; it != pages_.end() && it->pid == pid; ++it) {
+        MemStatsCounters counters;
+        if (MemStatsPageRead(it->addr, &counters, READ_TRIES)) {
+            AddCounters(stats, counters);
+            found = true;
+        }
+    }
+    return found;
+}
+
+size_t MemStatsReader::Aggregate(MemStatsCounters &total) const
+{
+    total = MemStatsCounters();
+    size_t count = 0;
+    for (const auto &page : pages_) {
+        MemStatsCounters counters;
+        if (MemStatsPageRead(page.addr, &counters, READ_TRIES)) {
+            AddCounters(total, counters);
+            count++;
+        }
+    }
+    return count;
+}
+
+std::vector<int> MemStatsReader::GetPids() const
+{
+    std::vector<int> pids;
+    for (const auto &page : pages_) {
+        if (pids.empty() || pids.back() != page.pid) {
+            pids.push_back(page.pid);
+        }
+    }
+    return pids;
+}
+} /* namespace MemInfo */
+} /* namespace OHOS */
@@ -15,12 +15,14 @@
 
 #include "meminfo.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <v1_0/imemory_tracker_interface.h>
 
 #include "file_ex.h" // LoadStringFromFile
 #include "hilog/log.h"
+#include "mem_stats_reader.h"
 
 #undef LOG_TAG
 #define LOG_TAG "MemInfo"
@@ -113,6 +115,73 @@ uint64_t GetSwapPssByPid(const int pid)
     return size;
 }
 
+// get purgeable memory from status, or from the stats page
+bool GetPurgeableMemInfo(const int pid, PurgeableInfo &info)
+{
+    info = PurgeableInfo();
+    std::string filename = "/proc/" + std::to_string(pid) + "/status";
+    std::ifstream in(filename);
+    if (!in) {
+        HILOG_ERROR(LOG_CORE, "File %{public}s not found.\n", filename.c_str());
+        return false;
+    }
+
+    // format like:
+    // PurgSum:     1024 kB
+    // PurgPin:      256 kB
+    bool hasSum = false;
+    bool hasPin = false;
+    std::string content;
+    while (in.good() && getline(in, content) && !(hasSum && hasPin)) {
+        std::string::size_type typePos = content.find(":");
+        if (typePos == content.npos) {
+            continue;
+        }
+        std::string type = content.substr(0, typePos);
+        const int base = 10;
+        if (type == "PurgSum") {
+            info.purgSum = strtoull(content.c_str() + typePos + 1, nullptr, base);
+            hasSum = true;
+        } else if (type == "PurgPin") {
+            info.purgPin = strtoull(content.c_str() + typePos + 1, nullptr, base);
+            hasPin = true;
+        }
+    }
+    in.close();
+
+    // the kernel does not know what is purged, and mainline kernels report nothing
+    MemStatsCounters stats;
+    if (!GetMemStatsByPid(pid, stats)) {
+        if (!hasSum) {
+            HILOG_DEBUG(LOG_CORE, "no purgeable memory in %{public}s", filename.c_str());
+        }
+        return hasSum;
+    }
+    info.purged = stats.purgeablePurgedBytes / BYTE_PER_KB;
+    if (hasSum) {
+        return true;
+    }
+    if (stats.purgeableBytes == 0) {
+        HILOG_DEBUG(LOG_CORE, "no purgeable memory in %{public}s or stats page", filename.c_str());
+        return false;
+    }
+    uint64_t resident = stats.purgeableBytes > stats.purgeablePurgedBytes ?
+        stats.purgeableBytes - stats.purgeablePurgedBytes : 0;
+    info.purgSum = resident / BYTE_PER_KB;
+    info.purgPin = std::min(stats.purgeablePinnedBytes, resident) / BYTE_PER_KB;
+    return true;
+}
+
+// get purgeable memory reclaimable without kill
+uint64_t GetPurgeableByPid(const int pid)
+{
+    PurgeableInfo info;
+    if (!GetPurgeableMemInfo(pid, info)) {
+        return 0;
+    }
+    return info.Reclaimable();
+}
+
 // get graphics memory from hdi
 bool GetGraphicsMemory(const int pid, uint64_t &gl, uint64_t &graph)
 {
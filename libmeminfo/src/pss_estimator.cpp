@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "meminfo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+#include "hilog/log.h"
+
+#undef LOG_TAG
+#define LOG_TAG "MemInfo"
+
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD001799
+
+namespace OHOS {
+namespace MemInfo {
+namespace {
+// pages are sampled in clusters, whose pagemap entries are read by one pread
+constexpr uint64_t CLUSTER_PAGES = 64;
+constexpr uint64_t PAGEMAP_PRESENT = 1ULL << 63;
+constexpr uint64_t PAGEMAP_PFN_MASK = (1ULL << 55) - 1;
+constexpr double Z_95 = 1.96;
+constexpr uint64_t BYTE_PER_KB = 1024;
+
+struct Vma {
+    uint64_t start;
+    uint64_t end;
+};
+
+bool ReadVmas(const int pid, std::vector<Vma> &vmas)
+{
+    std::string path = "/proc/" + std::to_string(pid) + "/maps";
+    FILE *fp = fopen(path.c_str(), "re");
+    if (fp == nullptr) {
+        HILOG_ERROR(LOG_CORE, "File %{public}s not found.\n", path.c_str());
+        return false;
+    }
+    // format like:
+    // 5581c2000000-5581c2028000 r--p 00000000 fd:01 1234    /system/bin/foo
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        Vma vma;
+        if (sscanf(line, "%" SCNx64 "-%" SCNx64, &vma.start, &vma.end) != 2 || vma.end <= vma.start) {
+            continue;
+        }
+        if (strstr(line, "[vsyscall]") != nullptr) {
+            continue;
+        }
+        vmas.push_back(vma);
+    }
+    fclose(fp);
+    return true;
+}
+
+class PageCounter {
+public:
+    PageCounter(int pagemapFd, int kpagecountFd) : pagemapFd_(pagemapFd), kpagecountFd_(kpagecountFd) {}
+
+    // sum of page size divided by mapcount of present RAM pages in [@page, @page + @count), false on error
+    bool ClusterPss(uint64_t page, uint64_t count, double &pss)
+    {
+        uint64_t entries[CLUSTER_PAGES];
+        ssize_t len = pread(pagemapFd_, entries, count * sizeof(uint64_t), page * sizeof(uint64_t));
+        if (len < 0) {
+            return false;
+        }
+        pss = 0;
+        for (size_t i = 0; i < static_cast<size_t>(len) / sizeof(uint64_t); i++) {
+            if ((entries[i] & PAGEMAP_PRESENT) == 0) {
+                continue;
+            }
+            uint64_t pfn = entries[i] & PAGEMAP_PFN_MASK;
+            if (pfn == 0) {
+                HILOG_ERROR(LOG_CORE, "pfn is hidden, no privilege.");
+                return false;
+            }
+            uint64_t mapcount = 0;
+            ssize_t ret = pread(kpagecountFd_, &mapcount, sizeof(mapcount), pfn * sizeof(uint64_t));
+            if (ret < 0) {
+                return false;
+            }
+            // a pfn beyond kpagecount is not RAM, like device memory, and mapcount 0 is not counted
+            // by smaps either, like the zero page and pfn-mapped frames
+            if (ret != static_cast<ssize_t>(sizeof(mapcount)) || mapcount == 0) {
+                continue;
+            }
+            pss += 1.0 / mapcount;
+        }
+        return true;
+    }
+
+private:
+    int pagemapFd_;
+    int kpagecountFd_;
+};
+} /* namespace */
+
+bool EstimatePssByPid(const int pid, double fraction, PssEstimate &estimate)
+{
+    estimate = PssEstimate();
+    if (!(fraction > 0 && fraction <= 1)) {
+        HILOG_ERROR(LOG_CORE, "fraction %{public}f is out of (0, 1].", fraction);
+        return false;
+    }
+    std::vector<Vma> vmas;
+    if (!ReadVmas(pid, vmas)) {
+        return false;
+    }
+    std::string pagemapPath = "/proc/" + std::to_string(pid) + "/pagemap";
+    int pagemapFd = open(pagemapPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (pagemapFd < 0) {
+        HILOG_ERROR(LOG_CORE, "File %{public}s not found.\n", pagemapPath.c_str());
+        return false;
+    }
+    int kpagecountFd = open("/proc/kpagecount", O_RDONLY | O_CLOEXEC);
+    if (kpagecountFd < 0) {
+        HILOG_ERROR(LOG_CORE, "open kpagecount failed.");
+        close(pagemapFd);
+        return false;
+    }
+
+    // each cluster is sampled with probability @fraction, the sum of sampled clusters over @fraction
+    // is an unbiased estimate, whose variance is estimated by (1 - f) / f^2 * sum of squares
+    const uint64_t pageSize = static_cast<uint64_t>(getpagesize());
+    std::mt19937_64 rng(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::bernoulli_distribution pick(fraction);
+    PageCounter counter(pagemapFd, kpagecountFd);
+    double sum = 0;
+    double sumSquares = 0;
+    bool ret = true;
+    for (const auto &vma : vmas) {
+        uint64_t end = vma.end / pageSize;
+        estimate.pagesTotal += end - vma.start / pageSize;
+        for (uint64_t page = vma.start / pageSize; page < end && ret; page += CLUSTER_PAGES) {
+            if (fraction < 1 && !pick(rng)) {
+                continue;
+            }
+            uint64_t count = std::min(CLUSTER_PAGES, end - page);
+            double pss = 0;
+            ret = counter.ClusterPss(page, count, pss);
+            estimate.pagesSampled += count;
+            sum += pss;
+            sumSquares += pss * pss;
+        }
+        if (!ret) {
+            break;
+        }
+    }
+    close(kpagecountFd);
+    close(pagemapFd);
+    if (!ret) {
+        estimate = PssEstimate();
+        return false;
+    }
+
+    const double pageKb = static_cast<double>(pageSize) / BYTE_PER_KB;
+    double pss = sum / fraction * pageKb;
+    double margin = Z_95 * std::sqrt((1 - fraction) * sumSquares) / fraction * pageKb;
+    estimate.pss = static_cast<uint64_t>(std::llround(pss));
+    estimate.low = static_cast<uint64_t>(std::llround(std::max(pss - margin, 0.0)));
+    estimate.high = static_cast<uint64_t>(std::llround(pss + margin));
+    return true;
+}
+} /* namespace MemInfo */
+} /* namespace OHOS */
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "smaps_parser.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "hilog/log.h"
+
+#undef LOG_TAG
+#define LOG_TAG "MemInfo"
+
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD001799
+
+namespace OHOS {
+namespace MemInfo {
+namespace {
+constexpr int BASE_DEC = 10;
+
+struct SmapsField {
+    const char *key;
+    size_t keyLen;
+    uint64_t SmapsVma::*value;
+};
+
+#define SMAPS_FIELD(key, member) { key ":", sizeof(key), &SmapsVma::member }
+const SmapsField SMAPS_FIELDS[] = {
+    SMAPS_FIELD("Rss", rss),
+    SMAPS_FIELD("Pss", pss),
+    SMAPS_FIELD("Shared_Clean", sharedClean),
+    SMAPS_FIELD("Shared_Dirty", sharedDirty),
+    SMAPS_FIELD("Private_Clean", privateClean),
+    SMAPS_FIELD("Private_Dirty", privateDirty),
+    SMAPS_FIELD("Anonymous", anonymous),
+    SMAPS_FIELD("Swap", swap),
+    SMAPS_FIELD("SwapPss", swapPss),
+};
+#undef SMAPS_FIELD
+
+// parse a header line, format like:
+// 5581c2000000-5581c2028000 r--p 00000000 fd:01 1234    /system/bin/foo
+bool ParseHeader(const char *line, SmapsVma &vma)
+{
+    unsigned int major = 0;
+    unsigned int minor = 0;
+    int nameOffset = 0;
+    if (sscanf(line, "%" SCNx64 "-%" SCNx64 " %4s %" SCNx64 " %x:%x %" SCNu64 " %n", &vma.start, &vma.end,
+        vma.perms, &vma.offset, &major, &minor, &vma.inode, &nameOffset) != 7) { // 7: fields before name
+        return false;
+    }
+    const char *name = line + nameOffset;
+    size_t len = strlen(name);
+    while (len > 0 && (name[len - 1] == '\n' || name[len - 1] == ' ')) {
+        len--;
+    }
+    vma.name.assign(name, len);
+    return true;
+}
+
+void ParseField(const char *line, SmapsVma &vma)
+{
+    if (strncmp(line, "VmFlags:", strlen("VmFlags:")) == 0) {
+        const char *flags = line + strlen("VmFlags:");
+        while (*flags == ' ') {
+            flags++;
+        }
+        size_t len = strlen(flags);
+        while (len > 0 && (flags[len - 1] == '\n' || flags[len - 1] == ' ')) {
+            len--;
+        }
+        vma.vmFlags.assign(flags, len);
+        return;
+    }
+    for (const auto &field : SMAPS_FIELDS) {
+        if (strncmp(line, field.key, field.keyLen) == 0) {
+            vma.*(field.value) = strtoull(line + field.keyLen, nullptr, BASE_DEC);
+            return;
+        }
+    }
+}
+
+void ResetVma(SmapsVma &vma)
+{
+    // keep capacity of strings, which are reused by the next VMA
+    std::string name;
+    std::string vmFlags;
+    name.swap(vma.name);
+    vmFlags.swap(vma.vmFlags);
+    vma = SmapsVma();
+    name.clear();
+    vmFlags.clear();
+    vma.name.swap(name);
+    vma.vmFlags.swap(vmFlags);
+}
+} /* namespace */
+
+bool SmapsVma::HasVmFlag(const char *flag) const
+{
+    size_t len = strlen(flag);
+    for (size_t pos = vmFlags.find(flag); pos != std::string::npos; pos = vmFlags.find(flag, pos + 1)) {
+        if ((pos == 0 || vmFlags[pos - 1] == ' ') &&
+            (pos + len == vmFlags.size() || vmFlags[pos + len] == ' ')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SmapsVma::IsFileBacked() const
+{
+    static const char *const SHMEM_PREFIXES[] = { "/dev/ashmem", "/memfd:", "/dev/zero", "/dev/shm/", "/SYSV" };
+    if (inode == 0 || name.empty()) {
+        return false;
+    }
+    for (const char *prefix : SHMEM_PREFIXES) {
+        if (name.compare(0, strlen(prefix), prefix) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SmapsVma::IsPurgeable() const
+{
+    // "pu" is shown for VM_PURGEABLE by kernels with purgeable memory, others are by libpurgeablemem
+    return HasVmFlag("pu") || name.find("Purgeable") != std::string::npos;
+}
+
+bool ParseSmaps(const std::string &path, const std::function<void(const SmapsVma &vma)> &func)
+{
+    FILE *fp = fopen(path.c_str(), "re");
+    if (fp == nullptr) {
+        HILOG_ERROR(LOG_CORE, "File %{public}s not found.\n", path.c_str());
+        return false;
+    }
+    SmapsVma vma;
+    bool inVma = false;
+    char *line = nullptr;
+    size_t lineCap = 0;
+    while (getline(&line, &lineCap, fp) >= 0) {
+        // field keys have no '-' before ':', which is what header lines start with
+        const char *dash = strchr(line, '-');
+        const char *colon = strchr(line, ':');
+        if (dash != nullptr && (colon == nullptr || dash < colon)) {
+            if (inVma) {
+                func(vma);
+                ResetVma(vma);
+            }
+            inVma = ParseHeader(line, vma);
+        } else if (inVma) {
+            ParseField(line, vma);
+        }
+    }
+    if (inVma) {
+        func(vma);
+    }
+    free(line);
+    fclose(fp);
+    return true;
+}
+
+bool ParseSmapsByPid(const int pid, const std::function<void(const SmapsVma &vma)> &func)
+{
+    return ParseSmaps("/proc/" + std::to_string(pid) + "/smaps", func);
+}
+} /* namespace MemInfo */
+} /* namespace OHOS */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vma_snapshot.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "smaps_parser.h"
+
+namespace OHOS {
+namespace MemInfo {
+namespace {
+uint32_t Saturate(uint64_t value)
+{
+    return value > std::numeric_limits<uint32_t>::max() ? std::numeric_limits<uint32_t>::max() :
+        static_cast<uint32_t>(value);
+}
+
+int64_t Growth(const VmaGrowth &growth)
+{
+    return growth.pss + growth.swap;
+}
+
+void AddGrowth(VmaGrowth &growth, const VmaRecord *older, const VmaRecord *newer)
+{
+    const VmaRecord &vma = newer != nullptr ? *newer : *older;
+    growth.start = vma.start;
+    growth.end = vma.end;
+    growth.nameId = vma.nameId;
+    growth.rss = (newer != nullptr ? static_cast<int64_t>(newer->rss) : 0) -
+        (older != nullptr ? static_cast<int64_t>(older->rss) : 0);
+    growth.pss = (newer != nullptr ? static_cast<int64_t>(newer->pss) : 0) -
+        (older != nullptr ? static_cast<int64_t>(older->pss) : 0);
+    growth.swap = (newer != nullptr ? static_cast<int64_t>(newer->swap) : 0) -
+        (older != nullptr ? static_cast<int64_t>(older->swap) : 0);
+}
+
+void KeepTop(std::vector<VmaGrowth> &growths, size_t top)
+{
+    auto end = std::remove_if(growths.begin(), growths.end(),
+        [](const VmaGrowth &growth) { return Growth(growth) <= 0; });
+    growths.erase(end, growths.end());
+    auto greater = [](const VmaGrowth &a, const VmaGrowth &b) { return Growth(a) > Growth(b); };
+    if (growths.size() > top) {
+        std::partial_sort(growths.begin(), growths.begin() + top, growths.end(), greater);
+        growths.resize(top);
+    } else {
+        std::sort(growths.begin(), growths.end(), greater);
+    }
+}
+} /* namespace */
+
+VmaNameTable::VmaNameTable()
+{
+    Intern("");
+}
+
+uint32_t VmaNameTable::Intern(const std::string &name)
+{
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    it = ids_.emplace(name, id).first;
+    names_.push_back(&it->first);
+    return id;
+}
+
+const std::string &VmaNameTable::Name(uint32_t id) const
+{
+    return *names_[id < names_.size() ? id : ANON_ID];
+}
+
+size_t VmaNameTable::Size() const
+{
+    return names_.size();
+}
+
+bool VmaSnapshot::Capture(const int pid, VmaNameTable &names)
+{
+    records_.clear();
+    bool ret = ParseSmapsByPid(pid, [this, &names](const SmapsVma &vma) {
+        records_.push_back({ vma.start, vma.end, names.Intern(vma.name), Saturate(vma.rss), Saturate(vma.pss),
+            Saturate(vma.swap) });
+    });
+    records_.shrink_to_fit();
+    return ret;
+}
+
+const std::vector<VmaRecord> &VmaSnapshot::Records() const
+{
+    return records_;
+}
+
+uint64_t VmaSnapshot::TotalPss() const
+{
+    uint64_t pss = 0;
+    for (const auto &record : records_) {
+        pss += record.pss;
+    }
+    return pss;
+}
+
+void DiffVmaSnapshots(const VmaSnapshot &older, const VmaSnapshot &newer, size_t top, VmaDiff &diff)
+{
+    diff = VmaDiff();
+    const std::vector<VmaRecord> &olds = older.Records();
+    const std::vector<VmaRecord> &news = newer.Records();
+    std::unordered_map<uint32_t, VmaGrowth> categories;
+    auto add = [&diff, &categories](const VmaRecord *oldVma, const VmaRecord *newVma) {
+        VmaGrowth growth;
+        AddGrowth(growth, oldVma, newVma);
+        if (growth.rss == 0 && growth.pss == 0 && growth.swap == 0) {
+            return;
+        }
+        diff.mappings.push_back(growth);
+        VmaGrowth &category = categories[growth.nameId];
+        category.nameId = growth.nameId;
+        category.rss += growth.rss;
+        category.pss += growth.pss;
+        category.swap += growth.swap;
+        diff.total.rss += growth.rss;
+        diff.total.pss += growth.pss;
+        diff.total.swap += growth.swap;
+    };
+    size_t i = 0;
+    size_t j = 0;
+    while (i < olds.size() || j < news.size()) {
+        if (j == news.size() || (i < olds.size() && olds[i].start < news[j].start)) {
+            add(&olds[i++], nullptr);
+        } else if (i == olds.size() || news[j].start < olds[i].start) {
+            add(nullptr, &news[j++]);
+        } else if (olds[i].nameId == news[j].nameId) {
+            add(&olds[i++], &news[j++]);
+        } else {
+            add(&olds[i++], nullptr);
+            add(nullptr, &news[j++]);
+        }
+    }
+    for (const auto &category : categories) {
+        diff.categories.push_back(category.second);
+    }
+    KeepTop(diff.mappings, top);
+    KeepTop(diff.categories, top);
+}
+} /* namespace MemInfo */
+} /* namespace OHOS */
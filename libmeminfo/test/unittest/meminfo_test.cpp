@@ -15,7 +15,23 @@
 
 #include "meminfo.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include "mem_cgroup.h"
+#include "mem_reclaim.h"
+#include "mem_sample_store.h"
+#include "mem_stats_reader.h"
+#include "smaps_parser.h"
+#include "vma_snapshot.h"
 
 #include "gtest/gtest.h"
 
@@ -24,6 +40,32 @@ namespace MemInfo {
 using namespace testing;
 using namespace testing::ext;
 
+static void WriteFile(const std::string &path, const std::string &content)
+{
+    std::ofstream out(path);
+    out << content;
+}
+
+// a cgroup directory of memory files, like those of cgroup v2
+static void MakeCgroup(const std::string &path, uint64_t current, uint64_t oomKill)
+{
+    mkdir(path.c_str(), S_IRWXU);
+    WriteFile(path + "/memory.current", std::to_string(current) + "\n");
+    WriteFile(path + "/memory.stat", "anon 1048576\nfile 2097152\nkernel_stack 16384\npagetables 32768\n"
+        "percpu 0\nsock 0\nslab 65536\nfile_mapped 4096\npgfault 100\nworkingset_refault_file 7\n");
+    WriteFile(path + "/memory.events", "low 0\nhigh 1\nmax 2\noom 3\noom_kill " + std::to_string(oomKill) + "\n");
+    WriteFile(path + "/memory.pressure", "some avg10=1.50 avg60=0.25 avg300=0.00 total=1234\n"
+        "full avg10=0.50 avg60=0.00 avg300=0.00 total=567\n");
+}
+
+static void RemoveCgroup(const std::string &path)
+{
+    for (const char *name : { "memory.current", "memory.stat", "memory.events", "memory.pressure" }) {
+        unlink((path + "/" + name).c_str());
+    }
+    rmdir(path.c_str());
+}
+
 class MemInfoTest : public testing::Test {
 public:
     static void SetUpTestCase();
@@ -101,6 +143,545 @@ HWTEST_F(MemInfoTest, GetSwapPssByPid_Test_002, TestSize.Level1)
     ASSERT_EQ(size == 0, true);
 }
 
+HWTEST_F(MemInfoTest, EstimatePssByPid_Test_001, TestSize.Level1)
+{
+    // pages read but never written map the zero page, which is not counted by smaps
+    const size_t len = 64 * 1024 * 1024;
+    char *addr = static_cast<char *>(mmap(nullptr, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    ASSERT_EQ(addr != MAP_FAILED, true);
+    volatile char sum = 0;
+    for (size_t i = 0; i < len; i += 4096) {
+        sum += addr[i];
+    }
+
+    int pid = getpid();
+    PssEstimate all;
+    bool ret = EstimatePssByPid(pid, 1.0, all);
+    uint64_t smapsPss = GetPssByPid(pid);
+    munmap(addr, len);
+    if (!ret) {
+        std::cout << "pfn is not readable" << std::endl;
+        return;
+    }
+    std::cout << "pss = " << all.pss << ", smaps pss = " << smapsPss << std::endl;
+    ASSERT_EQ(all.pss > 0, true);
+    ASSERT_EQ(all.low == all.pss && all.high == all.pss, true);
+    ASSERT_EQ(all.pagesSampled == all.pagesTotal, true);
+    if (smapsPss > 0) {
+        // pss changes a little between both reads
+        const uint64_t tolerance = std::max<uint64_t>(smapsPss / 10, 1024);
+        ASSERT_EQ(all.pss + tolerance >= smapsPss && all.pss <= smapsPss + tolerance, true);
+    }
+
+    PssEstimate part;
+    ASSERT_EQ(EstimatePssByPid(pid, 0.1, part), true);
+    std::cout << "pss = " << part.pss << " [" << part.low << ", " << part.high << "]" << std::endl;
+    ASSERT_EQ(part.low <= part.pss && part.pss <= part.high, true);
+    ASSERT_EQ(part.pagesSampled < part.pagesTotal, true);
+}
+
+HWTEST_F(MemInfoTest, EstimatePssByPid_Test_002, TestSize.Level1)
+{
+    PssEstimate estimate;
+    ASSERT_EQ(EstimatePssByPid(-1, 1.0, estimate), false);
+    ASSERT_EQ(EstimatePssByPid(getpid(), 0, estimate), false);
+    ASSERT_EQ(EstimatePssByPid(getpid(), 1.5, estimate), false);
+}
+
+HWTEST_F(MemInfoTest, GetPurgeableMemInfo_Test_001, TestSize.Level1)
+{
+    int pid = 1;
+    PurgeableInfo info;
+    if (!GetPurgeableMemInfo(pid, info)) {
+        std::cout << "purgeable memory is not reported by kernel" << std::endl;
+        ASSERT_EQ(info.purgSum == 0 && info.purgPin == 0, true);
+        ASSERT_EQ(GetPurgeableByPid(pid) == 0, true);
+        return;
+    }
+    std::cout << "purgSum = " << info.purgSum << ", purgPin = " << info.purgPin << std::endl;
+    ASSERT_EQ(info.Reclaimable() <= info.purgSum, true);
+    ASSERT_EQ(GetPurgeableByPid(pid) <= info.purgSum, true);
+}
+
+HWTEST_F(MemInfoTest, GetPurgeableMemInfo_Test_002, TestSize.Level1)
+{
+    int pid = -1;
+    PurgeableInfo info;
+    ASSERT_EQ(GetPurgeableMemInfo(pid, info), false);
+    ASSERT_EQ(GetPurgeableByPid(pid) == 0, true);
+}
+
+HWTEST_F(MemInfoTest, GetPurgeableMemInfo_Test_003, TestSize.Level1)
+{
+    int pid = getpid();
+    std::ifstream in("/proc/self/status");
+    std::string status((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    bool kernel = status.find("PurgSum:") != std::string::npos;
+    PurgeableInfo before;
+    GetPurgeableMemInfo(pid, before);
+
+    // counters of libpurgeablemem, in a page of its own source
+    MemStatsPage *page = MemStatsPageCreate(MEM_STATS_SOURCE_PURGEABLE, nullptr);
+    ASSERT_NE(page, nullptr);
+    MemStatsPageAdd(page, &page->counters.purgeableBytes, 64 * 1024);
+    MemStatsPageAdd(page, &page->counters.purgeablePinnedBytes, 16 * 1024);
+    MemStatsPageAdd(page, &page->counters.purgeablePurgedBytes, 32 * 1024);
+    PurgeableInfo info;
+    ASSERT_EQ(GetPurgeableMemInfo(pid, info), true);
+    ASSERT_EQ(info.purged == before.purged + 32, true);
+    if (!kernel) {
+        // resident is what is not purged
+        ASSERT_EQ(info.purgSum == before.purgSum + 32, true);
+        ASSERT_EQ(info.purgPin == before.purgPin + 16, true);
+        ASSERT_EQ(GetPurgeableByPid(pid) == info.Reclaimable(), true);
+    }
+    munmap(page, MEM_STATS_PAGE_LEN);
+}
+
+HWTEST_F(MemInfoTest, PurgeableInfo_Reclaimable_Test, TestSize.Level1)
+{
+    PurgeableInfo info;
+    info.purgSum = 1024;
+    info.purgPin = 256;
+    ASSERT_EQ(info.Reclaimable() == 768, true);
+    info.purgPin = 2048; // fields are read at different time
+    ASSERT_EQ(info.Reclaimable() == 0, true);
+}
+
+HWTEST_F(MemInfoTest, GetMemStatsByPid_Test_001, TestSize.Level1)
+{
+    int pid = getpid();
+    MemStatsCounters before;
+    GetMemStatsByPid(pid, before);
+    MemStatsPage *page = MemStatsPageCreate(MEM_STATS_SOURCE_DMABUF_HEAP, nullptr);
+    ASSERT_EQ(page != nullptr, true);
+    MemStatsPageAdd(page, &page->counters.dmabufBuffers, 1);
+    MemStatsPageAdd(page, &page->counters.dmabufBytes, 4096);
+
+    MemStatsCounters stats;
+    ASSERT_EQ(GetMemStatsByPid(pid, stats), true);
+    ASSERT_EQ(stats.dmabufBuffers == before.dmabufBuffers + 1, true);
+    ASSERT_EQ(stats.dmabufBytes == before.dmabufBytes + 4096, true);
+
+    MemStatsReader reader;
+    ASSERT_EQ(reader.Refresh() > 0, true);
+    std::vector<int> pids = reader.GetPids();
+    ASSERT_EQ(std::find(pids.begin(), pids.end(), pid) != pids.end(), true);
+    ASSERT_EQ(reader.Read(pid, stats), true);
+    ASSERT_EQ(stats.dmabufBytes == before.dmabufBytes + 4096, true);
+
+    // the mapping is kept, later updates are read without Refresh()
+    MemStatsPageAdd(page, &page->counters.dmabufBytes, 4096);
+    ASSERT_EQ(reader.Read(pid, stats), true);
+    ASSERT_EQ(stats.dmabufBytes == before.dmabufBytes + 8192, true);
+    MemStatsCounters total;
+    ASSERT_EQ(reader.Aggregate(total) > 0, true);
+    ASSERT_EQ(total.dmabufBytes >= stats.dmabufBytes, true);
+}
+
+HWTEST_F(MemInfoTest, GetMemStatsByPid_Test_002, TestSize.Level1)
+{
+    int pid = -1;
+    MemStatsCounters stats;
+    ASSERT_EQ(GetMemStatsByPid(pid, stats), false);
+    MemStatsReader reader;
+    reader.Refresh();
+    ASSERT_EQ(reader.Read(pid, stats), false);
+}
+
+HWTEST_F(MemInfoTest, GetMemStatsByPid_Fork_Test_001, TestSize.Level1)
+{
+    int pid = getpid();
+    MemStatsPage *page = MemStatsPageCreate(MEM_STATS_SOURCE_DMABUF_HEAP, nullptr);
+    ASSERT_EQ(page != nullptr, true);
+    MemStatsPageAdd(page, &page->counters.dmabufBytes, 4096);
+    MemStatsReader reader;
+    reader.Refresh();
+    MemStatsCounters total;
+    reader.Aggregate(total);
+    MemStatsCounters stats;
+    ASSERT_EQ(reader.Read(pid, stats), true);
+
+    // the child keeps the pages inherited from this process until the pipe is closed
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t child = fork();
+    ASSERT_EQ(child >= 0, true);
+    if (child == 0) {
+        close(fds[1]);
+        char c;
+        (void)read(fds[0], &c, 1);
+        _exit(0);
+    }
+    close(fds[0]);
+    MemStatsCounters childStats;
+    bool childFound = GetMemStatsByPid(child, childStats);
+    reader.Refresh();
+    std::vector<int> pids = reader.GetPids();
+    bool childListed = std::find(pids.begin(), pids.end(), child) != pids.end();
+    MemStatsCounters forkTotal;
+    reader.Aggregate(forkTotal);
+    MemStatsCounters forkStats;
+    reader.Read(pid, forkStats);
+    close(fds[1]);
+    waitpid(child, nullptr, 0);
+
+    ASSERT_EQ(childFound, false);
+    ASSERT_EQ(childListed, false);
+    ASSERT_EQ(forkTotal.dmabufBytes == total.dmabufBytes, true);
+    ASSERT_EQ(forkStats.dmabufBytes == stats.dmabufBytes, true);
+}
+
+HWTEST_F(MemInfoTest, GetMemStatsByPid_Fork_Test_002, TestSize.Level1)
+{
+    int pid = getpid();
+    int fd = -1;
+    MemStatsPage *page = MemStatsPageCreate(MEM_STATS_SOURCE_DMABUF_HEAP, &fd);
+    ASSERT_EQ(page != nullptr, true);
+    MemStatsPageAdd(page, &page->counters.dmabufBytes, 4096);
+    MemStatsCounters before;
+    ASSERT_EQ(GetMemStatsByPid(pid, before), true);
+
+    // the child publishes a page of its own, then waits until @done is closed
+    int ready[2];
+    int done[2];
+    ASSERT_EQ(pipe(ready), 0);
+    ASSERT_EQ(pipe(done), 0);
+    pid_t child = fork();
+    ASSERT_EQ(child >= 0, true);
+    if (child == 0) {
+        close(ready[0]);
+        close(done[1]);
+        MemStatsPage *childPage = MemStatsPageRecreate(page, &fd);
+        char c = 0;
+        if (childPage != nullptr) {
+            MemStatsPageAdd(childPage, &childPage->counters.dmabufBytes, 8192);
+            c = 1;
+        }
+        (void)write(ready[1], &c, 1);
+        (void)read(done[0], &c, 1);
+        _exit(0);
+    }
+    close(ready[1]);
+    close(done[0]);
+    char c = 0;
+    (void)read(ready[0], &c, 1);
+    MemStatsCounters childStats;
+    bool childFound = GetMemStatsByPid(child, childStats);
+    MemStatsCounters after;
+    GetMemStatsByPid(pid, after);
+    close(done[1]);
+    close(ready[0]);
+    waitpid(child, nullptr, 0);
+    close(fd);
+
+    ASSERT_EQ(c, 1);
+    ASSERT_EQ(childFound, true);
+    ASSERT_EQ(childStats.dmabufBytes == 8192, true);
+    ASSERT_EQ(after.dmabufBytes == before.dmabufBytes, true);
+}
+
+HWTEST_F(MemInfoTest, MemStatsPageRead_Test, TestSize.Level1)
+{
+    MemStatsPage *page = MemStatsPageCreate(MEM_STATS_SOURCE_DMABUF_HEAP, nullptr);
+    ASSERT_EQ(page != nullptr, true);
+    const uint64_t bufferSize = 4096;
+    const int loops = 100000;
+    std::atomic<bool> stop {false};
+    std::thread writer([page, &stop, bufferSize, loops]() {
+        for (int i = 0; i < loops && !stop; i++) {
+            MemStatsPageWriteBegin(page);
+            __atomic_store_n(&page->counters.dmabufBuffers, page->counters.dmabufBuffers + 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&page->counters.dmabufBytes, page->counters.dmabufBytes + bufferSize,
+                __ATOMIC_RELAXED);
+            MemStatsPageWriteEnd(page);
+        }
+    });
+    // a snapshot never sees buffers and bytes of different writes
+    const unsigned int maxTries = 1000;
+    for (int i = 0; i < loops / 10; i++) {
+        MemStatsCounters stats;
+        if (MemStatsPageRead(page, &stats, maxTries)) {
+            ASSERT_EQ(stats.dmabufBytes == stats.dmabufBuffers * bufferSize, true);
+        }
+    }
+    stop = true;
+    writer.join();
+}
+
+HWTEST_F(MemInfoTest, MemSampleStore_Test_001, TestSize.Level1)
+{
+    std::string path = "/data/local/tmp/meminfo_sample_store";
+    if (access("/data/local/tmp", W_OK) != 0) {
+        path = "/tmp/meminfo_sample_store";
+    }
+    unlink(path.c_str());
+    const uint32_t capacity = 4;
+    MemSampleStore store;
+    ASSERT_EQ(store.Open(path, capacity), true);
+    ASSERT_EQ(store.Capacity() == capacity, true);
+    const uint64_t base = 1700000000000;
+    for (uint64_t i = 0; i < 6; i++) {
+        MemSample sample;
+        sample.timestamp = base + i * 1000;
+        sample.pid = (i % 2 == 0) ? 100 : 200;
+        sample.rss = 1024 + i;
+        sample.pss = 512 + i;
+        ASSERT_EQ(store.Append(sample), true);
+    }
+    // the oldest 2 are overwritten
+    ASSERT_EQ(store.Size() == capacity, true);
+    std::vector<MemSample> samples;
+    ASSERT_EQ(store.Query(-1, 0, UINT64_MAX, samples) == capacity, true);
+    ASSERT_EQ(samples.front().timestamp == base + 2000, true);
+    ASSERT_EQ(samples.back().timestamp == base + 5000, true);
+    ASSERT_EQ(store.Query(100, 0, UINT64_MAX, samples) == 2, true);
+    ASSERT_EQ(samples[0].rss == 1026 && samples[1].pss == 516, true);
+    ASSERT_EQ(store.Query(200, base + 3000, base + 4000, samples) == 1, true);
+    ASSERT_EQ(samples[0].timestamp == base + 3000 && samples[0].rss == 1027, true);
+
+    // kept when opened again, and readable by another reader
+    store.Close();
+    ASSERT_EQ(store.Open(path, capacity), true);
+    ASSERT_EQ(store.Size() == capacity, true);
+    MemSampleStore reader;
+    ASSERT_EQ(reader.OpenReadOnly(path), true);
+    MemSample sample;
+    sample.timestamp = base + 6000;
+    ASSERT_EQ(reader.Append(sample), false);
+    ASSERT_EQ(store.Append(sample), true);
+    ASSERT_EQ(reader.Query(-1, base + 6000, base + 6000, samples) == 1, true);
+    unlink(path.c_str());
+}
+
+HWTEST_F(MemInfoTest, MemSampleStore_Test_002, TestSize.Level1)
+{
+    MemSampleStore store;
+    ASSERT_EQ(store.Open("/proc/no_such_dir/store", 1), false);
+    ASSERT_EQ(store.Open("/tmp/meminfo_sample_store_0", 0), false);
+    ASSERT_EQ(store.OpenReadOnly("/proc/self/status"), false);
+    std::vector<MemSample> samples;
+    ASSERT_EQ(store.Query(-1, 0, UINT64_MAX, samples) == 0, true);
+    MemSample sample;
+    ASSERT_EQ(store.Append(sample), false);
+}
+
+HWTEST_F(MemInfoTest, ParseSmaps_Test_001, TestSize.Level1)
+{
+    std::string path = "/data/local/tmp/meminfo_smaps";
+    if (access("/data/local/tmp", W_OK) != 0) {
+        path = "/tmp/meminfo_smaps";
+    }
+    std::ofstream out(path);
+    out << "5581c2000000-5581c2028000 r--p 00001000 fd:01 1234                       /system/bin/foo\n"
+        << "Size:                160 kB\n"
+        << "Rss:                 120 kB\n"
+        << "Pss:                  60 kB\n"
+        << "Shared_Clean:        120 kB\n"
+        << "Anonymous:             0 kB\n"
+        << "Swap:                  0 kB\n"
+        << "SwapPss:               0 kB\n"
+        << "VmFlags: rd mr mw me\n"
+        << "7f0000000000-7f0000100000 rw-p 00000000 00:00 0                          [anon:libc_malloc]\n"
+        << "Rss:                1024 kB\n"
+        << "Pss:                1000 kB\n"
+        << "Anonymous:          1024 kB\n"
+        << "Swap:                 16 kB\n"
+        << "SwapPss:               8 kB\n"
+        << "VmFlags: rd wr mr mw me ac\n"
+        << "7f0000100000-7f0000200000 rw-s 00000000 00:01 99                         /memfd:PurgeableMemFd (deleted)\n"
+        << "Rss:                   4 kB\n"
+        << "VmFlags: rd wr sh mr mw me ms\n";
+    out.close();
+
+    std::vector<SmapsVma> vmas;
+    ASSERT_EQ(ParseSmaps(path, [&vmas](const SmapsVma &vma) { vmas.push_back(vma); }), true);
+    unlink(path.c_str());
+    ASSERT_EQ(vmas.size() == 3, true);
+    ASSERT_EQ(vmas[0].start == 0x5581c2000000 && vmas[0].end == 0x5581c2028000, true);
+    ASSERT_EQ(vmas[0].offset == 0x1000 && vmas[0].inode == 1234, true);
+    ASSERT_EQ(vmas[0].name == "/system/bin/foo" && std::string(vmas[0].perms) == "r--p", true);
+    ASSERT_EQ(vmas[0].rss == 120 && vmas[0].pss == 60 && vmas[0].sharedClean == 120, true);
+    ASSERT_EQ(vmas[0].IsFileBacked() && !vmas[0].IsPurgeable() && !vmas[0].HasVmFlag("wr"), true);
+    ASSERT_EQ(vmas[1].name == "[anon:libc_malloc]" && vmas[1].anonymous == 1024, true);
+    ASSERT_EQ(vmas[1].swap == 16 && vmas[1].swapPss == 8 && vmas[1].sharedClean == 0, true);
+    ASSERT_EQ(!vmas[1].IsFileBacked() && vmas[1].HasVmFlag("ac") && !vmas[1].HasVmFlag("a"), true);
+    ASSERT_EQ(vmas[2].name == "/memfd:PurgeableMemFd (deleted)" && vmas[2].rss == 4, true);
+    ASSERT_EQ(!vmas[2].IsFileBacked() && vmas[2].IsPurgeable(), true);
+}
+
+HWTEST_F(MemInfoTest, ParseSmaps_Test_002, TestSize.Level1)
+{
+    int pid = getpid();
+    uint64_t pss = 0;
+    size_t count = 0;
+    ASSERT_EQ(ParseSmapsByPid(pid, [&pss, &count](const SmapsVma &vma) {
+        pss += vma.pss;
+        count++;
+    }), true);
+    std::cout << "vmas = " << count << ", pss = " << pss << std::endl;
+    ASSERT_EQ(count > 0 && pss > 0, true);
+    ASSERT_EQ(ParseSmapsByPid(-1, [](const SmapsVma &) {}), false);
+}
+
+HWTEST_F(MemInfoTest, VmaSnapshot_Test, TestSize.Level1)
+{
+    int pid = getpid();
+    VmaNameTable names;
+    VmaSnapshot older;
+    ASSERT_EQ(older.Capture(pid, names), true);
+    ASSERT_EQ(older.TotalPss() > 0, true);
+
+    const size_t len = 8 * 1024 * 1024;
+    char *addr = static_cast<char *>(mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    ASSERT_EQ(addr != MAP_FAILED, true);
+    for (size_t i = 0; i < len; i += 4096) {
+        addr[i] = 1;
+    }
+    VmaSnapshot newer;
+    ASSERT_EQ(newer.Capture(pid, names), true);
+    munmap(addr, len);
+
+    VmaDiff diff;
+    const size_t top = 3;
+    DiffVmaSnapshots(older, newer, top, diff);
+    ASSERT_EQ(!diff.mappings.empty() && diff.mappings.size() <= top, true);
+    std::cout << "top pss growth = " << diff.mappings[0].pss << ", total = " << diff.total.pss << std::endl;
+    ASSERT_EQ(diff.mappings[0].pss >= 8000, true);
+    ASSERT_EQ(diff.mappings[0].start <= reinterpret_cast<uint64_t>(addr), true);
+    ASSERT_EQ(diff.mappings[0].end >= reinterpret_cast<uint64_t>(addr) + len, true);
+    ASSERT_EQ(!diff.categories.empty() && diff.categories[0].pss >= diff.mappings[0].pss, true);
+    ASSERT_EQ(names.Name(diff.mappings[0].nameId) == names.Name(diff.categories[0].nameId), true);
+
+    DiffVmaSnapshots(newer, newer, top, diff);
+    ASSERT_EQ(diff.mappings.empty() && diff.categories.empty() && diff.total.pss == 0, true);
+}
+
+HWTEST_F(MemInfoTest, ReclaimProcessMemory_Test_001, TestSize.Level1)
+{
+    std::string path = "/data/local/tmp/meminfo_reclaim";
+    if (access("/data/local/tmp", W_OK) != 0) {
+        path = "/tmp/meminfo_reclaim";
+    }
+    const size_t len = 4 * 1024 * 1024;
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    ASSERT_EQ(fd >= 0, true);
+    ASSERT_EQ(ftruncate(fd, len), 0);
+    char *addr = static_cast<char *>(mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    close(fd);
+    ASSERT_EQ(addr != MAP_FAILED, true);
+    for (size_t i = 0; i < len; i += 4096) {
+        addr[i] = 1;
+    }
+    msync(addr, len, MS_SYNC);
+
+    // clean file pages are dropped by pageout
+    ReclaimPolicy policy;
+    policy.anon = false;
+    ReclaimResult result;
+    bool ret = ReclaimProcessMemory(getpid(), policy, result);
+    munmap(addr, len);
+    unlink(path.c_str());
+    if (!ret) {
+        std::cout << "process_madvise is not supported" << std::endl;
+        return;
+    }
+    std::cout << "advised = " << result.advised << ", reclaimed = " << result.reclaimed << std::endl;
+    ASSERT_EQ(result.advised >= len / 1024, true);
+    ASSERT_EQ(result.reclaimed > 0 && result.reclaimed <= result.advised, true);
+
+    policy.pageout = false;
+    ASSERT_EQ(ReclaimProcessMemory(getpid(), policy, result), true);
+    ASSERT_EQ(result.reclaimed == 0, true);
+}
+
+HWTEST_F(MemInfoTest, ReclaimProcessMemory_Test_002, TestSize.Level1)
+{
+    ReclaimPolicy policy;
+    ReclaimResult result;
+    ASSERT_EQ(ReclaimProcessMemory(-1, policy, result), false);
+    ASSERT_EQ(result.advised == 0 && result.reclaimed == 0, true);
+}
+
+HWTEST_F(MemInfoTest, ReclaimProcessMemory_Test_003, TestSize.Level1)
+{
+    std::string path = "/data/local/tmp/meminfo_reclaim_large";
+    if (access("/data/local/tmp", W_OK) != 0) {
+        path = "/tmp/meminfo_reclaim_large";
+    }
+    // a VMA over MAX_RW_COUNT is advised in parts, so a page beyond 2G is reclaimed as well
+    const size_t len = 3UL * 1024 * 1024 * 1024;
+    const size_t offset = len - 4096;
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    ASSERT_EQ(fd >= 0, true);
+    ASSERT_EQ(ftruncate(fd, len), 0);
+    char *addr = static_cast<char *>(mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    close(fd);
+    ASSERT_EQ(addr != MAP_FAILED, true);
+    addr[offset] = 1;
+    msync(addr + offset, 4096, MS_SYNC);
+
+    ReclaimPolicy policy;
+    policy.anon = false;
+    ReclaimResult result;
+    bool ret = ReclaimProcessMemory(getpid(), policy, result);
+    unsigned char vec = 0;
+    int mincoreRet = mincore(addr + offset, 4096, &vec);
+    munmap(addr, len);
+    unlink(path.c_str());
+    if (!ret) {
+        std::cout << "process_madvise is not supported" << std::endl;
+        return;
+    }
+    ASSERT_EQ(mincoreRet, 0);
+    ASSERT_EQ(vec & 1, 0);
+}
+
+HWTEST_F(MemInfoTest, CgroupMemReader_Test, TestSize.Level1)
+{
+    std::string root = "/data/local/tmp/meminfo_cgroup";
+    if (access("/data/local/tmp", W_OK) != 0) {
+        root = "/tmp/meminfo_cgroup";
+    }
+    mkdir(root.c_str(), S_IRWXU);
+    MakeCgroup(root + "/app1", 8 * 1024 * 1024, 1);
+    MakeCgroup(root + "/app1/sub", 4 * 1024 * 1024, 0);
+    MakeCgroup(root + "/app2", 2 * 1024 * 1024, 2);
+
+    CgroupMemReader reader;
+    ASSERT_EQ(reader.Open(root), false);
+    ASSERT_EQ(reader.Open(root + "/app1"), true);
+    CgroupMemInfo info;
+    ASSERT_EQ(reader.Read(info), true);
+    ASSERT_EQ(info.current == 8192 && info.anon == 1024 && info.file == 2048, true);
+    ASSERT_EQ(info.kernel == 16 + 32 + 64 && info.fileMapped == 4 && info.pgfault == 100, true);
+    ASSERT_EQ(info.workingsetRefaultFile == 7 && info.eventHigh == 1 && info.eventOomKill == 1, true);
+    ASSERT_EQ(info.someAvg10 == 1.5 && info.someAvg60 == 0.25 && info.someTotal == 1234, true);
+    ASSERT_EQ(info.fullAvg10 == 0.5 && info.fullTotal == 567, true);
+
+    // files are kept open and read again from their start
+    WriteFile(root + "/app1/memory.current", "1048576\n");
+    ASSERT_EQ(reader.Read(info), true);
+    ASSERT_EQ(info.current == 1024, true);
+    WriteFile(root + "/app1/memory.current", std::to_string(8 * 1024 * 1024) + "\n");
+
+    CgroupMemTree tree;
+    ASSERT_EQ(tree.Open(root, 1) == 2, true);
+    ASSERT_EQ(tree.Open(root, 2) == 3, true);
+    CgroupMemInfo total;
+    int maxDepth = 0;
+    ASSERT_EQ(tree.ReadAll([&maxDepth](const std::string &, int depth, const CgroupMemInfo &) {
+        maxDepth = std::max(maxDepth, depth);
+    }, &total) == 3, true);
+    ASSERT_EQ(maxDepth == 2, true);
+    ASSERT_EQ(total.current == 8192 + 2048 && total.eventOomKill == 3, true);
+
+    RemoveCgroup(root + "/app1/sub");
+    RemoveCgroup(root + "/app1");
+    RemoveCgroup(root + "/app2");
+    rmdir(root.c_str());
+}
+
 HWTEST_F(MemInfoTest, GetGraphicsMemory_Test, TestSize.Level1)
 {
     int pid = 1;
@@ -37,6 +37,13 @@ struct PurgMem;
  */
 typedef bool (*PurgMemModifyFunc)(void *, size_t, void *);
 
+/*
+ * Function pointer, it is called when content of a PurgMem obj is found purged.
+ * Input:   struct PurgMem *: the PurgMem obj.
+ * Input:   void *: other private parameters.
+ */
+typedef void (*PurgMemPurgeFunc)(struct PurgMem *, void *);
+
 /*
  * PurgMemCreate: create a PurgMem obj.
  * Input:   @size: data size of a PurgMem obj's content.
@@ -112,6 +119,46 @@ void *PurgMemGetContent(struct PurgMem *purgObj);
  */
 size_t PurgMemGetContentSize(struct PurgMem *purgObj);
 
+/*
+ * PurgMemTryReadOptimistic: copy a small range of a PurgMem obj's content without
+ * PurgMemBeginRead()/PurgMemEndRead().
+ * Only pages of the range are pinned and no lock is taken. The copy is retried if a write
+ * or rebuild ran meanwhile, and falls back to PurgMemBeginRead() if the range is purged
+ * or keeps changing.
+ * Input:   @purgObj: a PurgMem obj.
+ * Input:   @offset: offset of the range in content.
+ * Input:   @len: length of the range.
+ * Output:  @dst: buffer of at least @len bytes.
+ * Return:  true if @dst holds the range, false if the range is invalid or rebuild failed.
+ */
+bool PurgMemTryReadOptimistic(struct PurgMem *purgObj, size_t offset, size_t len, void *dst);
+
+/*
+ * PurgMemSetPrefault: populate all pages of a PurgMem obj at once before it is rebuilt,
+ * instead of faulting them one by one while building. It helps large objects.
+ * Input:   @purgObj: a PurgMem obj.
+ * Input:   @enable: true to prefault, false(default) not to.
+ */
+void PurgMemSetPrefault(struct PurgMem *purgObj, bool enable);
+
+/*
+ * PurgMemRegisterPurgeNotify: notify the owner of a PurgMem obj soon after its content is purged,
+ * so that resources derived from the content can be released. The obj is checked by the
+ * scanner of PmPurgeNotifierStart() or by PmPurgeNotifierScan(), and also counted by the
+ * eventfd of PmPurgeNotifierGetEventFd().
+ * Input:   @purgObj: a PurgMem obj.
+ * Input:   @func: called once per purge, may be NULL to notify by the eventfd only.
+ * Input:   @param: passed to @func.
+ * Return:  register result, true is success, while false is fail.
+ */
+bool PurgMemRegisterPurgeNotify(struct PurgMem *purgObj, PurgMemPurgeFunc func, void *param);
+
+/*
+ * PurgMemUnregisterPurgeNotify: stop notifying, it is done by PurgMemDestroy() too.
+ * Input:   @purgObj: a PurgMem obj.
+ */
+void PurgMemUnregisterPurgeNotify(struct PurgMem *purgObj);
+
 /*
  * PurgMemAppendModify: append a modify to a PurgMem obj.
  * Input:   @purgObj: a PurgMem obj.
@@ -20,6 +20,7 @@
 #include "hilog/log_c.h"
 #include "pm_ptr_util.h"
 #include "pm_log_c.h"
+#include "pm_trace.h"
 #include "purgeable_mem_builder_c.h"
 
 #undef LOG_TAG
@@ -93,7 +94,10 @@ bool PurgMemBuilderBuildAll(struct PurgMemBuilder *builder, void *data, size_t s
         PM_HILOG_ERROR_C(LOG_CORE, "builder has no Build(), %{public}s", builder->name);
         return true;
     }
-    if (!(builder->Build(data, size, builder->param))) {
+    PM_TRACE_BEGIN(builder->name ? builder->name : "PurgMemBuilderBuild", size);
+    bool succ = builder->Build(data, size, builder->param);
+    PM_TRACE_END();
+    if (!succ) {
         PM_HILOG_ERROR_C(LOG_CORE, "build data failed, name %{public}s", builder->name ?: "NULL");
         return false;
     }
@@ -22,6 +22,12 @@
 #include "pm_ptr_util.h"
 #include "pm_util.h"
 #include "pm_state_c.h"
+#include "pm_budget_c.h"
+#include "pm_pin_tracker_c.h"
+#include "pm_prefault_c.h"
+#include "pm_purge_notifier_c.h"
+#include "pm_stats_page_c.h"
+#include "pm_trace.h"
 #include "ux_page_table_c.h"
 #include "purgeable_mem_builder_c.h"
 #include "pm_log_c.h"
@@ -30,6 +36,8 @@
 #undef LOG_TAG
 #define LOG_TAG "PurgeableMemC"
 
+#define OPTIMISTIC_READ_TRYTIMES 3
+
 struct PurgMem {
     void *dataPtr;
     size_t dataSizeInput;
@@ -37,6 +45,13 @@ struct PurgMem {
     UxPageTableStruct *uxPageTable;
     pthread_rwlock_t rwlock;
     unsigned int buildDataCount;
+    unsigned int pinDepth; /* pins held by readers/writers, only 0<->1 walks uxpt */
+    unsigned int writeSeq; /* odd while content is built or written */
+    pthread_mutex_t pinLock; /* serializes 0<->1 transitions of pinDepth */
+    bool prefault; /* populate all pages before rebuild */
+    size_t purgedBytes; /* counted as purged by the stats page */
+    PurgMemPurgeFunc purgeFunc;
+    void *purgeParam;
 };
 
 static inline void LogPurgMemInfo(struct PurgMem *obj)
@@ -66,6 +81,19 @@ static inline size_t RoundUp(size_t val, size_t align)
 static bool IsPurgMemPtrValid(struct PurgMem *purgObj);
 static bool IsPurged(struct PurgMem *purgObj);
 static int TypeCast(void);
+static void PurgMemPin(struct PurgMem *purgObj);
+static void PurgMemUnpin(struct PurgMem *purgObj);
+
+/* writeSeq is odd between these two, called with rwlock held for write */
+static inline void WriteSeqBegin(struct PurgMem *purgObj)
+{
+    __sync_fetch_and_add(&(purgObj->writeSeq), 1);
+}
+
+static inline void WriteSeqEnd(struct PurgMem *purgObj)
+{
+    __sync_fetch_and_add(&(purgObj->writeSeq), 1);
+}
 
 static struct PurgMem *PurgMemCreate_(size_t len, struct PurgMemBuilder *builder)
 {
@@ -77,12 +105,16 @@ static struct PurgMem *PurgMemCreate_(size_t len, struct PurgMemBuilder *builder
         return NULL;
     }
     size_t size = RoundUp(len, PAGE_SIZE);
+    if (!PmBudgetCharge(size)) {
+        PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: exceed purgeable budget", __func__);
+        goto free_pug_obj;
+    }
     int type = TypeCast();
     pugObj->dataPtr = mmap(NULL, size, PROT_READ | PROT_WRITE, type, -1, 0);
     if (pugObj->dataPtr == MAP_FAILED) {
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: mmap dataPtr fail", __func__);
         pugObj->dataPtr = NULL;
-        goto free_pug_obj;
+        goto uncharge;
     }
 
     pugObj->uxPageTable = (UxPageTableStruct *)malloc(UxPageTableSize());
@@ -101,14 +133,28 @@ static struct PurgMem *PurgMemCreate_(size_t len, struct PurgMemBuilder *builder
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: pthread_rwlock_init fail, %{public}d", __func__, lockInitRet);
         goto deinit_upt;
     }
+    lockInitRet = pthread_mutex_init(&(pugObj->pinLock), NULL);
+    if (lockInitRet != 0) {
+        PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: pthread_mutex_init fail, %{public}d", __func__, lockInitRet);
+        goto destroy_rwlock;
+    }
     pugObj->builder = builder;
     pugObj->dataSizeInput = len;
     pugObj->buildDataCount = 0;
+    pugObj->pinDepth = 0;
+    pugObj->writeSeq = 0;
+    pugObj->prefault = false;
+    pugObj->purgedBytes = 0;
+    pugObj->purgeFunc = NULL;
+    pugObj->purgeParam = NULL;
+    PM_TRACE_PURGEABLE(size);
 
     PM_HILOG_INFO_C(LOG_CORE, "%{public}s: LogPurgMemInfo:", __func__);
     LogPurgMemInfo(pugObj);
     return pugObj;
 
+destroy_rwlock:
+    pthread_rwlock_destroy(&(pugObj->rwlock));
 deinit_upt:
     DeinitUxPageTable(pugObj->uxPageTable);
 free_uxpt:
@@ -117,6 +163,8 @@ free_uxpt:
 unmap_data:
     munmap(pugObj->dataPtr, size);
     pugObj->dataPtr = NULL;
+uncharge:
+    PmBudgetUncharge(size);
 free_pug_obj:
     free(pugObj);
     pugObj = NULL;
@@ -126,8 +174,8 @@ free_pug_obj:
 
 struct PurgMem *PurgMemCreate(size_t len, PurgMemModifyFunc func, void *funcPara)
 {
-    if (len == 0) {
-        PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: input len 0", __func__);
+    if (len == 0 || len >= OHOS_MAXIMUM_PURGEABLE_MEMORY) {
+        PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: input len %{public}zu invalid", __func__, len);
         return NULL;
     }
     /* a PurgMemObj must have builder */
@@ -155,6 +203,9 @@ bool PurgMemDestroy(struct PurgMem *purgObj)
     IF_NULL_LOG_ACTION(purgObj, "input is NULL", return true);
     PM_HILOG_INFO_C(LOG_CORE, "%{public}s: LogPurgMemInfo:", __func__);
     LogPurgMemInfo(purgObj);
+    PmPurgeNotifierUnregister(purgObj);
+    PmPinTrackerForget(purgObj);
+    PmStatsPageClearPurged(&(purgObj->purgedBytes));
 
     PMState err = PM_OK;
     /* destroy rwlock */
@@ -162,6 +213,10 @@ bool PurgMemDestroy(struct PurgMem *purgObj)
     if (ret != 0) {
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: pthread_rwlock_destroy fail, %{public}d", __func__, ret);
     }
+    ret = pthread_mutex_destroy(&(purgObj->pinLock));
+    if (ret != 0) {
+        PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: pthread_mutex_destroy fail, %{public}d", __func__, ret);
+    }
     /* destroy builder */
     if (purgObj->builder) {
         if (!PurgMemBuilderDestroy(purgObj->builder)) {
@@ -178,8 +233,10 @@ bool PurgMemDestroy(struct PurgMem *purgObj)
             PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: munmap dataPtr fail", __func__);
             err = PM_UNMAP_PURG_FAIL;
         } else {
+            PmBudgetUncharge(size);
+            PM_TRACE_PURGEABLE(-(long long)size);
             /* double check munmap result: if uxpte is set to no_present */
-            if (UxpteIsEnabled() && !IsPurged(purgObj)) {
+            if (UxpteIsKernel() && !IsPurged(purgObj)) {
                 PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: munmap dataPtr succ, but uxpte present", __func__);
                 err = PM_UXPT_PRESENT_DATA_PURGED;
             }
@@ -222,15 +279,25 @@ static bool IsPurgMemPtrValid(struct PurgMem *purgObj)
 static inline bool PurgMemBuildData(struct PurgMem *purgObj)
 {
     bool succ = false;
+    if (purgObj->prefault) {
+        PM_TRACE_BEGIN("PurgMemPrefault", purgObj->dataSizeInput);
+        PmPrefaultRange(purgObj->dataPtr, RoundUp(purgObj->dataSizeInput, PAGE_SIZE));
+        PM_TRACE_END();
+    }
     /* clear content before rebuild */
     if (memset_s(purgObj->dataPtr, RoundUp(purgObj->dataSizeInput, PAGE_SIZE), 0, purgObj->dataSizeInput) != EOK) {
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s, clear content fail", __func__);
         return succ;
     }
     /* @purgObj->builder is not NULL since it is checked by IsPurgMemPtrValid() before */
+    PM_TRACE_BEGIN("PurgMemBuildAll", purgObj->dataSizeInput);
     succ = PurgMemBuilderBuildAll(purgObj->builder, purgObj->dataPtr, purgObj->dataSizeInput);
+    PM_TRACE_END();
+    PmStatsPageOnBuild(purgObj->buildDataCount != 0, succ);
     if (succ) {
-        purgObj->buildDataCount++;
+        __sync_fetch_and_add(&(purgObj->buildDataCount), 1);
+        UxpteMarkPresent(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+        PmStatsPageClearPurged(&(purgObj->purgedBytes));
     }
     return succ;
 }
@@ -268,7 +335,11 @@ static PMState BeginReadBuildData(struct PurgMem *purgObj)
     }
 
     if (IsPurged(purgObj)) {
+        PM_TRACE_BEGIN("PurgMemRebuild", purgObj->dataSizeInput);
+        WriteSeqBegin(purgObj);
         rebuildRet = PurgMemBuildData(purgObj);
+        WriteSeqEnd(purgObj);
+        PM_TRACE_END();
         PM_HILOG_ERROR_C(LOG_CORE,
             "%{public}s: purged, after built %{public}s", __func__, rebuildRet ? "succ" : "fail");
     }
@@ -296,7 +367,8 @@ bool PurgMemBeginRead(struct PurgMem *purgObj)
     LogPurgMemInfo(purgObj);
     bool ret = false;
     PMState err = PM_OK;
-    UxpteGet(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+    PM_TRACE_BEGIN("PurgMemBeginRead", purgObj->dataSizeInput);
+    PurgMemPin(purgObj);
     while (true) {
         err = TryBeginRead(purgObj);
         if (err == PM_DATA_NO_PURGED) {
@@ -315,8 +387,11 @@ bool PurgMemBeginRead(struct PurgMem *purgObj)
 
     if (!ret) {
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: %{public}s, UxptePut.", __func__, GetPMStateName(err));
-        UxptePut(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+        PurgMemUnpin(purgObj);
+    } else {
+        PmPinTrackerOnPin(purgObj, purgObj->dataSizeInput, __builtin_return_address(0));
     }
+    PM_TRACE_END();
     return ret;
 }
 
@@ -332,36 +407,47 @@ bool PurgMemBeginWrite(struct PurgMem *purgObj)
     bool rebuildRet = false;
     PMState err = PM_OK;
 
-    UxpteGet(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+    PM_TRACE_BEGIN("PurgMemBeginWrite", purgObj->dataSizeInput);
+    PurgMemPin(purgObj);
 
     rwlockRet = pthread_rwlock_wrlock(&(purgObj->rwlock));
     if (rwlockRet != 0) {
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: wrlock fail. %{public}d", __func__, rwlockRet);
         err = PM_LOCK_WRITE_FAIL;
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: %{public}s, return false, UxptePut.", __func__, GetPMStateName(err));
-        UxptePut(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+        PurgMemUnpin(purgObj);
+        PM_TRACE_END();
         return false;
     }
+    WriteSeqBegin(purgObj);
 
     if (!IsPurged(purgObj)) {
+        PmPinTrackerOnPin(purgObj, purgObj->dataSizeInput, __builtin_return_address(0));
+        PM_TRACE_END();
         return true;
     }
 
     /* data is purged */
+    PM_TRACE_BEGIN("PurgMemRebuild", purgObj->dataSizeInput);
     rebuildRet = PurgMemBuildData(purgObj);
+    PM_TRACE_END();
     PM_HILOG_INFO_C(LOG_CORE, "%{public}s: purged, built %{public}s", __func__, rebuildRet ? "succ" : "fail");
     if (rebuildRet) {
+        PmPinTrackerOnPin(purgObj, purgObj->dataSizeInput, __builtin_return_address(0));
+        PM_TRACE_END();
         return true;
     }
     /* data is purged and rebuild failed. return false */
     err = PMB_BUILD_ALL_FAIL;
+    WriteSeqEnd(purgObj);
     rwlockRet = pthread_rwlock_unlock(&(purgObj->rwlock));
     if (rwlockRet != 0) {
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: wr unlock fail. %{public}d", __func__, rwlockRet);
     }
 
     PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: %{public}s, return false, UxptePut.", __func__, GetPMStateName(err));
-    UxptePut(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+    PurgMemUnpin(purgObj);
+    PM_TRACE_END();
     return false;
 }
 
@@ -376,7 +462,8 @@ static inline void EndAccessPurgMem(struct PurgMem *purgObj)
     if (rwlockRet != 0) {
         PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: unlock fail. %{public}d", __func__, rwlockRet);
     }
-    UxptePut(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+    PmPinTrackerOnUnpin(purgObj);
+    PurgMemUnpin(purgObj);
 }
 
 void PurgMemEndRead(struct PurgMem *purgObj)
@@ -386,6 +473,9 @@ void PurgMemEndRead(struct PurgMem *purgObj)
 
 void PurgMemEndWrite(struct PurgMem *purgObj)
 {
+    if (IsPurgMemPtrValid(purgObj)) {
+        WriteSeqEnd(purgObj);
+    }
     EndAccessPurgMem(purgObj);
 }
 
@@ -407,6 +497,93 @@ size_t PurgMemGetContentSize(struct PurgMem *purgObj)
     return purgObj->dataSizeInput;
 }
 
+void PurgMemSetPrefault(struct PurgMem *purgObj, bool enable)
+{
+    IF_NULL_LOG_ACTION(purgObj, "input purgObj is NULL", return);
+    purgObj->prefault = enable;
+}
+
+/* unlike IsPurged(), content never built is not purged. Content found purged counts in the stats page */
+static unsigned int PurgMemPurgedBuild(void *obj)
+{
+    struct PurgMem *purgObj = (struct PurgMem *)obj;
+    unsigned int builds = __sync_fetch_and_add(&(purgObj->buildDataCount), 0);
+    if (builds == 0 ||
+        UxpteIsPresent(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput)) {
+        return 0;
+    }
+    PmStatsPageMarkPurged(&(purgObj->purgedBytes), &(purgObj->buildDataCount), builds,
+        RoundUp(purgObj->dataSizeInput, PAGE_SIZE));
+    return builds;
+}
+
+static void PurgMemOnPurged(void *obj, void *param)
+{
+    (void)param;
+    struct PurgMem *purgObj = (struct PurgMem *)obj;
+    purgObj->purgeFunc(purgObj, purgObj->purgeParam);
+}
+
+bool PurgMemRegisterPurgeNotify(struct PurgMem *purgObj, PurgMemPurgeFunc func, void *param)
+{
+    if (!IsPurgMemPtrValid(purgObj)) {
+        PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: para is invalid", __func__);
+        return false;
+    }
+    purgObj->purgeFunc = func;
+    purgObj->purgeParam = param;
+    return PmPurgeNotifierRegister(purgObj, PurgMemPurgedBuild, func ? PurgMemOnPurged : NULL, NULL);
+}
+
+void PurgMemUnregisterPurgeNotify(struct PurgMem *purgObj)
+{
+    IF_NULL_LOG_ACTION(purgObj, "input purgObj is NULL", return);
+    PmPurgeNotifierUnregister(purgObj);
+}
+
+/* seqlock style read: pin only pages of the range, copy, then check no writer ran */
+static bool TryReadRange(struct PurgMem *purgObj, size_t offset, size_t len, void *dst)
+{
+    unsigned int seq = __sync_fetch_and_add(&(purgObj->writeSeq), 0);
+    if ((seq & 1) != 0 || purgObj->buildDataCount == 0) {
+        return false;
+    }
+    uint64_t addr = (uint64_t)(purgObj->dataPtr) + offset;
+    bool succ = false;
+    UxpteGet(purgObj->uxPageTable, addr, len);
+    if (UxpteIsPresent(purgObj->uxPageTable, addr, len) &&
+        memcpy_s(dst, len, (char *)(purgObj->dataPtr) + offset, len) == EOK) {
+        __sync_synchronize();
+        succ = (__sync_fetch_and_add(&(purgObj->writeSeq), 0) == seq);
+    }
+    UxptePut(purgObj->uxPageTable, addr, len);
+    return succ;
+}
+
+bool PurgMemTryReadOptimistic(struct PurgMem *purgObj, size_t offset, size_t len, void *dst)
+{
+    if (!IsPurgMemPtrValid(purgObj) || dst == NULL || offset > purgObj->dataSizeInput ||
+        len > purgObj->dataSizeInput - offset) {
+        PM_HILOG_ERROR_C(LOG_CORE, "%{public}s: para is invalid", __func__);
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+    for (int i = 0; i < OPTIMISTIC_READ_TRYTIMES; i++) {
+        if (TryReadRange(purgObj, offset, len, dst)) {
+            return true;
+        }
+    }
+    /* purged or busy, fall back to the pinned path which may rebuild */
+    if (!PurgMemBeginRead(purgObj)) {
+        return false;
+    }
+    bool succ = (memcpy_s(dst, len, (char *)(purgObj->dataPtr) + offset, len) == EOK);
+    PurgMemEndRead(purgObj);
+    return succ;
+}
+
 bool PurgMemAppendModify(struct PurgMem *purgObj, PurgMemModifyFunc func, void *funcPara)
 {
     IF_NULL_LOG_ACTION(func, "input func is NULL", return true);
@@ -426,6 +603,47 @@ bool PurgMemAppendModify(struct PurgMem *purgObj, PurgMemModifyFunc func, void *
     return PurgMemBuilderAppendBuilder(purgObj->builder, builder);
 }
 
+/* nested or concurrent pins only count, the first pin walks uxpt */
+static void PurgMemPin(struct PurgMem *purgObj)
+{
+    unsigned int depth = __sync_fetch_and_add(&(purgObj->pinDepth), 0);
+    while (depth > 0) {
+        unsigned int old = __sync_val_compare_and_swap(&(purgObj->pinDepth), depth, depth + 1);
+        if (old == depth) {
+            return;
+        }
+        depth = old;
+    }
+    pthread_mutex_lock(&(purgObj->pinLock));
+    if (__sync_fetch_and_add(&(purgObj->pinDepth), 0) == 0) {
+        UxpteGet(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+        PM_TRACE_PINNED(purgObj->dataSizeInput);
+        PmStatsPageAddPinned((long long)RoundUp(purgObj->dataSizeInput, PAGE_SIZE));
+    }
+    __sync_fetch_and_add(&(purgObj->pinDepth), 1);
+    pthread_mutex_unlock(&(purgObj->pinLock));
+}
+
+/* the last unpin walks uxpt, others only count */
+static void PurgMemUnpin(struct PurgMem *purgObj)
+{
+    unsigned int depth = __sync_fetch_and_add(&(purgObj->pinDepth), 0);
+    while (depth > 1) {
+        unsigned int old = __sync_val_compare_and_swap(&(purgObj->pinDepth), depth, depth - 1);
+        if (old == depth) {
+            return;
+        }
+        depth = old;
+    }
+    pthread_mutex_lock(&(purgObj->pinLock));
+    if (__sync_sub_and_fetch(&(purgObj->pinDepth), 1) == 0) {
+        UxptePut(purgObj->uxPageTable, (uint64_t)(purgObj->dataPtr), purgObj->dataSizeInput);
+        PM_TRACE_PINNED(-(long long)purgObj->dataSizeInput);
+        PmStatsPageAddPinned(-(long long)RoundUp(purgObj->dataSizeInput, PAGE_SIZE));
+    }
+    pthread_mutex_unlock(&(purgObj->pinLock));
+}
+
 static bool IsPurged(struct PurgMem *purgObj)
 {
     /* first access, return true means purged */
@@ -439,7 +657,7 @@ static bool IsPurged(struct PurgMem *purgObj)
 static int TypeCast(void)
 {
     unsigned int utype = MAP_ANONYMOUS;
-    utype |= (UxpteIsEnabled() ? MAP_PURGEABLE : MAP_PRIVATE);
+    utype |= (UxpteIsKernel() ? MAP_PURGEABLE : MAP_PRIVATE);
     int type = (int) utype;
     return type;
 }
\ No newline at end of file
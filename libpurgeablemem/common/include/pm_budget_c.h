@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_BUDGET_C_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_BUDGET_C_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* size_t */
+
+/* size limit of a single purgeable object */
+#ifndef OHOS_MAXIMUM_PURGEABLE_MEMORY
+#define OHOS_MAXIMUM_PURGEABLE_MEMORY ((1024) * (1024) * (1024)) /* 1G */
+#endif /* OHOS_MAXIMUM_PURGEABLE_MEMORY */
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+/*
+ * Process budget of purgeable memory: bytes of all purgeable objects of this process,
+ * counted in pages when they are mapped, no matter whether purged or not.
+ * Creating an object which exceeds the budget asks the trimmers to release cold objects
+ * first, and fails if they can not.
+ */
+
+/* PmBudgetSetLimit: set the budget, 0 means unlimited(default). Current objects are kept. */
+void PmBudgetSetLimit(size_t limit);
+size_t PmBudgetGetLimit(void);
+size_t PmBudgetGetUsage(void);
+
+/*
+ * PmBudgetTrimFunc: release cold purgeable objects of its owner.
+ * Input:   @bytes: bytes needed, @param: registered with the func.
+ * Return:  bytes released.
+ * It is called without any lock of libpurgeablemem held, and may destroy purgeable objects.
+ */
+typedef size_t (*PmBudgetTrimFunc)(size_t bytes, void *param);
+
+/* PmBudgetAddTrimmer: return false if @func is NULL or too many trimmers */
+bool PmBudgetAddTrimmer(PmBudgetTrimFunc func, void *param);
+void PmBudgetRemoveTrimmer(PmBudgetTrimFunc func, void *param);
+
+/*
+ * PmBudgetCharge: account @bytes of a new object, trim others if the budget is exceeded.
+ * Return:  false if @bytes exceeds the budget even after trim, nothing is charged then.
+ */
+bool PmBudgetCharge(size_t bytes);
+void PmBudgetUncharge(size_t bytes);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_BUDGET_C_H */
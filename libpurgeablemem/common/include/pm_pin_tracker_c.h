@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PIN_TRACKER_C_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PIN_TRACKER_C_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+/*
+ * Pin tracker: opt-in debugging aid of libpurgeablemem.
+ * A pinned object can not be reclaimed, so objects pinned for long (missing EndRead,
+ * pinned across IPC, ...) defeat purgeability. When enabled, each outermost pin of a
+ * purgeable object is recorded with its timestamp and call site, pin durations are
+ * kept in a log2 histogram, and a watchdog reports pins longer than a threshold.
+ */
+
+/* bucket 0 counts pins shorter than 1us, bucket i counts [2^(i-1), 2^i) us, the last one the rest */
+#define PM_PIN_HIST_BUCKETS 24
+
+typedef struct {
+    const void *obj; /* the purgeable object */
+    size_t size; /* content size, i.e. bytes stuck pinned */
+    const void *caller; /* return address of the BeginRead/BeginWrite call */
+    uint64_t pinnedMs; /* pinned for how long */
+} PmLongPinInfo;
+
+/* called once per long pin, from the watchdog thread or PmPinTrackerCheck() */
+typedef void (*PmLongPinFunc)(const PmLongPinInfo *info, void *param);
+
+/*
+ * PmPinTrackerEnable: start tracking pins, and the watchdog if @thresholdMs > 0.
+ * Input:   @thresholdMs: pins longer than it are long pins.
+ * Input:   @func: long pin callback, long pins are logged if it is NULL.
+ * Input:   @param: passed to @func.
+ * Return:  false if tracker is enabled already or watchdog fails to start.
+ */
+bool PmPinTrackerEnable(unsigned int thresholdMs, PmLongPinFunc func, void *param);
+
+/* PmPinTrackerDisable: stop the watchdog and forget all pins, histogram is kept */
+void PmPinTrackerDisable(void);
+
+bool PmPinTrackerIsEnabled(void);
+
+/*
+ * PmPinTrackerCheck: report long pins not reported yet.
+ * Return:  bytes of all long pins, i.e. reclaimable memory lost now.
+ */
+size_t PmPinTrackerCheck(void);
+
+/* PmPinTrackerGetHistogram: copy at most @count buckets, return number copied */
+size_t PmPinTrackerGetHistogram(uint64_t *buckets, size_t count);
+
+void PmPinTrackerResetHistogram(void);
+
+/* PmPinTrackerDump: log histogram and current long pins to hilog */
+void PmPinTrackerDump(void);
+
+/*
+ * Hooks of pin/unpin, nested pins of @obj are counted and only the outermost one is timed.
+ * They return at once if the tracker is disabled.
+ */
+void PmPinTrackerOnPin(const void *obj, size_t size, const void *caller);
+void PmPinTrackerOnUnpin(const void *obj);
+/* PmPinTrackerForget: @obj is destroyed, drop its record if any */
+void PmPinTrackerForget(const void *obj);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PIN_TRACKER_C_H */
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PREFAULT_C_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PREFAULT_C_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* size_t */
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+/*
+ * PmPrefaultRange: populate writable pages of [@addr, @addr + @len) in one go, so that a
+ * rebuild does not take a page fault per page.
+ * MADV_POPULATE_WRITE is used if the kernel supports it, otherwise every page is touched,
+ * as well as in a mapping which rejects MADV_POPULATE_WRITE.
+ * Content of present pages is kept.
+ * Input:   @addr: page aligned start address of a mapping, @len: length in bytes.
+ * Return:  true if all pages are populated.
+ */
+bool PmPrefaultRange(void *addr, size_t len);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PREFAULT_C_H */
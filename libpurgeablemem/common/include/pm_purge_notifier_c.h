@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PURGE_NOTIFIER_C_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PURGE_NOTIFIER_C_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* size_t */
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+/*
+ * Purge notifier: tell the owner of a purgeable object soon after its content is reclaimed,
+ * instead of at the next BeginRead, so that resources derived from the content can be
+ * released early. The kernel does not notify reclaim of purgeable memory, so registered
+ * objects are scanned for presence by a low-frequency scanner thread, or by
+ * PmPurgeNotifierScan(). A present object found purged is notified once, by its callback
+ * and by the process-wide eventfd, and again if it is purged again after rebuilt.
+ * With the MADV_FREE fallback of uxpt, an unpinned page freed by kernel is found by mincore().
+ */
+
+/*
+ * PmPurgedCheckFunc: check @obj without pinning it.
+ * Return:  the number of builds of @obj if its content is purged now, 0 if it is present or never built.
+ *          Each build of @obj is notified at most once.
+ */
+typedef unsigned int (*PmPurgedCheckFunc)(void *obj);
+
+/*
+ * PmPurgeFunc: called once @obj is found purged, from the scanner thread or PmPurgeNotifierScan().
+ * It may unregister or destroy @obj, but must not wait for other callbacks.
+ */
+typedef void (*PmPurgeFunc)(void *obj, void *param);
+
+/*
+ * PmPurgeNotifierRegister: watch @obj, register again to replace @func and @param.
+ * Input:   @check: presence check of @obj.
+ * Input:   @func: callback, may be NULL to notify by the eventfd only.
+ * Return:  false if @obj or @check is NULL, or malloc fails.
+ */
+bool PmPurgeNotifierRegister(void *obj, PmPurgedCheckFunc check, PmPurgeFunc func, void *param);
+
+/*
+ * PmPurgeNotifierUnregister: stop watching @obj. Once it returns, no callback of @obj is running,
+ * or it is called by that callback. It must be called before @obj is freed.
+ */
+void PmPurgeNotifierUnregister(void *obj);
+
+/*
+ * PmPurgeNotifierGetEventFd: get the process-wide eventfd, which is never closed.
+ * Reading it returns the number of objects found purged since the last read.
+ * Return:  the eventfd, -1 if it can not be created.
+ */
+int PmPurgeNotifierGetEventFd(void);
+
+/*
+ * PmPurgeNotifierScan: check all registered objects once and notify the ones found purged.
+ * Return:  number of objects found purged.
+ */
+size_t PmPurgeNotifierScan(void);
+
+/*
+ * PmPurgeNotifierStart: start the scanner thread.
+ * Input:   @intervalMs: interval of scans, 1000 or more is recommended as every scan walks
+ *          page tables of all registered objects.
+ * Return:  false if @intervalMs is 0, the scanner is running already or fails to start.
+ */
+bool PmPurgeNotifierStart(unsigned int intervalMs);
+
+/* PmPurgeNotifierStop: stop the scanner thread, objects are kept registered */
+void PmPurgeNotifierStop(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_PURGE_NOTIFIER_C_H */
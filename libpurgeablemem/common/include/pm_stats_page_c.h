@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_STATS_PAGE_C_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_STATS_PAGE_C_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* size_t */
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+/*
+ * PmStatsPageEnable: publish counters of purgeable memory of this process in a stats page,
+ * see mem_stats_page.h of libmeminfo. Bytes start from PmBudgetGetUsage() and the pinned and
+ * purged bytes of this process, build counters start from 0. A child forked later publishes
+ * a page of its own in the same way.
+ * Return:  true if the page is published, calling it again is a no-op.
+ */
+bool PmStatsPageEnable(void);
+
+/* called by libpurgeablemem, no-op unless the page is published */
+void PmStatsPageAddBytes(long long delta);
+void PmStatsPageOnBuild(bool rebuild, bool succ);
+
+/* called on the outermost pin and unpin of an object, kept even if the page is not published */
+void PmStatsPageAddPinned(long long delta);
+
+/*
+ * Purged bytes: an object counts as purged from the time it is found purged, by a purge of
+ * libpurgeablemem or by the purge notifier, until its content is built again or it is destroyed.
+ * Kernel reclaim of an object not watched by the notifier is seen by its next rebuild only.
+ * @purgedBytes of the object keeps the bytes it counts, 0 if it is not counted.
+ * PmStatsPageMarkPurged: count the object, whose content of build @build is found purged, as
+ * @size bytes. Nothing is counted if @build is 0 or @builds, the build count of the object, is not
+ * @build any more, so that a rebuild running meanwhile does not leave it counted.
+ * PmStatsPageClearPurged: stop counting the object, call it after content is built or before it is freed.
+ */
+void PmStatsPageMarkPurged(size_t *purgedBytes, const unsigned int *builds, unsigned int build, size_t size);
+void PmStatsPageClearPurged(size_t *purgedBytes);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_STATS_PAGE_C_H */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_TRACE_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_TRACE_H
+
+#include <stddef.h> /* size_t */
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+/*
+ * HiTrace of libpurgeablemem, usable from both C and C++.
+ * Compiled out unless PURGEABLE_TRACE_ENABLE is defined,
+ * see memory_utils_purgeable_trace_enable in purgeable_mem_config.gni.
+ */
+#ifdef PURGEABLE_TRACE_ENABLE
+
+/* PmTraceBegin: begin a span named "@name size:@size", size 0 is not shown, no-op unless the tag is enabled. */
+void PmTraceBegin(const char *name, size_t size);
+void PmTraceEnd(void);
+
+/* update counter traces "PurgPinnedBytes" and "PurgTotalBytes" of this process */
+void PmTraceAddPinnedBytes(long long delta);
+void PmTraceAddPurgeableBytes(long long delta);
+
+#define PM_TRACE_BEGIN(name, size) PmTraceBegin((name), (size))
+#define PM_TRACE_END() PmTraceEnd()
+#define PM_TRACE_PINNED(delta) PmTraceAddPinnedBytes((long long)(delta))
+#define PM_TRACE_PURGEABLE(delta) PmTraceAddPurgeableBytes((long long)(delta))
+
+#else /* PURGEABLE_TRACE_ENABLE */
+
+#define PM_TRACE_BEGIN(name, size) ((void)0)
+#define PM_TRACE_END() ((void)0)
+#define PM_TRACE_PINNED(delta) ((void)0)
+#define PM_TRACE_PURGEABLE(delta) ((void)0)
+
+#endif /* PURGEABLE_TRACE_ENABLE */
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+
+#ifdef PURGEABLE_TRACE_ENABLE
+/* span of the enclosing scope */
+class PmTraceScope {
+public:
+    PmTraceScope(const char *name, size_t size)
+    {
+        PmTraceBegin(name, size);
+    }
+    ~PmTraceScope()
+    {
+        PmTraceEnd();
+    }
+    PmTraceScope(const PmTraceScope &) = delete;
+    PmTraceScope &operator=(const PmTraceScope &) = delete;
+};
+#define PM_TRACE_SCOPE(name, size) PmTraceScope pmTraceScope_((name), (size))
+#else
+#define PM_TRACE_SCOPE(name, size) ((void)0)
+#endif /* PURGEABLE_TRACE_ENABLE */
+#endif /* End of #ifdef __cplusplus */
+
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_COMMON_INCLUDE_PM_TRACE_H */
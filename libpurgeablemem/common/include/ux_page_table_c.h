@@ -33,6 +33,15 @@ typedef struct UserExtendPageTable UxPageTableStruct;
 bool UxpteIsEnabled(void);
 size_t UxPageTableSize(void);
 
+/* true if uxpt is maintained by kernel, and purgeable data should be mapped with MAP_PURGEABLE */
+bool UxpteIsKernel(void);
+
+/*
+ * true if kernel has no uxpt and the MADV_FREE fallback is used: unpinned pages are MADV_FREE'd
+ * with a canary in their first word, a page is purged if the canary is gone when pinned again.
+ */
+bool UxpteIsLazyFree(void);
+
 PMState InitUxPageTable(UxPageTableStruct *upt, uint64_t addr, size_t len);
 PMState DeinitUxPageTable(UxPageTableStruct *upt);
 
@@ -40,6 +49,48 @@ void UxpteGet(UxPageTableStruct *upt, uint64_t addr, size_t len);
 void UxptePut(UxPageTableStruct *upt, uint64_t addr, size_t len);
 void UxpteClear(UxPageTableStruct *upt, uint64_t addr, size_t len);
 bool UxpteIsPresent(UxPageTableStruct *upt, uint64_t addr, size_t len);
+/* mark pinned pages present after content is built, only needed by the MADV_FREE fallback */
+void UxpteMarkPresent(UxPageTableStruct *upt, uint64_t addr, size_t len);
+
+/*
+ * Userspace uxpt emulator, for kernels without MAP_PURGEABLE/MAP_USEREXPTE.
+ * uxptes live in an anonymous array, purgeable data is plain anonymous memory,
+ * and a reclaimer drops pages whose refcount is zero via MADV_DONTNEED.
+ * A page is present if it is resident, just like the kernel sets the present bit on fault.
+ * It is meant for testing and benchmarking purge/rebuild paths on stock Linux.
+ */
+
+/*
+ * UxptEmuEnable: switch uxpt to the userspace emulator.
+ * Return:  true if the emulator is enabled. Fail if kernel supports uxpt,
+ *          or if any purgeable obj has been created.
+ */
+bool UxptEmuEnable(void);
+
+/*
+ * UxptEmuDisable: stop the reclaimer and switch back to the mode probed at load time.
+ * Return:  true if the emulator is disabled. Fail if any purgeable obj exists.
+ */
+bool UxptEmuDisable(void);
+
+/* true if uxpt is maintained by the userspace emulator */
+bool UxpteIsEmulated(void);
+
+/*
+ * UxptEmuReclaim: drop unpinned resident pages of all purgeable objs once.
+ * Input:   @maxPages: max pages to drop, 0 means no limit.
+ * Return:  number of pages dropped.
+ */
+size_t UxptEmuReclaim(size_t maxPages);
+
+/*
+ * UxptEmuStartReclaimer: start a thread calling UxptEmuReclaim(@pagesPerRound) every @intervalMs.
+ * Return:  true if the thread is running.
+ */
+bool UxptEmuStartReclaimer(unsigned int intervalMs, size_t pagesPerRound);
+
+/* UxptEmuStopReclaimer: stop and join the reclaimer thread. */
+void UxptEmuStopReclaimer(void);
 
 #ifdef __cplusplus
 #if __cplusplus
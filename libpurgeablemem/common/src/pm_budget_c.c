@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h> /* NULL */
+#include <pthread.h>
+
+#include "hilog/log_c.h"
+#include "pm_budget_c.h"
+#include "pm_stats_page_c.h"
+
+#undef LOG_TAG
+#define LOG_TAG "PurgeableMemC: Budget"
+
+#define PM_BUDGET_TRIMMER_MAX 8
+
+typedef struct {
+    PmBudgetTrimFunc func;
+    void *param;
+} PmBudgetTrimmer;
+
+static size_t g_budgetLimit = 0; /* 0: unlimited */
+static size_t g_budgetUsage = 0;
+
+static pthread_mutex_t g_trimmerLock = PTHREAD_MUTEX_INITIALIZER; /* protects g_trimmers */
+static PmBudgetTrimmer g_trimmers[PM_BUDGET_TRIMMER_MAX];
+static size_t g_trimmerCount = 0;
+
+void PmBudgetSetLimit(size_t limit)
+{
+    __sync_lock_test_and_set(&g_budgetLimit, limit);
+}
+
+size_t PmBudgetGetLimit(void)
+{
+    return __sync_fetch_and_add(&g_budgetLimit, 0);
+}
+
+size_t PmBudgetGetUsage(void)
+{
+    return __sync_fetch_and_add(&g_budgetUsage, 0);
+}
+
+bool PmBudgetAddTrimmer(PmBudgetTrimFunc func, void *param)
+{
+    if (func == NULL) {
+        return false;
+    }
+    bool ret = false;
+    pthread_mutex_lock(&g_trimmerLock);
+    if (g_trimmerCount < PM_BUDGET_TRIMMER_MAX) {
+        g_trimmers[g_trimmerCount].func = func;
+        g_trimmers[g_trimmerCount].param = param;
+        g_trimmerCount++;
+        ret = true;
+    }
+    pthread_mutex_unlock(&g_trimmerLock);
+    if (!ret) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: too many trimmers", __func__);
+    }
+    return ret;
+}
+
+void PmBudgetRemoveTrimmer(PmBudgetTrimFunc func, void *param)
+{
+    pthread_mutex_lock(&g_trimmerLock);
+    for (size_t i = 0; i < g_trimmerCount; i++) {
+        if (g_trimmers[i].func == func && g_trimmers[i].param == param) {
+            g_trimmers[i] = g_trimmers[g_trimmerCount - 1];
+            g_trimmerCount--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_trimmerLock);
+}
+
+/* return bytes over budget if @bytes is charged, 0 means charged */
+static size_t TryCharge(size_t bytes)
+{
+    size_t usage = __sync_fetch_and_add(&g_budgetUsage, 0);
+    while (true) {
+        size_t limit = PmBudgetGetLimit();
+        if (usage + bytes < usage) {
+            return bytes;
+        }
+        if (limit != 0 && usage + bytes > limit) {
+            return usage + bytes - limit;
+        }
+        size_t old = __sync_val_compare_and_swap(&g_budgetUsage, usage, usage + bytes);
+        if (old == usage) {
+            return 0;
+        }
+        usage = old;
+    }
+}
+
+static void Trim(size_t bytes)
+{
+    PmBudgetTrimmer trimmers[PM_BUDGET_TRIMMER_MAX];
+    pthread_mutex_lock(&g_trimmerLock);
+    size_t count = g_trimmerCount;
+    for (size_t i = 0; i < count; i++) {
+        trimmers[i] = g_trimmers[i];
+    }
+    pthread_mutex_unlock(&g_trimmerLock);
+
+    /* trimmers may destroy objects, which uncharges */
+    size_t released = 0;
+    for (size_t i = 0; i < count && released < bytes; i++) {
+        released += trimmers[i].func(bytes - released, trimmers[i].param);
+    }
+    HILOG_DEBUG(LOG_CORE, "%{public}s: need %{public}zu, released %{public}zu", __func__, bytes, released);
+}
+
+bool PmBudgetCharge(size_t bytes)
+{
+    size_t over = TryCharge(bytes);
+    if (over == 0) {
+        PmStatsPageAddBytes((long long)bytes);
+        return true;
+    }
+    Trim(over);
+    over = TryCharge(bytes);
+    if (over != 0) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: %{public}zu bytes over budget %{public}zu, usage %{public}zu",
+            __func__, over, PmBudgetGetLimit(), PmBudgetGetUsage());
+        return false;
+    }
+    PmStatsPageAddBytes((long long)bytes);
+    return true;
+}
+
+void PmBudgetUncharge(size_t bytes)
+{
+    __sync_fetch_and_sub(&g_budgetUsage, bytes);
+    PmStatsPageAddBytes(-(long long)bytes);
+}
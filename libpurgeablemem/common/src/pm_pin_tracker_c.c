@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* malloc */
+#include <pthread.h>
+#include <time.h> /* clock_gettime */
+#include <unistd.h> /* usleep() */
+
+#include "hilog/log_c.h"
+#include "pm_pin_tracker_c.h"
+
+#undef LOG_TAG
+#define LOG_TAG "PurgeableMemC: PinTracker"
+
+#define PIN_HASH_BUCKETS 256
+#define LONG_PIN_REPORT_MAX 16 /* long pins reported per round, others are left to next round */
+
+typedef struct PinRecord {
+    const void *obj;
+    size_t size;
+    const void *caller;
+    uint64_t pinTimeNs;
+    unsigned int depth;
+    bool reported;
+    struct PinRecord *next;
+} PinRecord;
+
+static pthread_mutex_t g_pinLock = PTHREAD_MUTEX_INITIALIZER; /* protects all below except g_trackEnabled */
+static bool g_trackEnabled = false;
+static PinRecord *g_pinTable[PIN_HASH_BUCKETS];
+static uint64_t g_pinHist[PM_PIN_HIST_BUCKETS];
+static unsigned int g_thresholdMs = 0;
+static PmLongPinFunc g_longPinFunc = NULL;
+static void *g_longPinParam = NULL;
+
+static pthread_mutex_t g_watchdogLock = PTHREAD_MUTEX_INITIALIZER; /* protects watchdog start/stop */
+static pthread_t g_watchdog;
+static bool g_watchdogRunning = false;
+static volatile bool g_watchdogStop = false;
+
+static const uint64_t NSEC_PER_USEC = 1000;
+static const uint64_t NSEC_PER_MSEC = 1000000;
+static const uint64_t NSEC_PER_SEC = 1000000000;
+static const unsigned int USEC_PER_MSEC = 1000;
+static const unsigned int WATCHDOG_MAX_SLEEP_MS = 100; /* bound the latency of PmPinTrackerDisable() */
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static inline size_t PinHash(const void *obj)
+{
+    uintptr_t key = (uintptr_t)obj;
+    return (size_t)((key >> 4) ^ (key >> 12)) % PIN_HASH_BUCKETS; /* objects are at least 16B aligned */
+}
+
+static PinRecord **FindRecord(const void *obj)
+{
+    PinRecord **pp = &g_pinTable[PinHash(obj)];
+    while (*pp && (*pp)->obj != obj) {
+        pp = &((*pp)->next);
+    }
+    return pp;
+}
+
+static size_t HistBucket(uint64_t durationNs)
+{
+    uint64_t us = durationNs / NSEC_PER_USEC;
+    if (us == 0) {
+        return 0;
+    }
+    size_t bucket = (size_t)(64 - __builtin_clzll(us)); /* 64: bits of uint64_t */
+    return bucket < PM_PIN_HIST_BUCKETS ? bucket : PM_PIN_HIST_BUCKETS - 1;
+}
+
+/* call with g_pinLock held */
+static void ClearRecords(void)
+{
+    for (size_t i = 0; i < PIN_HASH_BUCKETS; i++) {
+        PinRecord *rec = g_pinTable[i];
+        while (rec) {
+            PinRecord *next = rec->next;
+            free(rec);
+            rec = next;
+        }
+        g_pinTable[i] = NULL;
+    }
+}
+
+void PmPinTrackerOnPin(const void *obj, size_t size, const void *caller)
+{
+    if (!__atomic_load_n(&g_trackEnabled, __ATOMIC_RELAXED) || obj == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&g_pinLock);
+    if (!g_trackEnabled) {
+        goto unlock;
+    }
+    PinRecord **pp = FindRecord(obj);
+    if (*pp) {
+        (*pp)->depth++;
+        goto unlock;
+    }
+    PinRecord *rec = (PinRecord *)malloc(sizeof(PinRecord));
+    if (rec == NULL) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: malloc fail", __func__);
+        goto unlock;
+    }
+    rec->obj = obj;
+    rec->size = size;
+    rec->caller = caller;
+    rec->pinTimeNs = NowNs();
+    rec->depth = 1;
+    rec->reported = false;
+    rec->next = NULL;
+    *pp = rec;
+unlock:
+    pthread_mutex_unlock(&g_pinLock);
+}
+
+void PmPinTrackerOnUnpin(const void *obj)
+{
+    if (!__atomic_load_n(&g_trackEnabled, __ATOMIC_RELAXED) || obj == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&g_pinLock);
+    PinRecord **pp = FindRecord(obj);
+    PinRecord *rec = *pp;
+    if (rec == NULL) { /* pinned before tracker enabled */
+        goto unlock;
+    }
+    if (--(rec->depth) > 0) {
+        goto unlock;
+    }
+    g_pinHist[HistBucket(NowNs() - rec->pinTimeNs)]++;
+    *pp = rec->next;
+    free(rec);
+unlock:
+    pthread_mutex_unlock(&g_pinLock);
+}
+
+void PmPinTrackerForget(const void *obj)
+{
+    if (!__atomic_load_n(&g_trackEnabled, __ATOMIC_RELAXED) || obj == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&g_pinLock);
+    PinRecord **pp = FindRecord(obj);
+    PinRecord *rec = *pp;
+    if (rec) {
+        *pp = rec->next;
+        free(rec);
+    }
+    pthread_mutex_unlock(&g_pinLock);
+}
+
+static void LogLongPin(const PmLongPinInfo *info)
+{
+    HILOG_ERROR(LOG_CORE, "long pin: obj %{public}p size %{public}zu caller %{public}p pinned %{public}llu ms",
+        info->obj, info->size, info->caller, (unsigned long long)info->pinnedMs);
+}
+
+size_t PmPinTrackerCheck(void)
+{
+    PmLongPinInfo infos[LONG_PIN_REPORT_MAX];
+    size_t infoCnt = 0;
+    size_t longPinBytes = 0;
+
+    pthread_mutex_lock(&g_pinLock);
+    PmLongPinFunc func = g_longPinFunc;
+    void *param = g_longPinParam;
+    uint64_t now = NowNs();
+    uint64_t thresholdNs = (uint64_t)g_thresholdMs * NSEC_PER_MSEC;
+    for (size_t i = 0; g_trackEnabled && i < PIN_HASH_BUCKETS; i++) {
+        for (PinRecord *rec = g_pinTable[i]; rec; rec = rec->next) {
+            uint64_t pinnedNs = now - rec->pinTimeNs;
+            if (pinnedNs < thresholdNs) {
+                continue;
+            }
+            longPinBytes += rec->size;
+            if (rec->reported || infoCnt >= LONG_PIN_REPORT_MAX) {
+                continue;
+            }
+            rec->reported = true;
+            infos[infoCnt].obj = rec->obj;
+            infos[infoCnt].size = rec->size;
+            infos[infoCnt].caller = rec->caller;
+            infos[infoCnt].pinnedMs = pinnedNs / NSEC_PER_MSEC;
+            infoCnt++;
+        }
+    }
+    pthread_mutex_unlock(&g_pinLock);
+
+    /* outside the lock, callback may pin or unpin purgeable objects */
+    for (size_t i = 0; i < infoCnt; i++) {
+        if (func) {
+            func(&infos[i], param);
+        } else {
+            LogLongPin(&infos[i]);
+        }
+    }
+    return longPinBytes;
+}
+
+static void *WatchdogLoop(void *arg)
+{
+    (void)arg;
+    unsigned int sleepMs = g_thresholdMs / 2; /* 2: a long pin is found within 1.5 threshold */
+    if (sleepMs == 0) {
+        sleepMs = 1;
+    } else if (sleepMs > WATCHDOG_MAX_SLEEP_MS) {
+        sleepMs = WATCHDOG_MAX_SLEEP_MS;
+    }
+    while (!g_watchdogStop) {
+        (void)PmPinTrackerCheck();
+        usleep(sleepMs * USEC_PER_MSEC);
+    }
+    return NULL;
+}
+
+bool PmPinTrackerEnable(unsigned int thresholdMs, PmLongPinFunc func, void *param)
+{
+    pthread_mutex_lock(&g_watchdogLock);
+    pthread_mutex_lock(&g_pinLock);
+    if (g_trackEnabled) {
+        pthread_mutex_unlock(&g_pinLock);
+        pthread_mutex_unlock(&g_watchdogLock);
+        return false;
+    }
+    g_thresholdMs = thresholdMs;
+    g_longPinFunc = func;
+    g_longPinParam = param;
+    __atomic_store_n(&g_trackEnabled, true, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&g_pinLock);
+
+    bool ret = true;
+    if (thresholdMs > 0) {
+        g_watchdogStop = false;
+        g_watchdogRunning = (pthread_create(&g_watchdog, NULL, WatchdogLoop, NULL) == 0);
+        ret = g_watchdogRunning;
+    }
+    pthread_mutex_unlock(&g_watchdogLock);
+    if (!ret) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: start watchdog fail", __func__);
+        PmPinTrackerDisable();
+    }
+    return ret;
+}
+
+void PmPinTrackerDisable(void)
+{
+    pthread_mutex_lock(&g_watchdogLock);
+    if (g_watchdogRunning) {
+        g_watchdogStop = true;
+        pthread_join(g_watchdog, NULL);
+        g_watchdogRunning = false;
+    }
+    pthread_mutex_lock(&g_pinLock);
+    __atomic_store_n(&g_trackEnabled, false, __ATOMIC_RELAXED);
+    ClearRecords();
+    g_longPinFunc = NULL;
+    g_longPinParam = NULL;
+    pthread_mutex_unlock(&g_pinLock);
+    pthread_mutex_unlock(&g_watchdogLock);
+}
+
+bool PmPinTrackerIsEnabled(void)
+{
+    return __atomic_load_n(&g_trackEnabled, __ATOMIC_RELAXED);
+}
+
+size_t PmPinTrackerGetHistogram(uint64_t *buckets, size_t count)
+{
+    if (buckets == NULL) {
+        return 0;
+    }
+    if (count > PM_PIN_HIST_BUCKETS) {
+        count = PM_PIN_HIST_BUCKETS;
+    }
+    pthread_mutex_lock(&g_pinLock);
+    for (size_t i = 0; i < count; i++) {
+        buckets[i] = g_pinHist[i];
+    }
+    pthread_mutex_unlock(&g_pinLock);
+    return count;
+}
+
+void PmPinTrackerResetHistogram(void)
+{
+    pthread_mutex_lock(&g_pinLock);
+    for (size_t i = 0; i < PM_PIN_HIST_BUCKETS; i++) {
+        g_pinHist[i] = 0;
+    }
+    pthread_mutex_unlock(&g_pinLock);
+}
+
+void PmPinTrackerDump(void)
+{
+    pthread_mutex_lock(&g_pinLock);
+    for (size_t i = 0; i < PM_PIN_HIST_BUCKETS; i++) {
+        if (g_pinHist[i] != 0) {
+            HILOG_INFO(LOG_CORE, "pin duration bucket %{public}zu: %{public}llu",
+                i, (unsigned long long)g_pinHist[i]);
+        }
+    }
+    uint64_t now = NowNs();
+    uint64_t thresholdNs = (uint64_t)g_thresholdMs * NSEC_PER_MSEC;
+    size_t longPinBytes = 0;
+    for (size_t i = 0; i < PIN_HASH_BUCKETS; i++) {
+        for (PinRecord *rec = g_pinTable[i]; rec; rec = rec->next) {
+            uint64_t pinnedNs = now - rec->pinTimeNs;
+            if (pinnedNs < thresholdNs) {
+                continue;
+            }
+            longPinBytes += rec->size;
+            PmLongPinInfo info = { rec->obj, rec->size, rec->caller, pinnedNs / NSEC_PER_MSEC };
+            LogLongPin(&info);
+        }
+    }
+    pthread_mutex_unlock(&g_pinLock);
+    HILOG_INFO(LOG_CORE, "%{public}s: %{public}zu bytes stuck pinned", __func__, longPinBytes);
+}
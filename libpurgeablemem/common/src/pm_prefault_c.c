@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdint.h> /* uintptr_t */
+#include <sys/mman.h> /* madvise */
+
+#include "hilog/log_c.h"
+#include "pm_util.h"
+#include "pm_prefault_c.h"
+
+#undef LOG_TAG
+#define LOG_TAG "PurgeableMemC: Prefault"
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 /* linux 5.14 */
+#endif
+
+typedef enum {
+    POPULATE_UNKNOWN = 0,
+    POPULATE_SUPPORTED,
+    POPULATE_UNSUPPORTED,
+} PopulateSupport;
+
+static int g_populateSupport = POPULATE_UNKNOWN;
+
+/* write back the byte read, which faults the page in writable and keeps its content */
+static void TouchPages(void *addr, size_t len)
+{
+    volatile unsigned char *p = (volatile unsigned char *)addr;
+    for (size_t off = 0; off < len; off += PAGE_SIZE) {
+        p[off] = p[off];
+    }
+}
+
+/* tell an old kernel from a mapping which rejects the advice by a private anonymous page */
+static int ProbePopulateSupport(void)
+{
+    void *page = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+        return POPULATE_UNKNOWN;
+    }
+    int support = madvise(page, PAGE_SIZE, MADV_POPULATE_WRITE) == 0 ? POPULATE_SUPPORTED : POPULATE_UNSUPPORTED;
+    munmap(page, PAGE_SIZE);
+    return support;
+}
+
+bool PmPrefaultRange(void *addr, size_t len)
+{
+    if (addr == NULL || len == 0 || ((uintptr_t)addr & (PAGE_SIZE - 1)) != 0) {
+        return false;
+    }
+    int support = __sync_fetch_and_add(&g_populateSupport, 0);
+    if (support != POPULATE_UNSUPPORTED) {
+        if (madvise(addr, len, MADV_POPULATE_WRITE) == 0) {
+            __sync_bool_compare_and_swap(&g_populateSupport, POPULATE_UNKNOWN, POPULATE_SUPPORTED);
+            return true;
+        }
+        /* EINVAL: unknown advice on old kernels, or mapping type not supported */
+        if (errno != EINVAL) {
+            HILOG_ERROR(LOG_CORE, "%{public}s: madvise fail, errno %{public}d", __func__, errno);
+            return false;
+        }
+        /* only an old kernel turns the advice off, a rejecting mapping falls back for this call */
+        if (support == POPULATE_UNKNOWN) {
+            support = ProbePopulateSupport();
+            if (__sync_bool_compare_and_swap(&g_populateSupport, POPULATE_UNKNOWN, support) &&
+                support == POPULATE_UNSUPPORTED) {
+                HILOG_INFO(LOG_CORE, "%{public}s: MADV_POPULATE_WRITE unsupported, touch pages instead", __func__);
+            }
+        }
+    }
+    TouchPages(addr, len);
+    return true;
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* malloc */
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h> /* usleep() */
+
+#include "hilog/log_c.h"
+#include "pm_purge_notifier_c.h"
+
+#undef LOG_TAG
+#define LOG_TAG "PurgeableMemC: PurgeNotifier"
+
+#define WATCH_HASH_BUCKETS 256
+#define PURGE_NOTIFY_MAX 64 /* callbacks per scan, others are left to next scan */
+
+typedef struct PurgeWatch {
+    void *obj;
+    PmPurgedCheckFunc check;
+    PmPurgeFunc func;
+    void *param;
+    unsigned int notifiedBuild; /* the build whose purge is notified */
+    bool pending; /* collected by a scan, callback not run yet */
+    bool removed; /* unregistered while pending or calling, freed by the scan */
+    struct PurgeWatch *next;
+} PurgeWatch;
+
+static pthread_mutex_t g_scanLock = PTHREAD_MUTEX_INITIALIZER; /* serializes scans */
+static pthread_mutex_t g_watchLock = PTHREAD_MUTEX_INITIALIZER; /* protects all below */
+static pthread_cond_t g_callbackDone = PTHREAD_COND_INITIALIZER;
+static PurgeWatch *g_watchTable[WATCH_HASH_BUCKETS];
+static PurgeWatch *g_calling = NULL; /* watch whose callback is running */
+static pthread_t g_callingThread;
+static int g_eventFd = -1;
+
+static pthread_mutex_t g_scannerLock = PTHREAD_MUTEX_INITIALIZER; /* protects scanner start/stop */
+static pthread_t g_scanner;
+static bool g_scannerRunning = false;
+static volatile bool g_scannerStop = false;
+static unsigned int g_intervalMs = 0;
+
+static const unsigned int USEC_PER_MSEC = 1000;
+static const unsigned int SCANNER_MAX_SLEEP_MS = 100; /* bound the latency of PmPurgeNotifierStop() */
+
+static inline size_t WatchHash(const void *obj)
+{
+    uintptr_t key = (uintptr_t)obj;
+    return (size_t)((key >> 4) ^ (key >> 12)) % WATCH_HASH_BUCKETS; /* objects are at least 16B aligned */
+}
+
+static PurgeWatch **FindWatch(const void *obj)
+{
+    PurgeWatch **pp = &g_watchTable[WatchHash(obj)];
+    while (*pp && (*pp)->obj != obj) {
+        pp = &((*pp)->next);
+    }
+    return pp;
+}
+
+bool PmPurgeNotifierRegister(void *obj, PmPurgedCheckFunc check, PmPurgeFunc func, void *param)
+{
+    if (obj == NULL || check == NULL) {
+        return false;
+    }
+    bool ret = true;
+    pthread_mutex_lock(&g_watchLock);
+    PurgeWatch **pp = FindWatch(obj);
+    PurgeWatch *watch = *pp;
+    if (watch) {
+        watch->check = check;
+        watch->func = func;
+        watch->param = param;
+        goto unlock;
+    }
+    watch = (PurgeWatch *)malloc(sizeof(PurgeWatch));
+    if (watch == NULL) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: malloc fail", __func__);
+        ret = false;
+        goto unlock;
+    }
+    watch->obj = obj;
+    watch->check = check;
+    watch->func = func;
+    watch->param = param;
+    watch->notifiedBuild = check(obj); /* purged already is not notified */
+    watch->pending = false;
+    watch->removed = false;
+    watch->next = NULL;
+    *pp = watch;
+unlock:
+    pthread_mutex_unlock(&g_watchLock);
+    return ret;
+}
+
+void PmPurgeNotifierUnregister(void *obj)
+{
+    if (obj == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&g_watchLock);
+    PurgeWatch **pp = FindWatch(obj);
+    PurgeWatch *watch = *pp;
+    if (watch == NULL) {
+        goto unlock;
+    }
+    *pp = watch->next;
+    if (!watch->pending && watch != g_calling) {
+        free(watch);
+        goto unlock;
+    }
+    watch->removed = true;
+    /* wait for the callback of @obj, unless it is the caller */
+    if (watch == g_calling && !pthread_equal(g_callingThread, pthread_self())) {
+        while (g_calling == watch) {
+            pthread_cond_wait(&g_callbackDone, &g_watchLock);
+        }
+    }
+unlock:
+    pthread_mutex_unlock(&g_watchLock);
+}
+
+int PmPurgeNotifierGetEventFd(void)
+{
+    pthread_mutex_lock(&g_watchLock);
+    if (g_eventFd < 0) {
+        g_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (g_eventFd < 0) {
+            HILOG_ERROR(LOG_CORE, "%{public}s: eventfd fail, errno %{public}d", __func__, errno);
+        }
+    }
+    int fd = g_eventFd;
+    pthread_mutex_unlock(&g_watchLock);
+    return fd;
+}
+
+/* call with g_watchLock held, return number of objects turned purged */
+static size_t CollectPurged(PurgeWatch **found, size_t *foundCnt)
+{
+    size_t purgedCnt = 0;
+    for (size_t i = 0; i < WATCH_HASH_BUCKETS; i++) {
+        for (PurgeWatch *watch = g_watchTable[i]; watch; watch = watch->next) {
+            unsigned int purgedBuild = watch->check(watch->obj);
+            if (purgedBuild == 0 || purgedBuild == watch->notifiedBuild) {
+                continue;
+            }
+            if (watch->func) {
+                if (*foundCnt >= PURGE_NOTIFY_MAX) {
+                    continue; /* found again by next scan */
+                }
+                watch->pending = true;
+                found[(*foundCnt)++] = watch;
+            }
+            watch->notifiedBuild = purgedBuild;
+            purgedCnt++;
+        }
+    }
+    return purgedCnt;
+}
+
+static void NotifyPurged(PurgeWatch **found, size_t foundCnt)
+{
+    for (size_t i = 0; i < foundCnt; i++) {
+        PurgeWatch *watch = found[i];
+        pthread_mutex_lock(&g_watchLock);
+        watch->pending = false;
+        if (watch->removed) {
+            free(watch);
+            pthread_mutex_unlock(&g_watchLock);
+            continue;
+        }
+        g_calling = watch;
+        g_callingThread = pthread_self();
+        PmPurgeFunc func = watch->func;
+        void *obj = watch->obj;
+        void *param = watch->param;
+        pthread_mutex_unlock(&g_watchLock);
+
+        /* outside the lock, callback may unregister or destroy purgeable objects */
+        if (func) {
+            func(obj, param);
+        }
+
+        pthread_mutex_lock(&g_watchLock);
+        g_calling = NULL;
+        if (watch->removed) {
+            free(watch);
+        }
+        pthread_cond_broadcast(&g_callbackDone);
+        pthread_mutex_unlock(&g_watchLock);
+    }
+}
+
+size_t PmPurgeNotifierScan(void)
+{
+    PurgeWatch *found[PURGE_NOTIFY_MAX];
+    size_t foundCnt = 0;
+
+    pthread_mutex_lock(&g_scanLock);
+    pthread_mutex_lock(&g_watchLock);
+    size_t purgedCnt = CollectPurged(found, &foundCnt);
+    int fd = g_eventFd;
+    pthread_mutex_unlock(&g_watchLock);
+
+    if (purgedCnt > 0 && fd >= 0) {
+        uint64_t val = purgedCnt;
+        if (write(fd, &val, sizeof(val)) != sizeof(val)) {
+            HILOG_ERROR(LOG_CORE, "%{public}s: write eventfd fail, errno %{public}d", __func__, errno);
+        }
+    }
+    NotifyPurged(found, foundCnt);
+    pthread_mutex_unlock(&g_scanLock);
+    if (purgedCnt > 0) {
+        HILOG_DEBUG(LOG_CORE, "%{public}s: %{public}zu objects purged", __func__, purgedCnt);
+    }
+    return purgedCnt;
+}
+
+static void *ScannerLoop(void *arg)
+{
+    (void)arg;
+    while (!g_scannerStop) {
+        (void)PmPurgeNotifierScan();
+        for (unsigned int slept = 0; slept < g_intervalMs && !g_scannerStop; slept += SCANNER_MAX_SLEEP_MS) {
+            unsigned int ms = g_intervalMs - slept;
+            usleep((ms < SCANNER_MAX_SLEEP_MS ? ms : SCANNER_MAX_SLEEP_MS) * USEC_PER_MSEC);
+        }
+    }
+    return NULL;
+}
+
+bool PmPurgeNotifierStart(unsigned int intervalMs)
+{
+    if (intervalMs == 0) {
+        return false;
+    }
+    pthread_mutex_lock(&g_scannerLock);
+    bool ret = false;
+    if (!g_scannerRunning) {
+        g_intervalMs = intervalMs;
+        g_scannerStop = false;
+        g_scannerRunning = (pthread_create(&g_scanner, NULL, ScannerLoop, NULL) == 0);
+        ret = g_scannerRunning;
+        if (!ret) {
+            HILOG_ERROR(LOG_CORE, "%{public}s: start scanner fail", __func__);
+        }
+    }
+    pthread_mutex_unlock(&g_scannerLock);
+    return ret;
+}
+
+void PmPurgeNotifierStop(void)
+{
+    pthread_mutex_lock(&g_scannerLock);
+    if (g_scannerRunning) {
+        g_scannerStop = true;
+        pthread_join(g_scanner, NULL);
+        g_scannerRunning = false;
+    }
+    pthread_mutex_unlock(&g_scannerLock);
+}
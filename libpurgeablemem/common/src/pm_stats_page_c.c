@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <stddef.h> /* NULL, offsetof */
+#include <stdint.h> /* uint64_t */
+
+#include "hilog/log_c.h"
+#include "mem_stats_page.h"
+#include "pm_budget_c.h"
+#include "pm_stats_page_c.h"
+
+#undef LOG_TAG
+#define LOG_TAG "PurgeableMemC: StatsPage"
+
+static pthread_mutex_t g_pageLock = PTHREAD_MUTEX_INITIALIZER; /* serializes creation of g_page and fork */
+static struct MemStatsPage *g_page = NULL;
+static int g_pageFd = -1;
+static bool g_atForkRegistered = false;
+static uint64_t g_pinnedBytes = 0; /* counted before the page is published, to start its counters from */
+static uint64_t g_purgedBytes = 0;
+
+static void StatsPageInit(struct MemStatsPage *page)
+{
+    page->counters.purgeableBytes = PmBudgetGetUsage();
+    page->counters.purgeablePinnedBytes = __atomic_load_n(&g_pinnedBytes, __ATOMIC_RELAXED);
+    page->counters.purgeablePurgedBytes = __atomic_load_n(&g_purgedBytes, __ATOMIC_RELAXED);
+}
+
+static void StatsPageAtForkPrepare(void)
+{
+    pthread_mutex_lock(&g_pageLock);
+}
+
+static void StatsPageAtForkParent(void)
+{
+    pthread_mutex_unlock(&g_pageLock);
+}
+
+/* the child inherits the page of its parent, publish its own one so that readers do not count both */
+static void StatsPageAtForkChild(void)
+{
+    if (g_page != NULL) {
+        struct MemStatsPage *page = MemStatsPageRecreate(g_page, &g_pageFd);
+        if (page != NULL) {
+            /* objects are inherited by the child, builds were done by the parent */
+            StatsPageInit(page);
+        }
+        __atomic_store_n(&g_page, page, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_pageLock);
+}
+
+bool PmStatsPageEnable(void)
+{
+    pthread_mutex_lock(&g_pageLock);
+    if (!g_atForkRegistered) {
+        g_atForkRegistered = pthread_atfork(StatsPageAtForkPrepare, StatsPageAtForkParent,
+            StatsPageAtForkChild) == 0;
+        if (!g_atForkRegistered) {
+            HILOG_ERROR(LOG_CORE, "%{public}s: register atfork handlers fail", __func__);
+        }
+    }
+    if (g_page == NULL && g_atForkRegistered) {
+        struct MemStatsPage *page = MemStatsPageCreate(MEM_STATS_SOURCE_PURGEABLE, &g_pageFd);
+        if (page == NULL) {
+            HILOG_ERROR(LOG_CORE, "%{public}s: create stats page fail", __func__);
+        } else {
+            StatsPageInit(page);
+        }
+        __atomic_store_n(&g_page, page, __ATOMIC_RELEASE);
+    }
+    bool ret = g_page != NULL;
+    pthread_mutex_unlock(&g_pageLock);
+    return ret;
+}
+
+void PmStatsPageAddBytes(long long delta)
+{
+    struct MemStatsPage *page = __atomic_load_n(&g_page, __ATOMIC_ACQUIRE);
+    if (page == NULL) {
+        return;
+    }
+    MemStatsPageAdd(page, &page->counters.purgeableBytes, delta);
+}
+
+void PmStatsPageOnBuild(bool rebuild, bool succ)
+{
+    struct MemStatsPage *page = __atomic_load_n(&g_page, __ATOMIC_ACQUIRE);
+    if (page == NULL) {
+        return;
+    }
+    if (!succ) {
+        MemStatsPageAdd(page, &page->counters.purgeableBuildFails, 1);
+    } else if (rebuild) {
+        MemStatsPageAdd(page, &page->counters.purgeableRebuilds, 1);
+    } else {
+        MemStatsPageAdd(page, &page->counters.purgeableBuilds, 1);
+    }
+}
+
+static void StatsPageAddGauge(uint64_t *total, size_t field, long long delta)
+{
+    __atomic_add_fetch(total, (uint64_t)delta, __ATOMIC_RELAXED);
+    struct MemStatsPage *page = __atomic_load_n(&g_page, __ATOMIC_ACQUIRE);
+    if (page == NULL) {
+        return;
+    }
+    MemStatsPageAdd(page, (uint64_t *)((char *)&page->counters + field), delta);
+}
+
+void PmStatsPageAddPinned(long long delta)
+{
+    StatsPageAddGauge(&g_pinnedBytes, offsetof(struct MemStatsCounters, purgeablePinnedBytes), delta);
+}
+
+void PmStatsPageClearPurged(size_t *purgedBytes)
+{
+    size_t bytes = __atomic_exchange_n(purgedBytes, 0, __ATOMIC_SEQ_CST);
+    if (bytes != 0) {
+        StatsPageAddGauge(&g_purgedBytes, offsetof(struct MemStatsCounters, purgeablePurgedBytes),
+            -(long long)bytes);
+    }
+}
+
+void PmStatsPageMarkPurged(size_t *purgedBytes, const unsigned int *builds, unsigned int build, size_t size)
+{
+    size_t expected = 0;
+    if (build == 0 || size == 0 ||
+        !__atomic_compare_exchange_n(purgedBytes, &expected, size, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+    StatsPageAddGauge(&g_purgedBytes, offsetof(struct MemStatsCounters, purgeablePurgedBytes), (long long)size);
+    /* a rebuild bumps @builds before it clears, one of us takes the count back */
+    if (__atomic_load_n(builds, __ATOMIC_SEQ_CST) != build) {
+        PmStatsPageClearPurged(purgedBytes);
+    }
+}
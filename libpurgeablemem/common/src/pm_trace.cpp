@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pm_trace.h"
+
+#ifdef PURGEABLE_TRACE_ENABLE
+
+#include <atomic>
+#include <string>
+
+#include "hitrace_meter.h"
+
+namespace {
+std::atomic<long long> g_pinnedBytes {0};
+std::atomic<long long> g_purgeableBytes {0};
+const std::string PINNED_BYTES_NAME = "PurgPinnedBytes";
+const std::string PURGEABLE_BYTES_NAME = "PurgTotalBytes";
+} /* namespace */
+
+/* spans and counters are on pin paths, nothing is formatted unless the tag is enabled */
+void PmTraceBegin(const char *name, size_t size)
+{
+    if (!IsTagEnabled(HITRACE_TAG_COMMONLIBRARY)) {
+        return;
+    }
+    std::string value = name ? name : "";
+    if (size != 0) {
+        value += " size:" + std::to_string(size);
+    }
+    StartTrace(HITRACE_TAG_COMMONLIBRARY, value);
+}
+
+void PmTraceEnd(void)
+{
+    FinishTrace(HITRACE_TAG_COMMONLIBRARY);
+}
+
+void PmTraceAddPinnedBytes(long long delta)
+{
+    long long total = g_pinnedBytes.fetch_add(delta) + delta;
+    if (IsTagEnabled(HITRACE_TAG_COMMONLIBRARY)) {
+        CountTrace(HITRACE_TAG_COMMONLIBRARY, PINNED_BYTES_NAME, total);
+    }
+}
+
+void PmTraceAddPurgeableBytes(long long delta)
+{
+    long long total = g_purgeableBytes.fetch_add(delta) + delta;
+    if (IsTagEnabled(HITRACE_TAG_COMMONLIBRARY)) {
+        CountTrace(HITRACE_TAG_COMMONLIBRARY, PURGEABLE_BYTES_NAME, total);
+    }
+}
+
+#endif /* PURGEABLE_TRACE_ENABLE */
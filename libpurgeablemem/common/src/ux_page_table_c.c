@@ -14,9 +14,12 @@
  */
 
 #include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc */
 #include <sys/mman.h> /* mmap */
 #include <sched.h> /* sched_yield() */
 #include <limits.h>
+#include <pthread.h>
+#include <unistd.h> /* usleep() */
 
 #include "hilog/log_c.h"
 #include "pm_util.h"
@@ -37,9 +40,16 @@ typedef struct UserExtendPageTable {
     uint64_t dataAddr;
     size_t dataSize;
     uxpte_t *uxpte;
+    struct UserExtendPageTable *emuNext; /* list of tables watched by the emulator */
+    uint64_t *savedWords; /* lazyfree: first word of each page, replaced by canary when unpinned */
 } UxPageTableStruct;
 
 static bool g_supportUxpt = false;
+static bool g_emulateUxpt = false;
+static bool g_lazyFreeUxpt = false; /* uxpt maintained in userspace, unpinned pages are MADV_FREE'd */
+static unsigned int g_uptCount = 0; /* number of initialized tables */
+/* shared by InitUxPageTable, exclusive to switch the mode above while g_uptCount is 0 */
+static pthread_rwlock_t g_modeLock = PTHREAD_RWLOCK_INITIALIZER;
 
 /*
  * -------------------------------------------------------------------------
@@ -76,6 +86,10 @@ static const size_t UXPTE_PRESENT_MASK = (1 << UXPTE_PRESENT_BIT) - 1;
 static const size_t UXPTE_REFCNT_ONE = 1 << UXPTE_PRESENT_BIT;
 static const uxpte_t UXPTE_UNDER_RECLAIM = (uxpte_t)(-UXPTE_REFCNT_ONE);
 
+/* any nonzero value works: a page freed by kernel reads back as zero */
+static const uint64_t LAZYFREE_CANARY = 0x5055524745434e59ULL;
+#define LAZYFREE_MINCORE_PAGES 256 /* pages checked by one mincore() */
+
 static inline bool IsUxptePresent(uxpte_t pte)
 {
     return pte & (uxpte_t)UXPTE_PRESENT_MASK;
@@ -130,6 +144,7 @@ enum UxpteOp {
     UPT_PUT = 1,
     UPT_CLEAR = 2,
     UPT_IS_PRESENT = 3,
+    UPT_MARK_PRESENT = 4,
 };
 
 static void __attribute__((constructor)) CheckUxpt(void);
@@ -143,6 +158,15 @@ static PMState UxpteOps(UxPageTableStruct *upt, uint64_t addr, size_t len, enum
 
 static uxpte_t *MapUxptePages(uint64_t dataAddr, size_t dataSize);
 static int UnmapUxptePages(uxpte_t *ptes, size_t size);
+static void EmuAddTable(UxPageTableStruct *upt);
+static void EmuDelTable(UxPageTableStruct *upt);
+static bool EmuIsResident(uint64_t addr);
+static bool CheckLazyFree(void);
+static void LazyFreeGetAt(UxPageTableStruct *upt, uint64_t addr);
+static bool LazyFreeLockAt(UxPageTableStruct *upt, uint64_t addr);
+static void LazyFreeRun(UxPageTableStruct *upt, uint64_t start, uint64_t end);
+static void MarkPresentAt(UxPageTableStruct *upt, uint64_t addr);
+static bool LazyFreeIsPresent(UxPageTableStruct *upt, uint64_t start, uint64_t end);
 
 static void __attribute__((constructor)) CheckUxpt(void)
 {
@@ -153,7 +177,8 @@ static void __attribute__((constructor)) CheckUxpt(void)
     void *dataPtr = mmap(NULL, dataSize, prot, type, -1, 0);
     if (dataPtr == MAP_FAILED) {
         HILOG_ERROR(LOG_CORE, "%{public}s: not support MAP_PURG", __func__);
-        g_supportUxpt = false;
+        g_lazyFreeUxpt = CheckLazyFree();
+        g_supportUxpt = g_lazyFreeUxpt;
         return;
     }
     /* try to mmap uxpt page */
@@ -176,24 +201,59 @@ static void __attribute__((constructor)) CheckUxpt(void)
         HILOG_ERROR(LOG_CORE, "%{public}s: unmap purg data fail", __func__);
     }
     dataPtr = NULL;
-    HILOG_INFO(LOG_CORE, "%{public}s: supportUxpt=%{public}s", __func__, (g_supportUxpt ? "1" : "0"));
+    if (!g_supportUxpt) {
+        g_lazyFreeUxpt = CheckLazyFree();
+        g_supportUxpt = g_lazyFreeUxpt;
+    }
+    HILOG_INFO(LOG_CORE, "%{public}s: supportUxpt=%{public}s lazyFree=%{public}s", __func__,
+        (g_supportUxpt ? "1" : "0"), (g_lazyFreeUxpt ? "1" : "0"));
     return;
 }
 
+/* fallback for kernels without uxpt: probe MADV_FREE on a private anonymous page */
+static bool CheckLazyFree(void)
+{
+#ifdef MADV_FREE
+    void *dataPtr = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (dataPtr == MAP_FAILED) {
+        return false;
+    }
+    *(volatile uint64_t *)dataPtr = LAZYFREE_CANARY;
+    bool succ = (madvise(dataPtr, PAGE_SIZE, MADV_FREE) == 0);
+    if (munmap(dataPtr, PAGE_SIZE) != 0) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: unmap probe page fail", __func__);
+    }
+    return succ;
+#else
+    return false;
+#endif
+}
+
 bool UxpteIsEnabled(void)
 {
     return g_supportUxpt;
 }
 
+bool UxpteIsKernel(void)
+{
+    return g_supportUxpt && !g_emulateUxpt && !g_lazyFreeUxpt;
+}
+
+bool UxpteIsLazyFree(void)
+{
+    return g_lazyFreeUxpt;
+}
+
 size_t UxPageTableSize(void)
 {
     return sizeof(UxPageTableStruct);
 }
 
-PMState InitUxPageTable(UxPageTableStruct *upt, uint64_t addr, size_t len)
+static PMState InitUxPageTableLocked(UxPageTableStruct *upt, uint64_t addr, size_t len)
 {
     if (!g_supportUxpt) {
         HILOG_DEBUG(LOG_CORE, "%{public}s: not support uxpt", __func__);
+        __sync_fetch_and_add(&g_uptCount, 1);
         return PM_OK;
     }
     if (upt == NULL) {
@@ -202,24 +262,53 @@ PMState InitUxPageTable(UxPageTableStruct *upt, uint64_t addr, size_t len)
     }
     upt->dataAddr = addr;
     upt->dataSize = len;
+    upt->emuNext = NULL;
+    upt->savedWords = NULL;
     upt->uxpte = MapUxptePages(upt->dataAddr, upt->dataSize);
     if (!(upt->uxpte)) {
         return PM_MMAP_UXPT_FAIL;
     }
+    if (g_lazyFreeUxpt) {
+        upt->savedWords = (uint64_t *)calloc(RoundUp(len, PAGE_SIZE) / PAGE_SIZE, sizeof(uint64_t));
+        if (!(upt->savedWords)) {
+            HILOG_ERROR(LOG_CORE, "%{public}s: calloc savedWords fail", __func__);
+            (void)UnmapUxptePages(upt->uxpte, GetUxPageSize(upt->dataAddr, upt->dataSize));
+            upt->uxpte = NULL;
+            return PM_MMAP_UXPT_FAIL;
+        }
+    }
     UxpteClear(upt, addr, len);
+    if (g_emulateUxpt) {
+        EmuAddTable(upt);
+    }
+    __sync_fetch_and_add(&g_uptCount, 1);
     return PM_OK;
 }
 
+PMState InitUxPageTable(UxPageTableStruct *upt, uint64_t addr, size_t len)
+{
+    /* the mode must not switch between reading it and counting this table */
+    pthread_rwlock_rdlock(&g_modeLock);
+    PMState ret = InitUxPageTableLocked(upt, addr, len);
+    pthread_rwlock_unlock(&g_modeLock);
+    return ret;
+}
+
 PMState DeinitUxPageTable(UxPageTableStruct *upt)
 {
     if (!g_supportUxpt) {
         HILOG_DEBUG(LOG_CORE, "%{public}s: not support uxpt", __func__);
+        __sync_fetch_and_sub(&g_uptCount, 1);
         return PM_OK;
     }
     if (upt == NULL) {
         HILOG_ERROR(LOG_CORE, "%{public}s: upt is NULL!", __func__);
         return PM_MMAP_UXPT_FAIL;
     }
+    if (g_emulateUxpt) {
+        /* stop reclaimer from touching this table before unmap */
+        EmuDelTable(upt);
+    }
     size_t size = GetUxPageSize(upt->dataAddr, upt->dataSize);
     int unmapRet = 0;
     if (upt->uxpte) {
@@ -230,8 +319,11 @@ PMState DeinitUxPageTable(UxPageTableStruct *upt)
         }
         upt->uxpte = NULL;
     }
+    free(upt->savedWords);
+    upt->savedWords = NULL;
     upt->dataAddr = 0;
     upt->dataSize = 0;
+    __sync_fetch_and_sub(&g_uptCount, 1);
     return PM_OK;
 }
 
@@ -268,6 +360,14 @@ bool UxpteIsPresent(UxPageTableStruct *upt, uint64_t addr, size_t len)
     return ret == PM_OK;
 }
 
+void UxpteMarkPresent(UxPageTableStruct *upt, uint64_t addr, size_t len)
+{
+    if (!g_lazyFreeUxpt) {
+        return; /* kernel or emulator tracks present by itself */
+    }
+    UxpteOps(upt, addr, len, UPT_MARK_PRESENT);
+}
+
 static inline uxpte_t UxpteLoad(const uxpte_t *uxpte)
 {
     __sync_synchronize();
@@ -331,7 +431,11 @@ static void GetUxpteAt(UxPageTableStruct *upt, uint64_t addr)
         return;
     }
     size_t index = GetIndexInUxpte(upt->dataAddr, addr);
-    UxpteAdd(&(upt->uxpte[index]), UXPTE_REFCNT_ONE);
+    if (g_lazyFreeUxpt) {
+        LazyFreeGetAt(upt, addr);
+    } else {
+        UxpteAdd(&(upt->uxpte[index]), UXPTE_REFCNT_ONE);
+    }
 
     HILOG_DEBUG(LOG_CORE, "%{public}s: addr(0x%{public}llx) upte=0x%{public}llx",
         __func__, (unsigned long long)addr, (unsigned long long)(upt->uxpte[index]));
@@ -360,8 +464,17 @@ static void ClearUxpteAt(UxPageTableStruct *upt, uint64_t addr)
     UxpteClear_(&(upt->uxpte[index]));
 }
 
+static void MarkPresentAt(UxPageTableStruct *upt, uint64_t addr)
+{
+    size_t index = GetIndexInUxpte(upt->dataAddr, addr);
+    (void)__sync_fetch_and_or(&(upt->uxpte[index]), (uxpte_t)UXPTE_PRESENT_MASK);
+}
+
 static bool IsPresentAt(UxPageTableStruct *upt, uint64_t addr)
 {
+    if (g_emulateUxpt) {
+        return EmuIsResident(addr);
+    }
     size_t index = GetIndexInUxpte(upt->dataAddr, addr);
 
     HILOG_DEBUG(LOG_CORE, "%{public}s: addr(0x%{public}llx) upte=0x%{public}llx PRESENT_MASK=0x%{public}zx",
@@ -386,6 +499,12 @@ static PMState UxpteOps(UxPageTableStruct *upt, uint64_t addr, size_t len, enum
         return PM_UXPT_OUT_RANGE;
     }
 
+    if (op == UPT_IS_PRESENT && g_lazyFreeUxpt) {
+        return LazyFreeIsPresent(upt, start, end) ? PM_OK : PM_UXPT_NO_PRESENT;
+    }
+
+    uint64_t runStart = 0; /* lazyfree: pages [runStart, runEnd) are locked and wait for MADV_FREE */
+    uint64_t runEnd = 0;
     for (uint64_t off = start; off < end; off += PAGE_SIZE) {
         switch (op) {
             case UPT_GET: {
@@ -393,7 +512,19 @@ static PMState UxpteOps(UxPageTableStruct *upt, uint64_t addr, size_t len, enum
                 break;
             }
             case UPT_PUT: {
-                PutUxpteAt(upt, off);
+                if (!g_lazyFreeUxpt) {
+                    PutUxpteAt(upt, off);
+                } else if (LazyFreeLockAt(upt, off)) {
+                    if (runEnd != off) {
+                        LazyFreeRun(upt, runStart, runEnd);
+                        runStart = off;
+                    }
+                    runEnd = off + PAGE_SIZE;
+                }
+                break;
+            }
+            case UPT_MARK_PRESENT: {
+                MarkPresentAt(upt, off);
                 break;
             }
             case UPT_CLEAR: {
@@ -412,16 +543,143 @@ static PMState UxpteOps(UxPageTableStruct *upt, uint64_t addr, size_t len, enum
                 break;
         }
     }
+    LazyFreeRun(upt, runStart, runEnd);
 
     return PM_OK;
 }
 
+static inline uint64_t *LazyFreeSavedWord(UxPageTableStruct *upt, uint64_t addr)
+{
+    return &(upt->savedWords[VirtPageNo(addr) - VirtPageNo(upt->dataAddr)]);
+}
+
+/*
+ * Pin a lazyfree page. The first pin of a present page locks its uxpte like kernel reclaim does,
+ * then puts back the first word with CAS. If kernel freed the page, the canary reads back as zero,
+ * CAS fails and the page is not present any more. A successful CAS dirties the page, so kernel
+ * will not free it after that.
+ */
+static void LazyFreeGetAt(UxPageTableStruct *upt, uint64_t addr)
+{
+    size_t index = GetIndexInUxpte(upt->dataAddr, addr);
+    uxpte_t *pte = &(upt->uxpte[index]);
+    uxpte_t old;
+    while (true) {
+        old = UxpteLoad(pte);
+        if (IsUxpteUnderReclaim(old)) {
+            sched_yield();
+            continue;
+        }
+        if (old != UXPTE_PRESENT_MASK) { /* already pinned or not present, only count */
+            if (UxpteCAS_(pte, old, old + UXPTE_REFCNT_ONE)) {
+                return;
+            }
+            continue;
+        }
+        if (UxpteCAS_(pte, old, UXPTE_UNDER_RECLAIM)) {
+            break;
+        }
+    }
+    volatile uint64_t *word = (volatile uint64_t *)(uintptr_t)addr;
+    bool kept = __sync_bool_compare_and_swap(word, LAZYFREE_CANARY, *LazyFreeSavedWord(upt, addr));
+    __sync_synchronize();
+    *pte = kept ? (UXPTE_REFCNT_ONE | UXPTE_PRESENT_MASK) : UXPTE_REFCNT_ONE;
+}
+
+/*
+ * Unpin a lazyfree page. The last unpin of a present page locks its uxpte and replaces the first
+ * word by canary, return true and the page waits for LazyFreeRun().
+ */
+static bool LazyFreeLockAt(UxPageTableStruct *upt, uint64_t addr)
+{
+    size_t index = GetIndexInUxpte(upt->dataAddr, addr);
+    uxpte_t *pte = &(upt->uxpte[index]);
+    uxpte_t old;
+    do {
+        old = UxpteLoad(pte);
+        if (old != (UXPTE_REFCNT_ONE | UXPTE_PRESENT_MASK)) {
+            if (UxpteCAS_(pte, old, old - UXPTE_REFCNT_ONE)) {
+                return false;
+            }
+            continue;
+        }
+    } while (!UxpteCAS_(pte, old, UXPTE_UNDER_RECLAIM));
+    uint64_t *word = (uint64_t *)(uintptr_t)addr;
+    *LazyFreeSavedWord(upt, addr) = *word;
+    *word = LAZYFREE_CANARY;
+    return true;
+}
+
+/* MADV_FREE pages [start, end) locked by LazyFreeLockAt(), then unlock them as unpinned and present */
+static void LazyFreeRun(UxPageTableStruct *upt, uint64_t start, uint64_t end)
+{
+    if (start >= end) {
+        return;
+    }
+#ifdef MADV_FREE
+    if (madvise((void *)(uintptr_t)start, end - start, MADV_FREE) != 0) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: madvise fail", __func__);
+    }
+#endif
+    __sync_synchronize();
+    for (uint64_t off = start; off < end; off += PAGE_SIZE) {
+        upt->uxpte[GetIndexInUxpte(upt->dataAddr, off)] = UXPTE_PRESENT_MASK;
+    }
+    __sync_synchronize();
+}
+
+/*
+ * Check lazyfree pages without pinning them. An unpinned page keeps its present bit after
+ * kernel frees it, but it is not resident any more: the canary was written at unpin, so
+ * a kept page is always resident. Pinning a freed page refaults it and clears its present
+ * bit, so a page found non-resident counts as purged only if its uxpte is unchanged.
+ */
+static bool LazyFreeIsPresent(UxPageTableStruct *upt, uint64_t start, uint64_t end)
+{
+    unsigned char vec[LAZYFREE_MINCORE_PAGES];
+    for (uint64_t batch = start; batch < end; batch += LAZYFREE_MINCORE_PAGES * PAGE_SIZE) {
+        uint64_t batchEnd = end - batch > LAZYFREE_MINCORE_PAGES * PAGE_SIZE ?
+            batch + LAZYFREE_MINCORE_PAGES * PAGE_SIZE : end;
+        bool resident = false; /* vec is filled */
+        for (uint64_t off = batch; off < batchEnd; off += PAGE_SIZE) {
+            uxpte_t *pte = &(upt->uxpte[GetIndexInUxpte(upt->dataAddr, off)]);
+            uxpte_t old = UxpteLoad(pte);
+            if (IsUxpteUnderReclaim(old)) {
+                continue; /* being pinned or unpinned, not freed yet */
+            }
+            if (!IsUxptePresent(old)) {
+                return false;
+            }
+            if (old != UXPTE_PRESENT_MASK) {
+                continue; /* pinned */
+            }
+            if (!resident) {
+                if (mincore((void *)(uintptr_t)batch, batchEnd - batch, vec) != 0) {
+                    HILOG_ERROR(LOG_CORE, "%{public}s: mincore fail", __func__);
+                    return true;
+                }
+                resident = true;
+            }
+            if (!(vec[(off - batch) / PAGE_SIZE] & 1) && UxpteLoad(pte) == old) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 static uxpte_t *MapUxptePages(uint64_t dataAddr, size_t dataSize)
 {
     int prot = PROT_READ | PROT_WRITE;
     int type = MAP_ANONYMOUS | MAP_USEREXPTE;
     size_t size = GetUxPageSize(dataAddr, dataSize);
-    uxpte_t *ptes = (uxpte_t*)mmap(NULL, size, prot, type, -1, UxptePageNo(dataAddr) * PAGE_SIZE);
+    uxpte_t *ptes = NULL;
+    if (g_emulateUxpt) {
+        /* same layout as kernel uxpt pages, but plain anonymous memory */
+        ptes = (uxpte_t *)mmap(NULL, size, prot, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    } else {
+        ptes = (uxpte_t *)mmap(NULL, size, prot, type, -1, UxptePageNo(dataAddr) * PAGE_SIZE);
+    }
     if (ptes == MAP_FAILED) {
         HILOG_ERROR(LOG_CORE, "%{public}s: fail, return NULL", __func__);
         ptes = NULL;
@@ -435,6 +693,214 @@ static int UnmapUxptePages(uxpte_t *ptes, size_t size)
     return munmap(ptes, size);
 }
 
+static pthread_mutex_t g_emuLock = PTHREAD_MUTEX_INITIALIZER; /* protects g_emuTables */
+static UxPageTableStruct *g_emuTables = NULL;
+
+static pthread_mutex_t g_reclaimerLock = PTHREAD_MUTEX_INITIALIZER; /* protects reclaimer start/stop */
+static pthread_t g_reclaimer;
+static bool g_reclaimerRunning = false;
+static volatile bool g_reclaimerStop = false;
+static unsigned int g_reclaimIntervalMs = 0;
+static size_t g_reclaimPagesPerRound = 0;
+
+static bool g_probedSupportUxpt = false; /* mode probed by CheckUxpt, restored by UxptEmuDisable */
+static bool g_probedLazyFreeUxpt = false;
+
+static const unsigned int USEC_PER_MSEC = 1000;
+
+bool UxptEmuEnable(void)
+{
+    bool ret = true;
+    pthread_rwlock_wrlock(&g_modeLock);
+    if (g_emulateUxpt) {
+        goto unlock;
+    }
+    if (UxpteIsKernel()) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: kernel supports uxpt, no need to emulate", __func__);
+        ret = false;
+        goto unlock;
+    }
+    if (__sync_fetch_and_add(&g_uptCount, 0) != 0) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: purgeable objs exist, can not switch", __func__);
+        ret = false;
+        goto unlock;
+    }
+    g_probedSupportUxpt = g_supportUxpt;
+    g_probedLazyFreeUxpt = g_lazyFreeUxpt;
+    g_lazyFreeUxpt = false;
+    g_emulateUxpt = true;
+    g_supportUxpt = true;
+    HILOG_INFO(LOG_CORE, "%{public}s: uxpt emulator enabled", __func__);
+unlock:
+    pthread_rwlock_unlock(&g_modeLock);
+    return ret;
+}
+
+bool UxptEmuDisable(void)
+{
+    UxptEmuStopReclaimer();
+    bool ret = true;
+    pthread_rwlock_wrlock(&g_modeLock);
+    if (!g_emulateUxpt) {
+        goto unlock;
+    }
+    if (__sync_fetch_and_add(&g_uptCount, 0) != 0) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: purgeable objs exist, can not switch", __func__);
+        ret = false;
+        goto unlock;
+    }
+    g_emulateUxpt = false;
+    g_lazyFreeUxpt = g_probedLazyFreeUxpt;
+    g_supportUxpt = g_probedSupportUxpt;
+    HILOG_INFO(LOG_CORE, "%{public}s: uxpt emulator disabled", __func__);
+unlock:
+    pthread_rwlock_unlock(&g_modeLock);
+    return ret;
+}
+
+bool UxpteIsEmulated(void)
+{
+    return g_emulateUxpt;
+}
+
+static void EmuAddTable(UxPageTableStruct *upt)
+{
+    pthread_mutex_lock(&g_emuLock);
+    upt->emuNext = g_emuTables;
+    g_emuTables = upt;
+    pthread_mutex_unlock(&g_emuLock);
+}
+
+static void EmuDelTable(UxPageTableStruct *upt)
+{
+    pthread_mutex_lock(&g_emuLock);
+    UxPageTableStruct **pp = &g_emuTables;
+    while (*pp) {
+        if (*pp == upt) {
+            *pp = upt->emuNext;
+            break;
+        }
+        pp = &((*pp)->emuNext);
+    }
+    upt->emuNext = NULL;
+    pthread_mutex_unlock(&g_emuLock);
+}
+
+static bool EmuIsResident(uint64_t addr)
+{
+    unsigned char vec = 0;
+    if (mincore((void *)(uintptr_t)RoundDown(addr, PAGE_SIZE), PAGE_SIZE, &vec) != 0) {
+        return false; /* unmapped */
+    }
+    return (vec & 1) != 0;
+}
+
+/* lock the page from pinning if nobody pins it, like the kernel does before reclaim */
+static bool EmuTryLockReclaim(uxpte_t *pte)
+{
+    uxpte_t old = UxpteLoad(pte);
+    if (IsUxpteUnderReclaim(old) || (old >> UXPTE_PRESENT_BIT) != 0) {
+        return false;
+    }
+    return UxpteCAS_(pte, old, UXPTE_UNDER_RECLAIM);
+}
+
+/* drop pages [start, end) of @upt which are locked by EmuTryLockReclaim, then unlock them */
+static void EmuDropRun(UxPageTableStruct *upt, uint64_t start, uint64_t end)
+{
+    if (start >= end) {
+        return;
+    }
+    if (madvise((void *)(uintptr_t)start, end - start, MADV_DONTNEED) != 0) {
+        HILOG_ERROR(LOG_CORE, "%{public}s: madvise fail", __func__);
+    }
+    for (uint64_t off = start; off < end; off += PAGE_SIZE) {
+        size_t index = GetIndexInUxpte(upt->dataAddr, off);
+        (void)UxpteCAS_(&(upt->uxpte[index]), UXPTE_UNDER_RECLAIM, 0);
+    }
+}
+
+static size_t EmuReclaimTable(UxPageTableStruct *upt, size_t budget)
+{
+    size_t dropped = 0;
+    uint64_t runStart = 0;
+    uint64_t runEnd = 0;
+    uint64_t end = upt->dataAddr + RoundUp(upt->dataSize, PAGE_SIZE);
+    for (uint64_t off = upt->dataAddr; off < end && (budget == 0 || dropped < budget); off += PAGE_SIZE) {
+        size_t index = GetIndexInUxpte(upt->dataAddr, off);
+        if (!EmuIsResident(off) || !EmuTryLockReclaim(&(upt->uxpte[index]))) {
+            EmuDropRun(upt, runStart, runEnd);
+            runStart = runEnd = 0;
+            continue;
+        }
+        if (runEnd != off) {
+            EmuDropRun(upt, runStart, runEnd);
+            runStart = off;
+        }
+        runEnd = off + PAGE_SIZE;
+        dropped++;
+    }
+    EmuDropRun(upt, runStart, runEnd);
+    return dropped;
+}
+
+size_t UxptEmuReclaim(size_t maxPages)
+{
+    if (!g_emulateUxpt) {
+        return 0;
+    }
+    size_t dropped = 0;
+    pthread_mutex_lock(&g_emuLock);
+    for (UxPageTableStruct *upt = g_emuTables; upt; upt = upt->emuNext) {
+        if (maxPages != 0 && dropped >= maxPages) {
+            break;
+        }
+        dropped += EmuReclaimTable(upt, maxPages == 0 ? 0 : maxPages - dropped);
+    }
+    pthread_mutex_unlock(&g_emuLock);
+    HILOG_DEBUG(LOG_CORE, "%{public}s: dropped %{public}zu pages", __func__, dropped);
+    return dropped;
+}
+
+static void *EmuReclaimerLoop(void *arg)
+{
+    (void)arg;
+    while (!g_reclaimerStop) {
+        (void)UxptEmuReclaim(g_reclaimPagesPerRound);
+        usleep(g_reclaimIntervalMs * USEC_PER_MSEC);
+    }
+    return NULL;
+}
+
+bool UxptEmuStartReclaimer(unsigned int intervalMs, size_t pagesPerRound)
+{
+    if (!g_emulateUxpt) {
+        return false;
+    }
+    bool ret = true;
+    pthread_mutex_lock(&g_reclaimerLock);
+    if (!g_reclaimerRunning) {
+        g_reclaimIntervalMs = intervalMs;
+        g_reclaimPagesPerRound = pagesPerRound;
+        g_reclaimerStop = false;
+        g_reclaimerRunning = (pthread_create(&g_reclaimer, NULL, EmuReclaimerLoop, NULL) == 0);
+        ret = g_reclaimerRunning;
+    }
+    pthread_mutex_unlock(&g_reclaimerLock);
+    return ret;
+}
+
+void UxptEmuStopReclaimer(void)
+{
+    pthread_mutex_lock(&g_reclaimerLock);
+    if (g_reclaimerRunning) {
+        g_reclaimerStop = true;
+        pthread_join(g_reclaimer, NULL);
+        g_reclaimerRunning = false;
+    }
+    pthread_mutex_unlock(&g_reclaimerLock);
+}
+
 #else /* !(defined(USE_UXPT) && (USE_UXPT <= 0)), it means does not using uxpt */
 
 typedef struct UserExtendPageTable {
@@ -470,4 +936,43 @@ bool UxpteIsPresent(UxPageTableStruct *upt, uint64_t addr, size_t len)
     return true;
 }
 
+bool UxptEmuEnable(void)
+{
+    return false;
+}
+
+bool UxptEmuDisable(void)
+{
+    return true;
+}
+
+bool UxpteIsEmulated(void)
+{
+    return false;
+}
+
+bool UxpteIsKernel(void)
+{
+    return false;
+}
+
+bool UxpteIsLazyFree(void)
+{
+    return false;
+}
+
+void UxpteMarkPresent(UxPageTableStruct *upt, uint64_t addr, size_t len) {}
+
+size_t UxptEmuReclaim(size_t maxPages)
+{
+    return 0;
+}
+
+bool UxptEmuStartReclaimer(unsigned int intervalMs, size_t pagesPerRound)
+{
+    return false;
+}
+
+void UxptEmuStopReclaimer(void) {}
+
 #endif /* USE_UXPT > 0 */
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_ARRAY_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_ARRAY_H
+
+#include <cstddef>
+#include <memory> /* unique_ptr */
+#include <type_traits>
+#include <utility>
+#if __cplusplus > 201703L
+#include <span>
+#endif
+
+#include "purgeable_mem.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+#if __cplusplus > 201703L
+template <typename T>
+using PurgeableSpan = std::span<T>;
+#else
+/* subset of std::span used by PurgeableArray before C++20 */
+template <typename T>
+class PurgeableSpan {
+public:
+    PurgeableSpan() = default;
+    PurgeableSpan(T *data, size_t size) : data_(data), size_(size) {}
+    T *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T *begin() const { return data_; }
+    T *end() const { return data_ + size_; }
+    T &operator[](size_t idx) const { return data_[idx]; }
+
+private:
+    T *data_ = nullptr;
+    size_t size_ = 0;
+};
+#endif
+
+/*
+ * PurgeableArray: fixed count of T in purgeable memory, rebuilt by @Gen after purge.
+ * @Gen is either bool(T *data, size_t count) which fills all elements,
+ * or T(size_t idx) which returns one element. Both are called inline, once per rebuild.
+ * Access content by the scoped views, which pin it until they are destroyed:
+ *     auto view = arr.Read();
+ *     if (view) { Consume(view.Span()); }
+ */
+template <typename T, typename Gen>
+class PurgeableArray {
+    static_assert(std::is_trivially_copyable<T>::value, "content is dropped and rebuilt bytewise");
+    static_assert(std::is_invocable_r<bool, Gen &, T *, size_t>::value ||
+        std::is_invocable_r<T, Gen &, size_t>::value,
+        "Gen must be bool(T *, size_t) or T(size_t)");
+
+public:
+    class ReadView {
+    public:
+        explicit operator bool() const { return arr_ != nullptr; }
+        PurgeableSpan<const T> Span() const { return { arr_ ? arr_->Data() : nullptr, arr_ ? arr_->count_ : 0 }; }
+        ~ReadView()
+        {
+            if (arr_) {
+                arr_->mem_.EndRead();
+            }
+        }
+        ReadView(ReadView &&other) noexcept : arr_(std::exchange(other.arr_, nullptr)) {}
+        ReadView(const ReadView &) = delete;
+        ReadView &operator=(const ReadView &) = delete;
+        ReadView &operator=(ReadView &&) = delete;
+
+    private:
+        explicit ReadView(PurgeableArray *arr) : arr_(arr) {}
+        PurgeableArray *arr_;
+        friend class PurgeableArray;
+    };
+
+    class WriteView {
+    public:
+        explicit operator bool() const { return arr_ != nullptr; }
+        /* changes by Span() are lost when purged, use Modify() for changes to be kept */
+        PurgeableSpan<T> Span() const { return { arr_ ? arr_->Data() : nullptr, arr_ ? arr_->count_ : 0 }; }
+
+        /*
+         * Modify: apply @mod now and again after each rebuild.
+         * Input:   @mod: bool(T *data, size_t count).
+         */
+        template <typename Mod>
+        bool Modify(Mod &&mod)
+        {
+            static_assert(std::is_invocable_r<bool, Mod &, T *, size_t>::value, "Mod must be bool(T *, size_t)");
+            if (!arr_) {
+                return false;
+            }
+            return arr_->mem_.ModifyContentByBuilder(
+                std::make_unique<ModifyBuilder<std::decay_t<Mod>>>(std::forward<Mod>(mod)));
+        }
+
+        ~WriteView()
+        {
+            if (arr_) {
+                arr_->mem_.EndWrite();
+            }
+        }
+        WriteView(WriteView &&other) noexcept : arr_(std::exchange(other.arr_, nullptr)) {}
+        WriteView(const WriteView &) = delete;
+        WriteView &operator=(const WriteView &) = delete;
+        WriteView &operator=(WriteView &&) = delete;
+
+    private:
+        explicit WriteView(PurgeableArray *arr) : arr_(arr) {}
+        PurgeableArray *arr_;
+        friend class PurgeableArray;
+    };
+
+    /* the array is invalid, i.e. all views are false, if @count is 0 or too large */
+    PurgeableArray(size_t count, Gen gen)
+        : count_(count <= OHOS_MAXIMUM_PURGEABLE_MEMORY / sizeof(T) ? count : 0),
+          mem_(count_ * sizeof(T), std::make_unique<GenBuilder>(std::move(gen), count_))
+    {
+    }
+
+    size_t Size() const { return count_; }
+
+    /* Read: pin and rebuild content if purged, the view is false if rebuild failed */
+    ReadView Read()
+    {
+        return ReadView(mem_.BeginRead() ? this : nullptr);
+    }
+
+    /* TryRead: pin content only if it is present now, never rebuild or block */
+    ReadView TryRead()
+    {
+        return ReadView(mem_.TryBeginRead() ? this : nullptr);
+    }
+
+    WriteView Write()
+    {
+        return WriteView(mem_.BeginWrite() ? this : nullptr);
+    }
+
+private:
+    class GenBuilder : public PurgeableMemBuilder {
+    public:
+        GenBuilder(Gen &&gen, size_t count) : gen_(std::move(gen)), count_(count) {}
+        bool Build(void *data, size_t size) override
+        {
+            if (size < count_ * sizeof(T)) {
+                return false;
+            }
+            T *elems = static_cast<T *>(data);
+            if constexpr (std::is_invocable_r<bool, Gen &, T *, size_t>::value) {
+                return gen_(elems, count_);
+            } else {
+                for (size_t i = 0; i < count_; i++) {
+                    elems[i] = gen_(i);
+                }
+                return true;
+            }
+        }
+
+    private:
+        Gen gen_;
+        size_t count_;
+    };
+
+    template <typename Mod>
+    class ModifyBuilder : public PurgeableMemBuilder {
+    public:
+        explicit ModifyBuilder(Mod &&mod) : mod_(std::move(mod)) {}
+        explicit ModifyBuilder(const Mod &mod) : mod_(mod) {}
+        bool Build(void *data, size_t size) override
+        {
+            return mod_(static_cast<T *>(data), size / sizeof(T));
+        }
+
+    private:
+        Mod mod_;
+    };
+
+    T *Data()
+    {
+        return static_cast<T *>(mem_.GetContent());
+    }
+
+    size_t count_;
+    PurgeableMem mem_;
+};
+
+/* MakePurgeableArray: deduce Gen of a lambda */
+template <typename T, typename Gen>
+std::unique_ptr<PurgeableArray<T, std::decay_t<Gen>>> MakePurgeableArray(size_t count, Gen &&gen)
+{
+    return std::make_unique<PurgeableArray<T, std::decay_t<Gen>>>(count, std::forward<Gen>(gen));
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_ARRAY_H */
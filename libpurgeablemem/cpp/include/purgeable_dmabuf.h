@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_DMABUF_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_DMABUF_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "purgeable_mem_builder.h"
+#include "purgeable_mem_base.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+/*
+ * PurgeableDmaBuf: a dmabuf of a dma heap whose content is rebuilt by a builder chain.
+ * An unpinned buffer may be freed back to the heap by Purge(), or by the trim manager when
+ * allocating another buffer would exceed the resident limit. The next BeginRead()/BeginWrite()
+ * allocates a new dmabuf and rebuilds it. Content stays at the same address all the time,
+ * while the dmabuf fd changes after a purge.
+ */
+class PurgeableDmaBuf : public PurgeableMemBase {
+public:
+    /* @ownerId: DmaHeapFlagOwnerId of the buffer, see dmabuf_alloc.h */
+    PurgeableDmaBuf(const std::string &heapName, size_t dataSize, std::unique_ptr<PurgeableMemBuilder> builder,
+        int ownerId = 0);
+    ~PurgeableDmaBuf() override;
+    void ResizeData(size_t newSize) override;
+
+    /*
+     * GetDmaBufFd: get fd of the dmabuf, for importing it into GPU or codec.
+     * Return:  the fd, -1 if purged. It should be protected by BeginRead()/EndRead()
+     *          or BeginWrite()/EndWrite(), it is closed when purged.
+     */
+    int GetDmaBufFd();
+
+    /*
+     * Purge: free the dmabuf back to the heap if it is not pinned.
+     * Return:  true if it is freed, next BeginRead() will rebuild it.
+     */
+    bool Purge();
+
+    /*
+     * Trim manager of all PurgeableDmaBuf objects of this process.
+     * SetResidentLimit: set the limit of allocated bytes, 0 means unlimited(default).
+     * Allocating a buffer over the limit purges least recently unpinned buffers first.
+     */
+    static void SetResidentLimit(size_t bytes);
+    static size_t GetResidentBytes();
+
+    /*
+     * Trim: purge least recently unpinned buffers.
+     * Input:   @bytes: bytes to free.
+     * Return:  bytes freed.
+     */
+    static size_t Trim(size_t bytes);
+
+protected:
+    int heapFd_ = -1;
+    int bufferFd_ = -1;
+    uint64_t heapFlags_ = 0;
+    size_t bufferSize_ = 0; /* page aligned size of dmabuf and address reservation */
+    std::mutex bufferLock_; /* protects pinCount_ and the buffer against Purge() */
+    std::atomic<int> pinCount_ {0};
+    std::atomic<bool> allocated_ {false};
+    std::atomic<uint64_t> lastUnpinNs_ {0};
+    bool Pin() override;
+    bool Unpin() override;
+    bool IsPurged() override;
+    int GetPinStatus() const override;
+    bool BuildContent() override;
+    std::string ToString() const override;
+    bool Reserve(size_t size);
+    bool Allocate();
+    void Release();
+};
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_DMABUF_H */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_FILE_MEM_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_FILE_MEM_H
+
+#include <atomic>
+#include <string>
+#include <sys/types.h> /* off_t */
+
+#include "purgeable_mem_base.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+/*
+ * PurgeableFileMem: read-only content of [offset, offset + length) of a file, mapped private.
+ * Its pages live in the page cache, so the kernel may reclaim them whenever they are clean,
+ * and "rebuild" is refaulting them from the file: no copy and no builder is needed.
+ * BeginRead()/EndRead() work as other purgeable objects, a BeginRead() finding pages
+ * dropped counts as a rebuild and reads them back in one go. A finished refault is final:
+ * pages dropped again before the last unpin just refault on access. BeginWrite() and
+ * ModifyContentByBuilder() always fail.
+ */
+class PurgeableFileMem : public PurgeableMemBase {
+public:
+    /* @fd is only used by the constructor, the caller keeps it */
+    PurgeableFileMem(int fd, off_t offset, size_t length);
+    ~PurgeableFileMem() override;
+    void ResizeData(size_t newSize) override;
+
+protected:
+    void *mapBase_ = nullptr; /* page aligned start of the mapping */
+    size_t mapSize_ = 0;
+    std::atomic<int> pinCount_ {0};
+    std::atomic<bool> refaultedUnderPin_ {false}; /* content is valid until the last unpin */
+    bool Pin() override;
+    bool Unpin() override;
+    bool IsPurged() override;
+    int GetPinStatus() const override;
+    bool BuildContent() override;
+    bool BeforeWrite() override;
+    std::string ToString() const override;
+};
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_FILE_MEM_H */
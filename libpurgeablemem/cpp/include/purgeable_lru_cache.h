@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_LRU_CACHE_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_LRU_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory> /* unique_ptr */
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pm_util.h"
+#include "purgeable_mem.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+struct PurgeableLruCacheStats {
+    uint64_t hits;
+    uint64_t misses; /* including loads of values failed in a purge rebuild */
+    uint64_t purgeRebuilds; /* values reloaded because their slab was purged */
+    uint64_t evictions;
+};
+
+/*
+ * PurgeableLruCache: concurrent LRU cache of trivially copyable values kept in purgeable memory.
+ * Keys are spread over shards, each with its own lock, LRU list and pool of slabs.
+ * A slab is a PurgeableMem of one page(or one value if larger) cut into slots, so a slab is
+ * the unit the kernel reclaims. When a purged slab is read again, @loader reloads every value
+ * of it, as it does on a miss.
+ * Get() pins the value and returns a Handle, the value is neither evicted nor purged until
+ * the Handle is destroyed. Handles must not outlive the cache.
+ * @loader runs with the shard lock held, so it must not access the cache.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class PurgeableLruCache {
+    static_assert(std::is_trivially_copyable<V>::value, "values are dropped and reloaded bytewise");
+
+private:
+    struct Shard;
+    struct Slab;
+    struct Entry {
+        const K *key; /* points to key of the map node */
+        Slab *slab;
+        size_t slot;
+        unsigned int refs; /* live handles */
+        bool loaded; /* false if reload failed in a purge rebuild */
+        typename std::list<Entry *>::iterator lruPos;
+    };
+
+public:
+    using Loader = std::function<bool(const K &key, V &value)>;
+
+    class Handle {
+    public:
+        Handle() = default;
+        explicit operator bool() const { return value_ != nullptr; }
+        const V &operator*() const { return *value_; }
+        const V *operator->() const { return value_; }
+        Handle(Handle &&other) noexcept
+            : shard_(std::exchange(other.shard_, nullptr)), entry_(std::exchange(other.entry_, nullptr)),
+              value_(std::exchange(other.value_, nullptr))
+        {
+        }
+        Handle &operator=(Handle &&other) noexcept
+        {
+            if (this != &other) {
+                Release();
+                shard_ = std::exchange(other.shard_, nullptr);
+                entry_ = std::exchange(other.entry_, nullptr);
+                value_ = std::exchange(other.value_, nullptr);
+            }
+            return *this;
+        }
+        Handle(const Handle &) = delete;
+        Handle &operator=(const Handle &) = delete;
+        ~Handle()
+        {
+            Release();
+        }
+
+    private:
+        Handle(Shard *shard, Entry *entry, const V *value) : shard_(shard), entry_(entry), value_(value) {}
+        void Release()
+        {
+            if (!entry_) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(shard_->lock);
+            entry_->slab->mem->EndRead();
+            entry_->refs--;
+            entry_ = nullptr;
+            value_ = nullptr;
+        }
+        Shard *shard_ = nullptr;
+        Entry *entry_ = nullptr;
+        const V *value_ = nullptr;
+        friend class PurgeableLruCache;
+    };
+
+    /*
+     * Input:   @capacity: max count of values, split evenly among shards.
+     * Input:   @loader: loads the value of a key on miss and after purge, returns false if it can not.
+     * Input:   @shardCount: count of shards, more shards less contention.
+     */
+    PurgeableLruCache(size_t capacity, Loader loader, size_t shardCount = DEFAULT_SHARD_COUNT)
+        : loader_(std::move(loader))
+    {
+        if (shardCount == 0) {
+            shardCount = 1;
+        }
+        size_t shardCapacity = (capacity + shardCount - 1) / shardCount;
+        for (size_t i = 0; i < shardCount; i++) {
+            shards_.emplace_back(std::make_unique<Shard>(this, shardCapacity));
+        }
+    }
+    PurgeableLruCache(const PurgeableLruCache &) = delete;
+    PurgeableLruCache &operator=(const PurgeableLruCache &) = delete;
+
+    /*
+     * Get: look up @key, load it on miss.
+     * Return:  Handle of the pinned value, false if load failed or the shard is full of pinned values.
+     */
+    Handle Get(const K &key)
+    {
+        Shard &shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            Entry &entry = it->second;
+            shard.lru.splice(shard.lru.begin(), shard.lru, entry.lruPos);
+            /* rebuild of a purged slab reloads all loaded values of it */
+            if (!entry.slab->mem->BeginRead()) {
+                return Handle();
+            }
+            if (!entry.loaded) {
+                entry.slab->mem->EndRead();
+                shard.misses++;
+                if (!Load(entry) || !entry.slab->mem->BeginRead()) {
+                    return Handle();
+                }
+            } else {
+                shard.hits++;
+            }
+            entry.refs++;
+            return Handle(&shard, &entry, SlotOf(entry));
+        }
+
+        shard.misses++;
+        Slab *slab = nullptr;
+        size_t slot = 0;
+        if (!AllocSlot(shard, slab, slot)) {
+            return Handle();
+        }
+        auto res = shard.entries.emplace(key, Entry { nullptr, slab, slot, 0, false, {} });
+        Entry &entry = res.first->second;
+        entry.key = &(res.first->first);
+        slab->owners[slot] = &entry;
+        if (!Load(entry) || !slab->mem->BeginRead()) {
+            slab->owners[slot] = nullptr;
+            shard.freeSlots.emplace_back(slab, slot);
+            shard.entries.erase(res.first);
+            return Handle();
+        }
+        shard.lru.push_front(&entry);
+        entry.lruPos = shard.lru.begin();
+        entry.refs++;
+        return Handle(&shard, &entry, SlotOf(entry));
+    }
+
+    /* Erase: drop @key, return false if it is absent or pinned */
+    bool Erase(const K &key)
+    {
+        Shard &shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end() || it->second.refs > 0) {
+            return false;
+        }
+        Drop(shard, it);
+        return true;
+    }
+
+    size_t Size()
+    {
+        size_t size = 0;
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->lock);
+            size += shard->entries.size();
+        }
+        return size;
+    }
+
+    PurgeableLruCacheStats GetStats() const
+    {
+        PurgeableLruCacheStats stats = { 0, 0, 0, 0 };
+        for (auto &shard : shards_) {
+            stats.hits += shard->hits.load();
+            stats.misses += shard->misses.load();
+            stats.purgeRebuilds += shard->purgeRebuilds.load();
+            stats.evictions += shard->evictions.load();
+        }
+        return stats;
+    }
+
+    static constexpr size_t DEFAULT_SHARD_COUNT = 8;
+
+private:
+    /* rebuilds a purged slab by reloading values of all its slots */
+    class SlabBuilder : public PurgeableMemBuilder {
+    public:
+        SlabBuilder(PurgeableLruCache *cache, Shard *shard, Slab *slab) : cache_(cache), shard_(shard), slab_(slab) {}
+        bool Build(void *data, size_t size) override
+        {
+            V *slots = static_cast<V *>(data);
+            for (size_t i = 0; i < slab_->owners.size(); i++) {
+                Entry *entry = slab_->owners[i];
+                if (!entry || !entry->loaded) {
+                    continue;
+                }
+                entry->loaded = cache_->loader_(*entry->key, slots[i]);
+                shard_->purgeRebuilds++;
+            }
+            return true;
+        }
+
+    private:
+        PurgeableLruCache *cache_;
+        Shard *shard_;
+        Slab *slab_;
+    };
+
+    struct Slab {
+        std::unique_ptr<PurgeableMem> mem;
+        std::vector<Entry *> owners; /* entry of each slot, nullptr if free */
+    };
+
+    struct Shard {
+        Shard(PurgeableLruCache *owner, size_t cap) : cache(owner), capacity(cap) {}
+        PurgeableLruCache *cache;
+        size_t capacity;
+        std::mutex lock; /* protects all but stats */
+        std::unordered_map<K, Entry, Hash> entries;
+        std::list<Entry *> lru; /* most recently used first */
+        std::vector<std::unique_ptr<Slab>> slabs;
+        std::vector<std::pair<Slab *, size_t>> freeSlots;
+        std::atomic<uint64_t> hits {0};
+        std::atomic<uint64_t> misses {0};
+        std::atomic<uint64_t> purgeRebuilds {0};
+        std::atomic<uint64_t> evictions {0};
+    };
+
+    static constexpr size_t SlotsPerSlab()
+    {
+        return sizeof(V) >= PAGE_SIZE ? 1 : PAGE_SIZE / sizeof(V);
+    }
+
+    Shard &ShardOf(const K &key)
+    {
+        return *shards_[hash_(key) % shards_.size()];
+    }
+
+    V *SlotOf(const Entry &entry)
+    {
+        return static_cast<V *>(entry.slab->mem->GetContent()) + entry.slot;
+    }
+
+    /* load value of @entry into its slot, call with shard lock held */
+    bool Load(Entry &entry)
+    {
+        PurgeableMem *mem = entry.slab->mem.get();
+        if (!mem->BeginWrite()) {
+            return false;
+        }
+        entry.loaded = loader_(*entry.key, *SlotOf(entry));
+        mem->EndWrite();
+        return entry.loaded;
+    }
+
+    bool AllocSlot(Shard &shard, Slab *&slab, size_t &slot)
+    {
+        if (shard.entries.size() >= shard.capacity && !Evict(shard)) {
+            return false;
+        }
+        if (shard.freeSlots.empty() && !AddSlab(shard)) {
+            return false;
+        }
+        slab = shard.freeSlots.back().first;
+        slot = shard.freeSlots.back().second;
+        shard.freeSlots.pop_back();
+        return true;
+    }
+
+    bool AddSlab(Shard &shard)
+    {
+        size_t slots = SlotsPerSlab();
+        std::unique_ptr<Slab> slab = std::make_unique<Slab>();
+        slab->owners.assign(slots, nullptr);
+        slab->mem = std::make_unique<PurgeableMem>(slots * sizeof(V),
+            std::make_unique<SlabBuilder>(this, &shard, slab.get()));
+        if (slab->mem->GetContent() == nullptr) {
+            return false;
+        }
+        /* never built means purged, build the empty slab now so later reads do not count rebuilds */
+        if (!slab->mem->BeginWrite()) {
+            return false;
+        }
+        slab->mem->EndWrite();
+        for (size_t i = slots; i > 0; i--) {
+            shard.freeSlots.emplace_back(slab.get(), i - 1);
+        }
+        shard.slabs.emplace_back(std::move(slab));
+        return true;
+    }
+
+    /* evict the least recently used value which is not pinned */
+    bool Evict(Shard &shard)
+    {
+        for (auto pos = shard.lru.rbegin(); pos != shard.lru.rend(); ++pos) {
+            Entry *entry = *pos;
+            if (entry->refs > 0) {
+                continue;
+            }
+            Drop(shard, shard.entries.find(*entry->key));
+            shard.evictions++;
+            return true;
+        }
+        return false;
+    }
+
+    void Drop(Shard &shard, typename std::unordered_map<K, Entry, Hash>::iterator it)
+    {
+        Entry &entry = it->second;
+        entry.slab->owners[entry.slot] = nullptr;
+        shard.freeSlots.emplace_back(entry.slab, entry.slot);
+        shard.lru.erase(entry.lruPos);
+        shard.entries.erase(it);
+    }
+
+    Loader loader_;
+    Hash hash_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_LRU_CACHE_H */
@@ -16,7 +16,9 @@
 #ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEM_H
 #define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEM_H
 
+#include <atomic>
 #include <memory> /* unique_ptr */
+#include <mutex>
 #include <shared_mutex> /* shared_mutex */
 #include <string>
 
@@ -34,10 +36,14 @@ public:
 
 protected:
     std::unique_ptr<UxPageTable> pageTable_ = nullptr;
+    std::atomic<unsigned int> pinDepth_ {0}; /* only 0<->1 transitions walk uxpt */
+    std::mutex pinLock_;
     bool Pin() override;
     bool Unpin() override;
     bool IsPurged() override;
     int GetPinStatus() const override;
+    bool PinRangeIfPresent(size_t offset, size_t len) override;
+    void UnpinRange(size_t offset, size_t len) override;
     bool CreatePurgeableData();
     void AfterRebuildSucc() override;
     std::string ToString() const override;
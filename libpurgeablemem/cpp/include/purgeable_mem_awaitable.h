@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEM_AWAITABLE_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEM_AWAITABLE_H
+
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+
+#include <coroutine>
+#include <functional>
+
+#include "purgeable_mem_base.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+/* Executor runs a task on some other thread, e.g. posts it to a thread pool. */
+using PurgeableExecutor = std::function<void(std::function<void()>)>;
+
+/*
+ * ReadAwaitable: awaitable of PurgeableMemBase::BeginRead().
+ * If the content is present it is pinned without suspending, otherwise the
+ * coroutine suspends and BeginRead(), which may rebuild, runs on @executor.
+ * co_await returns the result of BeginRead(), EndRead() must be called if it is true.
+ */
+class ReadAwaitable {
+public:
+    ReadAwaitable(PurgeableMemBase &obj, PurgeableExecutor executor)
+        : obj_(obj), executor_(std::move(executor))
+    {
+    }
+
+    bool await_ready()
+    {
+        succ_ = obj_.TryBeginRead();
+        return succ_;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        if (!executor_) {
+            /* no executor, rebuild on the awaiting thread */
+            succ_ = obj_.BeginRead();
+            return false;
+        }
+        /*
+         * resuming may destroy this awaitable while the executor is still running,
+         * e.g. an inline executor, so call a local copy and touch no member after it.
+         */
+        PurgeableExecutor executor = std::move(executor_);
+        executor([this, handle]() {
+            succ_ = obj_.BeginRead();
+            handle.resume();
+        });
+        return true;
+    }
+
+    bool await_resume() const
+    {
+        return succ_;
+    }
+
+private:
+    PurgeableMemBase &obj_;
+    PurgeableExecutor executor_;
+    bool succ_ = false;
+};
+
+/* usage: if (co_await ReadAsync(obj, executor)) { ...; obj.EndRead(); } */
+inline ReadAwaitable ReadAsync(PurgeableMemBase &obj, PurgeableExecutor executor = nullptr)
+{
+    return ReadAwaitable(obj, std::move(executor));
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
+
+#endif /* __cpp_impl_coroutine */
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEM_AWAITABLE_H */
@@ -16,14 +16,13 @@
 #ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEM_BASE_H
 #define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEM_BASE_H
 
-#ifndef OHOS_MAXIMUM_PURGEABLE_MEMORY
-#define OHOS_MAXIMUM_PURGEABLE_MEMORY ((1024) * (1024) * (1024)) /* 1G */
-#endif /* OHOS_MAXIMUM_PURGEABLE_MEMORY */
-
+#include <atomic>
+#include <functional> /* function */
 #include <memory> /* unique_ptr */
 #include <shared_mutex> /* shared_mutex */
 #include <string>
 
+#include "pm_budget_c.h" /* OHOS_MAXIMUM_PURGEABLE_MEMORY */
 #include "purgeable_mem_builder.h"
 #include "ux_page_table.h"
 
@@ -42,6 +41,14 @@ public:
      */
     bool BeginRead();
 
+    /*
+     * TryBeginRead: begin read the PurgeableMem obj only if it can be done without blocking.
+     * Return:  return true if the obj's content is present and pinned, EndRead() must be called later.
+     *          return false if the content is purged or another thread holds the obj,
+     *          the content is never rebuilt by this function.
+     */
+    bool TryBeginRead();
+
     /*
      * EndRead: end read the PurgeableMem obj.
      * OS may reclaim the memory of its content
@@ -90,6 +97,35 @@ public:
      */
     size_t GetContentSize();
 
+    /*
+     * ReadOptimistic: copy a small range of content without BeginRead()/EndRead().
+     * Only the range is pinned and no lock is taken. The copy is retried if a write or
+     * rebuild ran meanwhile, and falls back to BeginRead() if the range is purged or
+     * keeps changing.
+     * Input:   @offset, @len: the range in content, @dst: buffer of at least @len bytes.
+     * Return:  true if @dst holds the range, false if the range is invalid or rebuild failed.
+     */
+    bool ReadOptimistic(size_t offset, size_t len, void *dst);
+
+    /*
+     * SetPrefault: populate all pages of content at once before it is rebuilt,
+     * instead of faulting them one by one while building. It helps large objects.
+     * Input:   @enable: true to prefault, false(default) not to.
+     */
+    void SetPrefault(bool enable);
+
+    /*
+     * RegisterPurgeNotify: call @callback soon after content is found purged, so that resources
+     * derived from the content can be released. The obj is checked by the scanner of
+     * PmPurgeNotifierStart() or by PmPurgeNotifierScan(), and also counted by the eventfd of
+     * PmPurgeNotifierGetEventFd(). Derived classes unregister it first in their destructors.
+     * Input:   @callback: called once per purge, may be empty to notify by the eventfd only.
+     * Return:  register result, true is success, while false is fail.
+     * It must not be called by @callback.
+     */
+    bool RegisterPurgeNotify(std::function<void()> callback);
+    void UnregisterPurgeNotify();
+
     /*
      * ResizeData: resize size of the PurgeableMem obj.
      */
@@ -112,14 +148,35 @@ protected:
     size_t dataSizeInput_ = 0;
     std::unique_ptr<PurgeableMemBuilder> builder_ = nullptr;
     unsigned int buildDataCount_ = 0;
-    bool BuildContent();
+    bool prefault_ = false;
+    std::atomic<unsigned int> writers_ {0}; /* running writes and rebuilds */
+    std::atomic<unsigned int> writeSeq_ {0}; /* bumped when a write or rebuild begins */
+    virtual bool BuildContent();
     bool IfNeedRebuild();
+    void MarkWriteBegin();
+    void MarkWriteEnd();
+    /* pin [offset, offset + len) of content if it is present, used by ReadOptimistic() */
+    virtual bool PinRangeIfPresent(size_t offset, size_t len);
+    virtual void UnpinRange(size_t offset, size_t len);
     virtual bool Pin();
     virtual bool Unpin();
     virtual bool IsPurged();
     virtual int GetPinStatus() const;
+    /* called by BeginWrite() before content is pinned, BeginWrite() fails if it returns false */
+    virtual bool BeforeWrite();
     virtual void AfterRebuildSucc();
     virtual std::string ToString() const;
+    /* count content of build @build as purged in the stats page, until it is built again */
+    void MarkPurged(unsigned int build);
+
+private:
+    std::function<void()> purgeCallback_;
+    std::atomic<unsigned int> statsPins_ {0}; /* successful BeginRead/BeginWrite not ended yet */
+    size_t purgedBytes_ = 0; /* counted as purged by the stats page */
+    void StatsOnPin();
+    void StatsOnUnpin();
+    static unsigned int PurgedBuild(void *obj);
+    static void OnPurged(void *obj, void *param);
 };
 } /* namespace PurgeableMem */
 } /* namespace OHOS */
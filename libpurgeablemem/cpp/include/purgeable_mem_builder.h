@@ -18,6 +18,7 @@
 
 #include <memory> /* unique_ptr */
 #include <functional>
+#include <string>
 
 namespace OHOS {
 namespace PurgeableMem {
@@ -38,6 +39,41 @@ public:
      */
     virtual bool Build(void *data, size_t size) = 0;
 
+    /*
+     * Chunk-parallel builders build a large content by BuildChunk() on disjoint ranges concurrently,
+     * instead of Build(). Contents smaller than PARALLEL_BUILD_THRESHOLD are still built by Build().
+     * Return:  true if BuildChunk() of this builder is safe to run concurrently on disjoint ranges.
+     */
+    virtual bool IsChunkParallel() const
+    {
+        return false;
+    }
+
+    /*
+     * Build [offset, offset + len) of the content, called only if IsChunkParallel() returns true.
+     * Input:   data: start address of the whole content, same as Build().
+     * Input:   offset, len: the range to build, page aligned except the end of content.
+     * Return:  build result, content is rebuilt again later if any chunk fails.
+     */
+    virtual bool BuildChunk(void *data, size_t offset, size_t len)
+    {
+        return false;
+    }
+
+    /*
+     * Builders producing the same bytes for the same key let PurgeableMemFd objects of equal key and
+     * size share one content. The key must cover everything Build() depends on.
+     * Output:  key: the content key.
+     * Return:  true if this builder has a content key.
+     */
+    virtual bool GetContentKey(std::string &key) const
+    {
+        return false;
+    }
+
+    static constexpr size_t PARALLEL_BUILD_THRESHOLD = 4 * 1024 * 1024; /* 4M */
+    static constexpr size_t PARALLEL_BUILD_CHUNK = 1024 * 1024; /* 1M */
+
     void SetRebuildSuccessCallback(std::function<void()> &callback)
     {
         rebuildSuccessCallback_ = callback;
@@ -57,6 +93,7 @@ private:
     /* Only called by its friend */
     void AppendBuilder(std::unique_ptr<PurgeableMemBuilder> builder);
     bool BuildAll(void *data, size_t size);
+    bool BuildParallel(void *data, size_t size);
     friend class PurgeableMemBase;
 };
 } /* namespace PurgeableMem */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEMFD_H
+#define OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEMFD_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "purgeable_mem_builder.h"
+#include "purgeable_mem_base.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+/*
+ * Header page at offset 0 of the memfd, shared by all processes mapping it.
+ * Content is valid if builtGeneration == purgeGeneration, Purge() bumps purgeGeneration.
+ * A rebuild is claimed by setting buildOwner to the pid of the builder, others wait for it.
+ */
+struct PurgeableMemFdHeader {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> pinCount; /* PURGING bit is set while Purge() drops the content */
+    std::atomic<uint32_t> buildOwner; /* 0 if nobody rebuilds the content */
+    std::atomic<uint64_t> purgeGeneration;
+    std::atomic<uint64_t> builtGeneration;
+};
+
+struct SharedMemFd;
+
+/*
+ * PurgeableMemFd: purgeable memory backed by a sealed memfd, shareable across processes like
+ * PurgeableAshMem but working on mainline kernels. Content lives after the header page, and
+ * Purge() punches it out of the memfd when nobody in any process pins it.
+ * Objects of the same size whose builders have the same content key share one memfd in a
+ * process, BeginWrite() copies the content to a memfd of its own first, and fails if this obj
+ * still pins the shared content.
+ */
+class PurgeableMemFd : public PurgeableMemBase {
+public:
+    PurgeableMemFd(size_t dataSize, std::unique_ptr<PurgeableMemBuilder> builder);
+    PurgeableMemFd(std::unique_ptr<PurgeableMemBuilder> builder);
+    ~PurgeableMemFd() override;
+    int GetMemFd();
+    void ResizeData(size_t newSize) override;
+
+    /*
+     * ChangeMemFdData: map a memfd created by PurgeableMemFd of another process.
+     * Input:   @size: content size, @fd: the memfd, owned by this obj if success.
+     * Return:  false if @fd is not a PurgeableMemFd of @size.
+     */
+    bool ChangeMemFdData(size_t size, int fd);
+
+    /*
+     * Purge: drop content voluntarily if it is not pinned by any process.
+     * Return:  true if content is dropped, next BeginRead() will rebuild it.
+     */
+    bool Purge();
+
+protected:
+    int memFd_;
+    PurgeableMemFdHeader *header_;
+    std::atomic<unsigned int> pins_ {0}; /* pins of this obj, header_->pinCount counts all objs */
+    bool Pin() override;
+    bool Unpin() override;
+    bool IsPurged() override;
+    int GetPinStatus() const override;
+    std::shared_ptr<SharedMemFd> shared_;
+    bool CreatePurgeableData();
+    bool CreateOrJoinShared(const std::string &key);
+    bool JoinSharedLocked(const std::shared_ptr<SharedMemFd> &shared, size_t size);
+    bool MapMemFd(int fd, size_t size);
+    void UnmapMemFd();
+    bool ClaimBuild();
+    bool BuildContent() override;
+    bool BeforeWrite() override;
+    void AfterRebuildSucc() override;
+    std::string ToString() const override;
+};
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
+#endif /* OHOS_UTILS_MEMORY_LIBPURGEABLEMEM_CPP_INCLUDE_PURGEABLE_MEMFD_H */
@@ -34,6 +34,7 @@ private:
     void GetUxpte(uint64_t addr, size_t len);
     void PutUxpte(uint64_t addr, size_t len);
     bool CheckPresent(uint64_t addr, size_t len);
+    void MarkPresent(uint64_t addr, size_t len);
     std::string ToString() const;
 };
 } /* namespace PurgeableMem */
@@ -20,6 +20,7 @@
 #include "pm_state_c.h"
 #include "pm_smartptr_util.h"
 #include "pm_log.h"
+#include "pm_trace.h"
 
 #include "purgeable_ashmem.h"
 
@@ -79,6 +80,7 @@ PurgeableAshMem::PurgeableAshMem(size_t dataSize, std::unique_ptr<PurgeableMemBu
 
 PurgeableAshMem::~PurgeableAshMem()
 {
+    UnregisterPurgeNotify();
     PM_HILOG_DEBUG(LOG_CORE, "%{public}s %{public}s", __func__, ToString().c_str());
     if (!isChange_ && dataPtr_) {
         if (munmap(dataPtr_, RoundUp(dataSizeInput_, PAGE_SIZE)) != 0) {
@@ -87,6 +89,8 @@ PurgeableAshMem::~PurgeableAshMem()
             if (UxpteIsEnabled() && !IsPurged()) {
                 PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap dataPtr succ, but uxpte present", __func__);
             }
+            PmBudgetUncharge(RoundUp(dataSizeInput_, PAGE_SIZE));
+            PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
             dataPtr_ = nullptr;
             close(ashmemFd_);
         }
@@ -104,6 +108,7 @@ bool PurgeableAshMem::IsPurged()
     if (!isSupport_) {
         return false;
     }
+    PM_TRACE_SCOPE("AshmemIsPurged", 0);
     int ret = ioctl(ashmemFd_, PURGEABLE_ASHMEM_IS_PURGED);
     PM_HILOG_DEBUG(LOG_CORE, "%{public}s: IsPurged %{public}d", __func__, ret);
     return ret > 0 ? true : false;
@@ -116,11 +121,17 @@ bool PurgeableAshMem::CreatePurgeableData()
         return false;
     }
     size_t size = RoundUp(dataSizeInput_, PAGE_SIZE);
+    if (!PmBudgetCharge(size)) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: exceed purgeable budget", __func__);
+        return false;
+    }
     int fd = AshmemCreate("PurgeableAshmem", size);
     if (fd < 0) {
+        PmBudgetUncharge(size);
         return false;
     }
     if (AshmemSetProt(fd, PROT_READ | PROT_WRITE) < 0) {
+        PmBudgetUncharge(size);
         close(fd);
         return false;
     }
@@ -129,10 +140,12 @@ bool PurgeableAshMem::CreatePurgeableData()
     dataPtr_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, ashmemFd_, 0);
     if (dataPtr_ == MAP_FAILED) {
         PM_HILOG_ERROR(LOG_CORE, "%{public}s: mmap fail", __func__);
+        PmBudgetUncharge(size);
         dataPtr_ = nullptr;
         close(ashmemFd_);
         return false;
     }
+    PM_TRACE_PURGEABLE(dataSizeInput_);
     TEMP_FAILURE_RETRY(ioctl(ashmemFd_, ASHMEM_SET_PURGEABLE));
     if (TEMP_FAILURE_RETRY(ioctl(ashmemFd_, ASHMEM_GET_PURGEABLE)) == 1) {
         isSupport_ = true;
@@ -147,6 +160,7 @@ bool PurgeableAshMem::Pin()
         return true;
     }
     if (ashmemFd_ > 0) {
+        PM_TRACE_SCOPE("AshmemPin", dataSizeInput_);
         TEMP_FAILURE_RETRY(ioctl(ashmemFd_, ASHMEM_PIN, &pin_));
         PM_HILOG_DEBUG(LOG_CORE, "%{public}s: fd:%{public}d PURGEABLE_GET_PIN_STATE: %{public}d",
                        __func__, ashmemFd_, ioctl(ashmemFd_, ASHMEM_GET_PIN_STATUS, &pin_));
@@ -163,6 +177,7 @@ bool PurgeableAshMem::Unpin()
         return true;
     }
     if (ashmemFd_ > 0) {
+        PM_TRACE_SCOPE("AshmemUnpin", dataSizeInput_);
         TEMP_FAILURE_RETRY(ioctl(ashmemFd_, ASHMEM_UNPIN, &pin_));
         PM_HILOG_DEBUG(LOG_CORE, "%{public}s: fd:%{public}d PURGEABLE_GET_PIN_STATE: %{public}d",
                        __func__, ashmemFd_, ioctl(ashmemFd_, ASHMEM_GET_PIN_STATUS, &pin_));
@@ -186,6 +201,7 @@ int PurgeableAshMem::GetPinStatus() const
 
 void PurgeableAshMem::AfterRebuildSucc()
 {
+    PM_TRACE_SCOPE("AshmemRebuildSuccess", 0);
     TEMP_FAILURE_RETRY(ioctl(ashmemFd_, PURGEABLE_ASHMEM_REBUILD_SUCCESS));
 }
 
@@ -199,6 +215,10 @@ void PurgeableAshMem::ResizeData(size_t newSize)
         if (munmap(dataPtr_, RoundUp(dataSizeInput_, PAGE_SIZE)) != 0) {
             PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap dataPtr fail", __func__);
         } else {
+            if (!isChange_) {
+                PmBudgetUncharge(RoundUp(dataSizeInput_, PAGE_SIZE));
+                PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
+            }
             dataPtr_ = nullptr;
             if (ashmemFd_ > 0) {
                 close(ashmemFd_);
@@ -222,6 +242,10 @@ bool PurgeableAshMem::ChangeAshmemData(size_t size, int fd, void *data)
         if (munmap(dataPtr_, RoundUp(dataSizeInput_, PAGE_SIZE)) != 0) {
             PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap dataPtr fail", __func__);
         } else {
+            if (!isChange_) {
+                PmBudgetUncharge(RoundUp(dataSizeInput_, PAGE_SIZE));
+                PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
+            }
             dataPtr_ = nullptr;
             if (ashmemFd_ > 0) {
                 close(ashmemFd_);
@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm> /* sort */
+#include <set>
+#include <time.h> /* clock_gettime */
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include <sys/mman.h> /* mmap */
+
+#include "dmabuf_alloc.h"
+#include "pm_budget_c.h"
+#include "pm_util.h"
+#include "pm_smartptr_util.h"
+#include "pm_log.h"
+#include "pm_trace.h"
+
+#include "purgeable_dmabuf.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "PurgeableMem"
+
+static constexpr uint64_t NSEC_PER_SEC = 1000000000;
+
+static std::mutex g_dmaBufLock; /* protects g_dmaBufs, objects in it are alive */
+static std::set<PurgeableDmaBuf *> g_dmaBufs;
+static std::atomic<size_t> g_residentLimit {0};
+static std::atomic<size_t> g_residentBytes {0};
+
+static inline size_t RoundUp(size_t val, size_t align)
+{
+    if (val + align < val || val + align < align) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: Addition overflow!", __func__);
+        return val;
+    }
+    if (align == 0) {
+        return val;
+    }
+    return ((val + align - 1) / align) * align;
+}
+
+static uint64_t NowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * NSEC_PER_SEC + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+PurgeableDmaBuf::PurgeableDmaBuf(const std::string &heapName, size_t dataSize,
+    std::unique_ptr<PurgeableMemBuilder> builder, int ownerId)
+{
+    dataPtr_ = nullptr;
+    builder_ = nullptr;
+    buildDataCount_ = 0;
+    if (dataSize == 0 || dataSize >= OHOS_MAXIMUM_PURGEABLE_MEMORY) {
+        return;
+    }
+    IF_NULL_LOG_ACTION(builder, "%{public}s: input builder nullptr", return);
+    int fd = DmabufHeapOpen(heapName.c_str());
+    if (fd < 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: open heap %{public}s fail", __func__, heapName.c_str());
+        return;
+    }
+    heapFd_ = fd;
+    DmabufHeapBuffer buffer = { 0, 0, 0 };
+    SetOwnerIdForHeapFlags(&buffer, static_cast<enum DmaHeapFlagOwnerId>(ownerId));
+    heapFlags_ = buffer.heapFlags;
+    if (!PmBudgetCharge(RoundUp(dataSize, PAGE_SIZE))) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: exceed purgeable budget", __func__);
+        return;
+    }
+    if (!Reserve(dataSize)) {
+        PmBudgetUncharge(RoundUp(dataSize, PAGE_SIZE));
+        return;
+    }
+    dataSizeInput_ = dataSize;
+    builder_ = std::move(builder);
+    {
+        std::lock_guard<std::mutex> lock(g_dmaBufLock);
+        g_dmaBufs.insert(this);
+    }
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s init succ. %{public}s", __func__, ToString().c_str());
+}
+
+PurgeableDmaBuf::~PurgeableDmaBuf()
+{
+    UnregisterPurgeNotify();
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s %{public}s", __func__, ToString().c_str());
+    {
+        std::lock_guard<std::mutex> lock(g_dmaBufLock);
+        g_dmaBufs.erase(this);
+    }
+    Release();
+    if (dataPtr_) {
+        if (munmap(dataPtr_, bufferSize_) != 0) {
+            PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap fail", __func__);
+        }
+        PmBudgetUncharge(bufferSize_);
+        PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
+        dataPtr_ = nullptr;
+    }
+    if (heapFd_ >= 0) {
+        DmabufHeapClose(static_cast<unsigned int>(heapFd_));
+        heapFd_ = -1;
+    }
+    builder_.reset();
+}
+
+/*
+ * reserve the address range of content, the dmabuf is mapped over it when allocated.
+ * The caller charges the budget before, without bufferLock_ held, as trimmers may purge buffers.
+ */
+bool PurgeableDmaBuf::Reserve(size_t size)
+{
+    size_t bufferSize = RoundUp(size, PAGE_SIZE);
+    void *addr = mmap(nullptr, bufferSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: reserve fail", __func__);
+        return false;
+    }
+    PM_TRACE_PURGEABLE(size);
+    dataPtr_ = addr;
+    bufferSize_ = bufferSize;
+    return true;
+}
+
+/* called with content pinned, so it is not purged meanwhile */
+bool PurgeableDmaBuf::Allocate()
+{
+    size_t limit = g_residentLimit.load();
+    size_t resident = g_residentBytes.fetch_add(bufferSize_) + bufferSize_;
+    if (limit != 0 && resident > limit) {
+        Trim(resident - limit);
+    }
+    DmabufHeapBuffer buffer = { 0, bufferSize_, heapFlags_ };
+    if (DmabufHeapBufferAlloc(static_cast<unsigned int>(heapFd_), &buffer) < 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: alloc %{public}zu fail", __func__, bufferSize_);
+        g_residentBytes.fetch_sub(bufferSize_);
+        return false;
+    }
+    void *addr = mmap(dataPtr_, bufferSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, buffer.fd, 0);
+    if (addr == MAP_FAILED) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: mmap dmabuf fail", __func__);
+        DmabufHeapBufferFree(&buffer);
+        g_residentBytes.fetch_sub(bufferSize_);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(bufferLock_);
+    bufferFd_ = static_cast<int>(buffer.fd);
+    allocated_.store(true);
+    return true;
+}
+
+/* free the dmabuf and put the reservation back, call with bufferLock_ held or when no one else can pin */
+void PurgeableDmaBuf::Release()
+{
+    if (!allocated_.load()) {
+        return;
+    }
+    void *addr = mmap(dataPtr_, bufferSize_, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    if (addr == MAP_FAILED) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: reserve again fail", __func__);
+    }
+    DmabufHeapBuffer buffer = { static_cast<unsigned int>(bufferFd_), bufferSize_, heapFlags_ };
+    DmabufHeapBufferFree(&buffer);
+    bufferFd_ = -1;
+    allocated_.store(false);
+    g_residentBytes.fetch_sub(bufferSize_);
+}
+
+bool PurgeableDmaBuf::Purge()
+{
+    std::lock_guard<std::mutex> lock(bufferLock_);
+    if (pinCount_.load() != 0 || !allocated_.load()) {
+        return false;
+    }
+    PM_TRACE_SCOPE("PurgeableDmaBufPurge", dataSizeInput_);
+    Release();
+    MarkPurged(__atomic_load_n(&buildDataCount_, __ATOMIC_RELAXED));
+    return true;
+}
+
+size_t PurgeableDmaBuf::Trim(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(g_dmaBufLock);
+    std::vector<std::pair<uint64_t, PurgeableDmaBuf *>> candidates;
+    for (PurgeableDmaBuf *obj : g_dmaBufs) {
+        if (obj->allocated_.load() && obj->pinCount_.load() == 0) {
+            candidates.emplace_back(obj->lastUnpinNs_.load(), obj);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    size_t freed = 0;
+    for (size_t i = 0; i < candidates.size() && freed < bytes; i++) {
+        PurgeableDmaBuf *obj = candidates[i].second;
+        if (obj->Purge()) {
+            freed += obj->bufferSize_;
+        }
+    }
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s: need %{public}zu, freed %{public}zu", __func__, bytes, freed);
+    return freed;
+}
+
+void PurgeableDmaBuf::SetResidentLimit(size_t bytes)
+{
+    g_residentLimit.store(bytes);
+}
+
+size_t PurgeableDmaBuf::GetResidentBytes()
+{
+    return g_residentBytes.load();
+}
+
+int PurgeableDmaBuf::GetDmaBufFd()
+{
+    std::lock_guard<std::mutex> lock(bufferLock_);
+    return bufferFd_;
+}
+
+bool PurgeableDmaBuf::Pin()
+{
+    std::lock_guard<std::mutex> lock(bufferLock_);
+    pinCount_.fetch_add(1);
+    return true;
+}
+
+bool PurgeableDmaBuf::Unpin()
+{
+    std::lock_guard<std::mutex> lock(bufferLock_);
+    lastUnpinNs_.store(NowNs());
+    pinCount_.fetch_sub(1);
+    return true;
+}
+
+bool PurgeableDmaBuf::IsPurged()
+{
+    return !allocated_.load();
+}
+
+int PurgeableDmaBuf::GetPinStatus() const
+{
+    return pinCount_.load();
+}
+
+/* a purged buffer is allocated again before rebuild, CPU writes are fenced for devices */
+bool PurgeableDmaBuf::BuildContent()
+{
+    if (!allocated_.load() && !Allocate()) {
+        return false;
+    }
+    unsigned int fd = static_cast<unsigned int>(bufferFd_);
+    DmabufHeapBufferSyncStart(fd, DMA_BUF_HEAP_BUF_SYNC_WRITE);
+    bool succ = PurgeableMemBase::BuildContent();
+    DmabufHeapBufferSyncEnd(fd, DMA_BUF_HEAP_BUF_SYNC_WRITE);
+    return succ;
+}
+
+void PurgeableDmaBuf::ResizeData(size_t newSize)
+{
+    if (newSize == 0 || newSize >= OHOS_MAXIMUM_PURGEABLE_MEMORY || heapFd_ < 0) {
+        PM_HILOG_DEBUG(LOG_CORE, "Failed to apply for memory");
+        return;
+    }
+    size_t newBufferSize = RoundUp(newSize, PAGE_SIZE);
+    if (!PmBudgetCharge(newBufferSize)) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: exceed purgeable budget", __func__);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(bufferLock_);
+    if (pinCount_.load() != 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: resize pinned buffer", __func__);
+        PmBudgetUncharge(newBufferSize);
+        return;
+    }
+    Release();
+    if (dataPtr_) {
+        munmap(dataPtr_, bufferSize_);
+        PmBudgetUncharge(bufferSize_);
+        PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
+        dataPtr_ = nullptr;
+    }
+    dataSizeInput_ = 0;
+    buildDataCount_ = 0;
+    if (Reserve(newSize)) {
+        dataSizeInput_ = newSize;
+    } else {
+        PmBudgetUncharge(newBufferSize);
+    }
+}
+
+std::string PurgeableDmaBuf::ToString() const
+{
+    return "dmabuf fd: " + std::to_string(bufferFd_) + ", size: " + std::to_string(bufferSize_) +
+        ", pinCount: " + std::to_string(GetPinStatus());
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mman.h> /* mmap, mincore */
+#include <sys/stat.h> /* fstat */
+
+#include "pm_util.h"
+#include "pm_smartptr_util.h"
+#include "pm_stats_page_c.h"
+#include "pm_log.h"
+#include "pm_trace.h"
+
+#include "purgeable_file_mem.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "PurgeableMem"
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22 /* linux 5.14 */
+#endif
+
+static constexpr size_t MINCORE_BATCH_PAGES = 256;
+
+static inline size_t RoundUp(size_t val, size_t align)
+{
+    if (val + align < val || val + align < align) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: Addition overflow!", __func__);
+        return val;
+    }
+    if (align == 0) {
+        return val;
+    }
+    return ((val + align - 1) / align) * align;
+}
+
+/* a builder is required by PurgeableMemBase, while content comes from the file */
+class FileRefaultBuilder : public PurgeableMemBuilder {
+public:
+    bool Build(void *data, size_t size) override
+    {
+        return true;
+    }
+};
+
+PurgeableFileMem::PurgeableFileMem(int fd, off_t offset, size_t length)
+{
+    dataPtr_ = nullptr;
+    buildDataCount_ = 0;
+    struct stat st;
+    if (fd < 0 || offset < 0 || length == 0 || length >= OHOS_MAXIMUM_PURGEABLE_MEMORY ||
+        fstat(fd, &st) != 0 || offset > st.st_size || length > static_cast<size_t>(st.st_size - offset)) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: para is invalid", __func__);
+        return;
+    }
+    off_t mapOffset = offset & ~static_cast<off_t>(PAGE_SIZE - 1);
+    size_t delta = static_cast<size_t>(offset - mapOffset);
+    void *base = mmap(nullptr, delta + length, PROT_READ, MAP_PRIVATE, fd, mapOffset);
+    if (base == MAP_FAILED) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: mmap fail", __func__);
+        return;
+    }
+    mapBase_ = base;
+    mapSize_ = delta + length;
+    dataPtr_ = static_cast<char *>(base) + delta;
+    dataSizeInput_ = length;
+    builder_ = std::make_unique<FileRefaultBuilder>();
+    buildDataCount_ = 1; /* content is the file, refaulted on access */
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s init succ. %{public}s", __func__, ToString().c_str());
+}
+
+PurgeableFileMem::~PurgeableFileMem()
+{
+    UnregisterPurgeNotify();
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s %{public}s", __func__, ToString().c_str());
+    if (mapBase_ && munmap(mapBase_, mapSize_) != 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap fail", __func__);
+    }
+    mapBase_ = nullptr;
+    dataPtr_ = nullptr;
+    builder_.reset();
+}
+
+void PurgeableFileMem::ResizeData(size_t newSize)
+{
+    PM_HILOG_ERROR(LOG_CORE, "%{public}s: size of file content is fixed", __func__);
+}
+
+/* page cache may be reclaimed at any time, pins only keep the count */
+bool PurgeableFileMem::Pin()
+{
+    pinCount_.fetch_add(1);
+    return true;
+}
+
+bool PurgeableFileMem::Unpin()
+{
+    if (pinCount_.fetch_sub(1) == 1) {
+        refaultedUnderPin_.store(false);
+    }
+    return true;
+}
+
+int PurgeableFileMem::GetPinStatus() const
+{
+    return pinCount_.load();
+}
+
+/* purged if any page of the mapping is not in page cache */
+bool PurgeableFileMem::IsPurged()
+{
+    IF_NULL_LOG_ACTION(mapBase_, "mapBase_ is nullptr in IsPurged", return false);
+    /* otherwise BeginRead() under memory pressure may refault until it gives up */
+    if (refaultedUnderPin_.load()) {
+        return false;
+    }
+    unsigned char vec[MINCORE_BATCH_PAGES];
+    size_t pages = RoundUp(mapSize_, PAGE_SIZE) / PAGE_SIZE;
+    for (size_t start = 0; start < pages; start += MINCORE_BATCH_PAGES) {
+        size_t cnt = pages - start < MINCORE_BATCH_PAGES ? pages - start : MINCORE_BATCH_PAGES;
+        if (mincore(static_cast<char *>(mapBase_) + start * PAGE_SIZE, cnt * PAGE_SIZE, vec) != 0) {
+            return false;
+        }
+        for (size_t i = 0; i < cnt; i++) {
+            if ((vec[i] & 1) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* rebuild is reading the dropped pages back from the file in one go */
+bool PurgeableFileMem::BuildContent()
+{
+    PM_TRACE_SCOPE("PurgeableFileMemRefault", dataSizeInput_);
+    if (madvise(mapBase_, mapSize_, MADV_POPULATE_READ) != 0) {
+        volatile const char *p = static_cast<volatile const char *>(mapBase_);
+        for (size_t off = 0; off < mapSize_; off += PAGE_SIZE) {
+            (void)p[off];
+        }
+    }
+    buildDataCount_++;
+    /* the content is never built from scratch, each refault is a rebuild */
+    PmStatsPageOnBuild(true, true);
+    if (pinCount_.load() > 0) {
+        refaultedUnderPin_.store(true);
+    }
+    return true;
+}
+
+bool PurgeableFileMem::BeforeWrite()
+{
+    PM_HILOG_ERROR(LOG_CORE, "%{public}s: file content is read-only", __func__);
+    return false;
+}
+
+std::string PurgeableFileMem::ToString() const
+{
+    return "fileMem size: " + std::to_string(dataSizeInput_) + ", pinCount: " + std::to_string(GetPinStatus());
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
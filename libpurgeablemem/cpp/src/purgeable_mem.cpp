@@ -20,6 +20,7 @@
 #include "pm_state_c.h"
 #include "pm_smartptr_util.h"
 #include "pm_log.h"
+#include "pm_trace.h"
 
 #include "purgeable_mem.h"
 
@@ -66,14 +67,17 @@ PurgeableMem::PurgeableMem(size_t dataSize, std::unique_ptr<PurgeableMemBuilder>
 
 PurgeableMem::~PurgeableMem()
 {
+    UnregisterPurgeNotify(); /* the scanner calls IsPurged(), stop it before content is unmapped */
     PM_HILOG_DEBUG(LOG_CORE, "%{public}s %{public}s", __func__, ToString().c_str());
     if (dataPtr_) {
         if (munmap(dataPtr_, RoundUp(dataSizeInput_, PAGE_SIZE)) != 0) {
             PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap dataPtr fail", __func__);
         } else {
-            if (UxpteIsEnabled() && !IsPurged()) {
+            if (UxpteIsKernel() && !IsPurged()) {
                 PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap dataPtr succ, but uxpte present", __func__);
             }
+            PmBudgetUncharge(RoundUp(dataSizeInput_, PAGE_SIZE));
+            PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
             dataPtr_ = nullptr;
         }
     }
@@ -91,17 +95,25 @@ bool PurgeableMem::CreatePurgeableData()
 {
     PM_HILOG_DEBUG(LOG_CORE, "%{public}s", __func__);
     pageTable_ = nullptr;
+    pinDepth_.store(0);
     size_t size = RoundUp(dataSizeInput_, PAGE_SIZE);
     unsigned int utype = MAP_ANONYMOUS;
-    utype |= (UxpteIsEnabled() ? MAP_PURGEABLE : MAP_PRIVATE);
+    utype |= (UxpteIsKernel() ? MAP_PURGEABLE : MAP_PRIVATE);
     int type = static_cast<int>(utype);
 
+    if (!PmBudgetCharge(size)) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: exceed purgeable budget", __func__);
+        dataPtr_ = nullptr;
+        return false;
+    }
     dataPtr_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, type, -1, 0);
     if (dataPtr_ == MAP_FAILED) {
         PM_HILOG_ERROR(LOG_CORE, "%{public}s: mmap fail", __func__);
+        PmBudgetUncharge(size);
         dataPtr_ = nullptr;
         return false;
     }
+    PM_TRACE_PURGEABLE(dataSizeInput_);
     MAKE_UNIQUE(pageTable_, UxPageTable, "constructor uxpt make_unique fail", return false, (uint64_t)dataPtr_, size);
     return true;
 }
@@ -109,24 +121,65 @@ bool PurgeableMem::CreatePurgeableData()
 bool PurgeableMem::Pin()
 {
     IF_NULL_LOG_ACTION(pageTable_, "pageTable_ is nullptrin BeginWrite", return false);
-    pageTable_->GetUxpte((uint64_t)dataPtr_, dataSizeInput_);
+    unsigned int depth = pinDepth_.load();
+    while (depth > 0) {
+        if (pinDepth_.compare_exchange_weak(depth, depth + 1)) {
+            return true;
+        }
+    }
+    std::lock_guard<std::mutex> lock(pinLock_);
+    if (pinDepth_.load() == 0) {
+        pageTable_->GetUxpte((uint64_t)dataPtr_, dataSizeInput_);
+        PM_TRACE_PINNED(dataSizeInput_);
+    }
+    pinDepth_.fetch_add(1);
     return true;
 }
 
 bool PurgeableMem::Unpin()
 {
     IF_NULL_LOG_ACTION(pageTable_, "pageTable_ is nullptrin BeginWrite", return false);
-    pageTable_->PutUxpte((uint64_t)dataPtr_, dataSizeInput_);
+    unsigned int depth = pinDepth_.load();
+    while (depth > 1) {
+        if (pinDepth_.compare_exchange_weak(depth, depth - 1)) {
+            return true;
+        }
+    }
+    std::lock_guard<std::mutex> lock(pinLock_);
+    if (pinDepth_.fetch_sub(1) == 1) {
+        pageTable_->PutUxpte((uint64_t)dataPtr_, dataSizeInput_);
+        PM_TRACE_PINNED(-static_cast<long long>(dataSizeInput_));
+    }
     return true;
 }
 
+bool PurgeableMem::PinRangeIfPresent(size_t offset, size_t len)
+{
+    IF_NULL_LOG_ACTION(pageTable_, "pageTable_ is nullptr in PinRangeIfPresent", return false);
+    uint64_t addr = (uint64_t)dataPtr_ + offset;
+    pageTable_->GetUxpte(addr, len);
+    if (!pageTable_->CheckPresent(addr, len)) {
+        pageTable_->PutUxpte(addr, len);
+        return false;
+    }
+    return true;
+}
+
+void PurgeableMem::UnpinRange(size_t offset, size_t len)
+{
+    IF_NULL_LOG_ACTION(pageTable_, "pageTable_ is nullptr in UnpinRange", return);
+    pageTable_->PutUxpte((uint64_t)dataPtr_ + offset, len);
+}
+
 void PurgeableMem::AfterRebuildSucc()
 {
+    IF_NULL_LOG_ACTION(pageTable_, "pageTable_ is nullptr in AfterRebuildSucc", return);
+    pageTable_->MarkPresent((uint64_t)dataPtr_, dataSizeInput_);
 }
 
 int PurgeableMem::GetPinStatus() const
 {
-    return 0;
+    return static_cast<int>(pinDepth_.load());
 }
 
 void PurgeableMem::ResizeData(size_t newSize)
@@ -139,6 +192,8 @@ void PurgeableMem::ResizeData(size_t newSize)
         if (munmap(dataPtr_, RoundUp(dataSizeInput_, PAGE_SIZE)) != 0) {
             PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap dataPtr fail", __func__);
         } else {
+            PmBudgetUncharge(RoundUp(dataSizeInput_, PAGE_SIZE));
+            PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
             dataPtr_ = nullptr;
         }
     }
@@ -13,13 +13,19 @@
  * limitations under the License.
  */
 
+#include <mutex>
 #include <sys/mman.h> /* mmap */
 
 #include "securec.h"
 #include "pm_util.h"
 #include "pm_state_c.h"
+#include "pm_pin_tracker_c.h"
+#include "pm_prefault_c.h"
+#include "pm_purge_notifier_c.h"
+#include "pm_stats_page_c.h"
 #include "pm_smartptr_util.h"
 #include "pm_log.h"
+#include "pm_trace.h"
 
 #include "purgeable_mem_base.h"
 
@@ -30,6 +36,7 @@ namespace PurgeableMem {
 #endif
 #define LOG_TAG "PurgeableMem"
 const int MAX_BUILD_TRYTIMES = 3;
+const int OPTIMISTIC_READ_TRYTIMES = 3;
 
 static inline size_t RoundUp(size_t val, size_t align)
 {
@@ -49,11 +56,15 @@ PurgeableMemBase::PurgeableMemBase()
 
 PurgeableMemBase::~PurgeableMemBase()
 {
+    UnregisterPurgeNotify();
+    PmPinTrackerForget(this);
+    PmStatsPageClearPurged(&purgedBytes_);
 }
 
 bool PurgeableMemBase::BeginRead()
 {
     std::lock_guard<std::mutex> lock(dataLock_);
+    PM_TRACE_SCOPE("PurgeableMemBeginRead", dataSizeInput_);
     if (!isDataValid_) {
         return false;
     }
@@ -74,10 +85,15 @@ bool PurgeableMemBase::BeginRead()
             break;
         }
 
+        PM_TRACE_BEGIN("PurgeableMemRebuild", dataSizeInput_);
+        MarkWriteBegin();
         bool succ = BuildContent();
         if (succ) {
             AfterRebuildSucc();
+            PmStatsPageClearPurged(&purgedBytes_);
         }
+        MarkWriteEnd();
+        PM_TRACE_END();
         PM_HILOG_DEBUG(LOG_CORE, "%{public}s: purged, built %{public}s", __func__, succ ? "succ" : "fail");
 
         tryTimes++;
@@ -91,13 +107,36 @@ bool PurgeableMemBase::BeginRead()
         PM_HILOG_ERROR(LOG_CORE, "%{public}s: err %{public}s, UxptePut. tryTime:%{public}d",
             __func__, GetPMStateName(err), tryTimes);
         Unpin();
+    } else {
+        PmPinTrackerOnPin(this, dataSizeInput_, __builtin_return_address(0));
+        StatsOnPin();
     }
     return ret;
 }
 
+bool PurgeableMemBase::TryBeginRead()
+{
+    std::unique_lock<std::mutex> lock(dataLock_, std::try_to_lock);
+    if (!lock.owns_lock() || !isDataValid_) {
+        return false;
+    }
+    IF_NULL_LOG_ACTION(dataPtr_, "dataPtr is nullptr in TryBeginRead", return false);
+    IF_NULL_LOG_ACTION(builder_, "builder_ is nullptr in TryBeginRead", return false);
+    Pin();
+    if (!IfNeedRebuild()) {
+        PmPinTrackerOnPin(this, dataSizeInput_, __builtin_return_address(0));
+        StatsOnPin();
+        return true;
+    }
+    Unpin();
+    return false;
+}
+
 void PurgeableMemBase::EndRead()
 {
     if (isDataValid_) {
+        PmPinTrackerOnUnpin(this);
+        StatsOnUnpin();
         Unpin();
     }
 
@@ -108,13 +147,19 @@ bool PurgeableMemBase::BeginWrite()
 {
     PM_HILOG_DEBUG(LOG_CORE, "%{public}s %{public}s", __func__, ToString().c_str());
     std::lock_guard<std::mutex> lock(dataLock_);
+    PM_TRACE_SCOPE("PurgeableMemBeginWrite", dataSizeInput_);
     if (dataPtr_ == nullptr) {
         return false;
     }
     IF_NULL_LOG_ACTION(dataPtr_, "dataPtr is nullptr in BeginWrite", return false);
     IF_NULL_LOG_ACTION(builder_, "builder_ is nullptr in BeginWrite", return false);
+    if (!BeforeWrite()) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: prepare write fail", __func__);
+        return false;
+    }
 
     Pin();
+    MarkWriteBegin();
     PMState err = PM_OK;
     do {
         if (!IfNeedRebuild()) {
@@ -122,19 +167,24 @@ bool PurgeableMemBase::BeginWrite()
             break;
         }
         /* data purged, rebuild it */
+        PM_TRACE_SCOPE("PurgeableMemRebuild", dataSizeInput_);
         if (BuildContent()) {
             /* data rebuild succ, return true */
             AfterRebuildSucc();
+            PmStatsPageClearPurged(&purgedBytes_);
             break;
         }
         err = PMB_BUILD_ALL_FAIL;
     } while (0);
 
     if (err == PM_OK) {
+        PmPinTrackerOnPin(this, dataSizeInput_, __builtin_return_address(0));
+        StatsOnPin();
         return true;
     }
 
     PM_HILOG_ERROR(LOG_CORE, "%{public}s: err %{public}s, UxptePut.", __func__, GetPMStateName(err));
+    MarkWriteEnd();
     Unpin();
     return false;
 }
@@ -142,6 +192,72 @@ bool PurgeableMemBase::BeginWrite()
 void PurgeableMemBase::EndWrite()
 {
     PM_HILOG_DEBUG(LOG_CORE, "%{public}s %{public}s", __func__, ToString().c_str());
+    MarkWriteEnd();
+    PmPinTrackerOnUnpin(this);
+    StatsOnUnpin();
+    Unpin();
+}
+
+void PurgeableMemBase::MarkWriteBegin()
+{
+    writers_.fetch_add(1);
+    writeSeq_.fetch_add(1);
+}
+
+void PurgeableMemBase::MarkWriteEnd()
+{
+    writers_.fetch_sub(1);
+}
+
+bool PurgeableMemBase::ReadOptimistic(size_t offset, size_t len, void *dst)
+{
+    if (dst == nullptr || dataPtr_ == nullptr || offset > dataSizeInput_ || len > dataSizeInput_ - offset) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: para is invalid", __func__);
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+    for (int i = 0; i < OPTIMISTIC_READ_TRYTIMES; i++) {
+        if (buildDataCount_ == 0) {
+            break;
+        }
+        unsigned int seq = writeSeq_.load();
+        if (writers_.load() != 0) {
+            continue;
+        }
+        if (!PinRangeIfPresent(offset, len)) {
+            break;
+        }
+        bool succ = memcpy_s(dst, len, static_cast<char *>(dataPtr_) + offset, len) == EOK;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        succ = succ && writers_.load() == 0 && writeSeq_.load() == seq;
+        UnpinRange(offset, len);
+        if (succ) {
+            return true;
+        }
+    }
+    /* purged or busy, fall back to the pinned path which may rebuild */
+    if (!BeginRead()) {
+        return false;
+    }
+    bool succ = memcpy_s(dst, len, static_cast<char *>(dataPtr_) + offset, len) == EOK;
+    EndRead();
+    return succ;
+}
+
+bool PurgeableMemBase::PinRangeIfPresent(size_t offset, size_t len)
+{
+    Pin();
+    if (IfNeedRebuild()) {
+        Unpin();
+        return false;
+    }
+    return true;
+}
+
+void PurgeableMemBase::UnpinRange(size_t offset, size_t len)
+{
     Unpin();
 }
 
@@ -149,6 +265,10 @@ bool PurgeableMemBase::ModifyContentByBuilder(std::unique_ptr<PurgeableMemBuilde
 {
     IF_NULL_LOG_ACTION(modifier, "input modifier is nullptr", return false);
     std::lock_guard<std::mutex> lock(dataLock_);
+    if (!BeforeWrite()) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: prepare write fail", __func__);
+        return false;
+    }
     if (!modifier->Build(dataPtr_, dataSizeInput_)) {
         PM_HILOG_ERROR(LOG_CORE, "%{public}s: modify content by builder fail!!", __func__);
         return false;
@@ -170,6 +290,11 @@ bool PurgeableMemBase::IfNeedRebuild()
     return false;
 }
 
+bool PurgeableMemBase::BeforeWrite()
+{
+    return true;
+}
+
 void PurgeableMemBase::AfterRebuildSucc()
 {
 }
@@ -194,19 +319,30 @@ bool PurgeableMemBase::IsPurged()
 bool PurgeableMemBase::BuildContent()
 {
     bool succ = false;
+    if (prefault_) {
+        PM_TRACE_SCOPE("PurgeableMemPrefault", dataSizeInput_);
+        PmPrefaultRange(dataPtr_, RoundUp(dataSizeInput_, PAGE_SIZE));
+    }
     /* clear content before rebuild */
     if (memset_s(dataPtr_, RoundUp(dataSizeInput_, PAGE_SIZE), 0, dataSizeInput_) != EOK) {
         PM_HILOG_ERROR(LOG_CORE, "%{public}s, clear content fail", __func__);
         return succ;
     }
     /* builder_ and dataPtr_ is never nullptr since it is checked by BeginAccess() before */
+    PM_TRACE_SCOPE("PurgeableMemBuildAll", dataSizeInput_);
     succ = builder_->BuildAll(dataPtr_, dataSizeInput_);
+    PmStatsPageOnBuild(buildDataCount_ != 0, succ);
     if (succ) {
-        buildDataCount_++;
+        __atomic_add_fetch(&buildDataCount_, 1, __ATOMIC_SEQ_CST);
     }
     return succ;
 }
 
+void PurgeableMemBase::SetPrefault(bool enable)
+{
+    prefault_ = enable;
+}
+
 void PurgeableMemBase::ResizeData(size_t newSize)
 {
 }
@@ -238,6 +374,58 @@ void PurgeableMemBase::SetRebuildSuccessCallback(std::function<void()> &callback
     }
 }
 
+/* unlike IfNeedRebuild(), content never built is not purged. Content found purged counts in the stats page */
+unsigned int PurgeableMemBase::PurgedBuild(void *obj)
+{
+    PurgeableMemBase *self = static_cast<PurgeableMemBase *>(obj);
+    unsigned int builds = __atomic_load_n(&(self->buildDataCount_), __ATOMIC_RELAXED);
+    if (builds == 0 || !self->IsPurged()) {
+        return 0;
+    }
+    self->MarkPurged(builds);
+    return builds;
+}
+
+void PurgeableMemBase::MarkPurged(unsigned int build)
+{
+    PmStatsPageMarkPurged(&purgedBytes_, &buildDataCount_, build, RoundUp(dataSizeInput_, PAGE_SIZE));
+}
+
+/* pinned bytes of the stats page change on the outermost pin of this obj, like PmPinTrackerOnPin() */
+void PurgeableMemBase::StatsOnPin()
+{
+    if (statsPins_.fetch_add(1) == 0) {
+        PmStatsPageAddPinned(static_cast<long long>(RoundUp(dataSizeInput_, PAGE_SIZE)));
+    }
+}
+
+void PurgeableMemBase::StatsOnUnpin()
+{
+    if (statsPins_.fetch_sub(1) == 1) {
+        PmStatsPageAddPinned(-static_cast<long long>(RoundUp(dataSizeInput_, PAGE_SIZE)));
+    }
+}
+
+void PurgeableMemBase::OnPurged(void *obj, void *param)
+{
+    (void)param;
+    static_cast<PurgeableMemBase *>(obj)->purgeCallback_();
+}
+
+bool PurgeableMemBase::RegisterPurgeNotify(std::function<void()> callback)
+{
+    bool notify = static_cast<bool>(callback);
+    /* wait for the running callback before it is replaced */
+    PmPurgeNotifierUnregister(this);
+    purgeCallback_ = std::move(callback);
+    return PmPurgeNotifierRegister(this, PurgedBuild, notify ? OnPurged : nullptr, nullptr);
+}
+
+void PurgeableMemBase::UnregisterPurgeNotify()
+{
+    PmPurgeNotifierUnregister(this);
+}
+
 bool PurgeableMemBase::IsDataValid()
 {
     return isDataValid_;
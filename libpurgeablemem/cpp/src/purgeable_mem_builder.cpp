@@ -13,7 +13,16 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "pm_smartptr_util.h"
+#include "pm_trace.h"
 #include "purgeable_mem_builder.h"
 
 namespace OHOS {
@@ -23,6 +32,117 @@ namespace PurgeableMem {
 #endif
 #define LOG_TAG "PurgeableMem: Builder"
 
+namespace {
+constexpr unsigned int BUILD_POOL_THREADS_MAX = 8;
+
+/*
+ * Threads shared by parallel builds of all objects. The caller of Run() works too, and every
+ * thread claims the next chunk from an atomic counter, so fast threads take over the chunks
+ * slow ones have not reached. One parallel build runs at a time, others build in their caller.
+ */
+class BuildPool {
+public:
+    static BuildPool &Instance()
+    {
+        static BuildPool pool;
+        return pool;
+    }
+
+    /* Run: call @fn(0) ... @fn(@chunks - 1) concurrently, return false if any fails */
+    bool Run(size_t chunks, const std::function<bool(size_t)> &fn)
+    {
+        Job job { fn, chunks };
+        std::unique_lock<std::mutex> runLock(runLock_, std::try_to_lock);
+        if (runLock.owns_lock() && !workers_.empty()) {
+            std::lock_guard<std::mutex> lock(lock_);
+            job_ = &job;
+            jobSeq_++;
+            wakeCv_.notify_all();
+        }
+        Work(job);
+        if (runLock.owns_lock()) {
+            std::unique_lock<std::mutex> lock(lock_);
+            job_ = nullptr; /* no more worker picks it up */
+            doneCv_.wait(lock, [this]() { return activeWorkers_ == 0; });
+        }
+        return !job.failed.load();
+    }
+
+private:
+    struct Job {
+        const std::function<bool(size_t)> &fn;
+        size_t chunks;
+        std::atomic<size_t> next {0};
+        std::atomic<bool> failed {false};
+    };
+
+    BuildPool()
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        unsigned int count = std::min(cores > 1 ? cores - 1 : 0, BUILD_POOL_THREADS_MAX);
+        for (unsigned int i = 0; i < count; i++) {
+            workers_.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~BuildPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            stop_ = true;
+            wakeCv_.notify_all();
+        }
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    static void Work(Job &job)
+    {
+        while (true) {
+            size_t idx = job.next.fetch_add(1);
+            if (idx >= job.chunks) {
+                return;
+            }
+            if (!job.failed.load() && !job.fn(idx)) {
+                job.failed.store(true);
+            }
+        }
+    }
+
+    void WorkerLoop()
+    {
+        unsigned long long seenSeq = 0;
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+            wakeCv_.wait(lock, [this, &seenSeq]() { return stop_ || (job_ != nullptr && jobSeq_ != seenSeq); });
+            if (stop_) {
+                return;
+            }
+            seenSeq = jobSeq_;
+            Job *job = job_;
+            activeWorkers_++;
+            lock.unlock();
+            Work(*job);
+            lock.lock();
+            if (--activeWorkers_ == 0) {
+                doneCv_.notify_all();
+            }
+        }
+    }
+
+    std::mutex runLock_; /* held by the running parallel build */
+    std::mutex lock_; /* protects all below */
+    std::condition_variable wakeCv_;
+    std::condition_variable doneCv_;
+    Job *job_ = nullptr;
+    unsigned long long jobSeq_ = 0;
+    unsigned int activeWorkers_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+};
+} /* namespace */
+
 PurgeableMemBuilder::~PurgeableMemBuilder()
 {
     if (nextBuilder_) {
@@ -42,7 +162,10 @@ void PurgeableMemBuilder::AppendBuilder(std::unique_ptr<PurgeableMemBuilder> bui
 
 bool PurgeableMemBuilder::BuildAll(void *data, size_t size)
 {
-    if (!Build(data, size)) {
+    PM_TRACE_BEGIN("PurgeableMemBuilderBuild", size);
+    bool succ = (IsChunkParallel() && size >= PARALLEL_BUILD_THRESHOLD) ? BuildParallel(data, size) : Build(data, size);
+    PM_TRACE_END();
+    if (!succ) {
         HILOG_ERROR(LOG_CORE, "%{public}s: build(0x%{public}llx, %{public}zu) fail",
             __func__, (unsigned long long)data, size);
         return false;
@@ -52,5 +175,14 @@ bool PurgeableMemBuilder::BuildAll(void *data, size_t size)
     }
     return nextBuilder_->BuildAll(data, size);
 }
+
+bool PurgeableMemBuilder::BuildParallel(void *data, size_t size)
+{
+    size_t chunks = (size + PARALLEL_BUILD_CHUNK - 1) / PARALLEL_BUILD_CHUNK;
+    return BuildPool::Instance().Run(chunks, [this, data, size](size_t idx) {
+        size_t offset = idx * PARALLEL_BUILD_CHUNK;
+        return BuildChunk(data, offset, std::min(PARALLEL_BUILD_CHUNK, size - offset));
+    });
+}
 } /* namespace PurgeableMem */
 } /* namespace OHOS */
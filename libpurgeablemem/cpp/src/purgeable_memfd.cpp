@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <csignal> /* kill */
+#include <fcntl.h> /* fallocate, F_ADD_SEALS */
+#include <linux/falloc.h> /* FALLOC_FL_PUNCH_HOLE */
+#include <sched.h> /* sched_yield */
+#include <sys/mman.h> /* mmap, memfd_create */
+#include <sys/stat.h> /* fstat */
+#include <unistd.h>
+#include <mutex>
+#include <unordered_map>
+
+#include "securec.h"
+#include "pm_util.h"
+#include "pm_smartptr_util.h"
+#include "pm_log.h"
+#include "pm_trace.h"
+
+#include "purgeable_memfd.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "PurgeableMem"
+
+static constexpr uint32_t MEMFD_HEADER_MAGIC = 0x50474d46; /* "PGMF" */
+static constexpr uint32_t MEMFD_HEADER_VERSION = 1;
+static constexpr uint32_t MEMFD_PURGING = 1U << 31;
+static constexpr size_t MEMFD_HEADER_SIZE = PAGE_SIZE;
+static constexpr useconds_t BUILD_WAIT_US = 1000;
+static_assert(sizeof(PurgeableMemFdHeader) <= MEMFD_HEADER_SIZE, "header must fit in one page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "header is shared across processes");
+
+static inline size_t RoundUp(size_t val, size_t align)
+{
+    if (val + align < val || val + align < align) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: Addition overflow!", __func__);
+        return val;
+    }
+    if (align == 0) {
+        return val;
+    }
+    return ((val + align - 1) / align) * align;
+}
+
+/* a memfd shared by objects of the same content key in this process, charged to budget once */
+struct SharedMemFd {
+    std::string key;
+    int fd = -1; /* dup'ed for each object */
+    size_t size = 0;
+    unsigned int refs = 0;
+    std::mutex buildLock; /* one object rebuilds the content for all */
+};
+
+static std::mutex g_sharedLock; /* protects g_sharedMemFds and refs */
+static std::unordered_map<std::string, std::shared_ptr<SharedMemFd>> g_sharedMemFds;
+
+static void LeaveShared(const std::shared_ptr<SharedMemFd> &shared)
+{
+    std::lock_guard<std::mutex> lock(g_sharedLock);
+    if (--(shared->refs) > 0) {
+        return;
+    }
+    g_sharedMemFds.erase(shared->key);
+    close(shared->fd);
+    PmBudgetUncharge(shared->size);
+}
+
+PurgeableMemFd::PurgeableMemFd(std::unique_ptr<PurgeableMemBuilder> builder)
+{
+    dataPtr_ = nullptr;
+    builder_ = nullptr;
+    memFd_ = -1;
+    header_ = nullptr;
+    buildDataCount_ = 0;
+    IF_NULL_LOG_ACTION(builder, "%{public}s: input builder nullptr", return);
+    builder_ = std::move(builder);
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s init succ. %{public}s", __func__, ToString().c_str());
+}
+
+PurgeableMemFd::PurgeableMemFd(size_t dataSize, std::unique_ptr<PurgeableMemBuilder> builder)
+{
+    dataPtr_ = nullptr;
+    builder_ = nullptr;
+    memFd_ = -1;
+    header_ = nullptr;
+    buildDataCount_ = 0;
+    if (dataSize == 0) {
+        return;
+    }
+    dataSizeInput_ = dataSize;
+    IF_NULL_LOG_ACTION(builder, "%{public}s: input builder nullptr", return);
+
+    std::string key;
+    bool created = builder->GetContentKey(key) ? CreateOrJoinShared(key) : CreatePurgeableData();
+    if (!created) {
+        PM_HILOG_DEBUG(LOG_CORE, "Failed to create purgeabledata");
+        return;
+    }
+    builder_ = std::move(builder);
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s init succ. %{public}s", __func__, ToString().c_str());
+}
+
+PurgeableMemFd::~PurgeableMemFd()
+{
+    UnregisterPurgeNotify();
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s %{public}s", __func__, ToString().c_str());
+    UnmapMemFd();
+    builder_.reset();
+}
+
+int PurgeableMemFd::GetMemFd()
+{
+    return memFd_;
+}
+
+bool PurgeableMemFd::CreatePurgeableData()
+{
+    PM_HILOG_DEBUG(LOG_CORE, "%{public}s", __func__);
+    if (dataSizeInput_ == 0) {
+        return false;
+    }
+    size_t size = RoundUp(dataSizeInput_, PAGE_SIZE);
+    int fd = memfd_create("PurgeableMemFd", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: memfd_create fail", __func__);
+        return false;
+    }
+    /* receivers may trust the size, while hole punching is still allowed */
+    if (ftruncate(fd, MEMFD_HEADER_SIZE + size) != 0 ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: resize or seal memfd fail", __func__);
+        close(fd);
+        return false;
+    }
+    if (!MapMemFd(fd, size)) {
+        close(fd);
+        return false;
+    }
+    header_->magic = MEMFD_HEADER_MAGIC;
+    header_->version = MEMFD_HEADER_VERSION;
+    header_->pinCount.store(0);
+    header_->buildOwner.store(0);
+    header_->purgeGeneration.store(1); /* not built yet */
+    header_->builtGeneration.store(0);
+    return true;
+}
+
+bool PurgeableMemFd::JoinSharedLocked(const std::shared_ptr<SharedMemFd> &shared, size_t size)
+{
+    int fd = dup(shared->fd);
+    if (fd < 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: dup fail", __func__);
+        return false;
+    }
+    shared_ = shared;
+    if (!MapMemFd(fd, size)) {
+        close(fd);
+        shared_ = nullptr;
+        return false;
+    }
+    shared_->refs++;
+    buildDataCount_++; /* content may be built by others, the header tells */
+    return true;
+}
+
+bool PurgeableMemFd::CreateOrJoinShared(const std::string &key)
+{
+    size_t size = RoundUp(dataSizeInput_, PAGE_SIZE);
+    std::string sharedKey = key + "@" + std::to_string(size);
+    {
+        std::lock_guard<std::mutex> lock(g_sharedLock);
+        auto it = g_sharedMemFds.find(sharedKey);
+        if (it != g_sharedMemFds.end()) {
+            return JoinSharedLocked(it->second, size);
+        }
+    }
+
+    /* charge without g_sharedLock, trimmers may destroy shared objs, which take it */
+    if (!PmBudgetCharge(size)) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: exceed purgeable budget", __func__);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_sharedLock);
+    auto it = g_sharedMemFds.find(sharedKey);
+    if (it != g_sharedMemFds.end()) {
+        /* created by another thread meanwhile */
+        PmBudgetUncharge(size);
+        return JoinSharedLocked(it->second, size);
+    }
+    shared_ = std::make_shared<SharedMemFd>();
+    if (!CreatePurgeableData()) {
+        shared_ = nullptr;
+        PmBudgetUncharge(size);
+        return false;
+    }
+    shared_->fd = dup(memFd_);
+    if (shared_->fd < 0) {
+        /* not shareable, the charge is taken by this obj */
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: dup fail, not shared", __func__);
+        shared_ = nullptr;
+        return true;
+    }
+    shared_->key = sharedKey;
+    shared_->size = size;
+    shared_->refs = 1;
+    g_sharedMemFds.emplace(sharedKey, shared_);
+    return true;
+}
+
+bool PurgeableMemFd::MapMemFd(int fd, size_t size)
+{
+    /* a shared memfd is charged once by CreateOrJoinShared() */
+    if (!shared_ && !PmBudgetCharge(size)) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: exceed purgeable budget", __func__);
+        return false;
+    }
+    void *base = mmap(nullptr, MEMFD_HEADER_SIZE + size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: mmap fail", __func__);
+        if (!shared_) {
+            PmBudgetUncharge(size);
+        }
+        return false;
+    }
+    PM_TRACE_PURGEABLE(dataSizeInput_);
+    memFd_ = fd;
+    header_ = static_cast<PurgeableMemFdHeader *>(base);
+    dataPtr_ = static_cast<char *>(base) + MEMFD_HEADER_SIZE;
+    return true;
+}
+
+void PurgeableMemFd::UnmapMemFd()
+{
+    if (header_) {
+        if (munmap(header_, MEMFD_HEADER_SIZE + RoundUp(dataSizeInput_, PAGE_SIZE)) != 0) {
+            PM_HILOG_ERROR(LOG_CORE, "%{public}s: munmap fail", __func__);
+        }
+        if (!shared_) {
+            PmBudgetUncharge(RoundUp(dataSizeInput_, PAGE_SIZE));
+        }
+        PM_TRACE_PURGEABLE(-static_cast<long long>(dataSizeInput_));
+        header_ = nullptr;
+        dataPtr_ = nullptr;
+    }
+    if (memFd_ >= 0) {
+        close(memFd_);
+        memFd_ = -1;
+    }
+    if (shared_) {
+        LeaveShared(shared_);
+        shared_ = nullptr;
+    }
+}
+
+bool PurgeableMemFd::Pin()
+{
+    IF_NULL_LOG_ACTION(header_, "header_ is nullptr in Pin", return false);
+    uint32_t old = header_->pinCount.load();
+    while (true) {
+        if (old & MEMFD_PURGING) {
+            sched_yield();
+            old = header_->pinCount.load();
+            continue;
+        }
+        if (header_->pinCount.compare_exchange_weak(old, old + 1)) {
+            pins_.fetch_add(1);
+            return true;
+        }
+    }
+}
+
+bool PurgeableMemFd::Unpin()
+{
+    IF_NULL_LOG_ACTION(header_, "header_ is nullptr in Unpin", return false);
+    pins_.fetch_sub(1);
+    header_->pinCount.fetch_sub(1);
+    return true;
+}
+
+bool PurgeableMemFd::IsPurged()
+{
+    IF_NULL_LOG_ACTION(header_, "header_ is nullptr in IsPurged", return false);
+    return header_->builtGeneration.load() != header_->purgeGeneration.load();
+}
+
+int PurgeableMemFd::GetPinStatus() const
+{
+    if (!header_) {
+        return 0;
+    }
+    return static_cast<int>(header_->pinCount.load() & ~MEMFD_PURGING);
+}
+
+/*
+ * ClaimBuild: claim the rebuild among all processes mapping the memfd, or wait until the
+ * owner of the claim has rebuilt the content. A claim of an exited process is taken over.
+ * Return:  true if this obj rebuilds, false if the content is built by another.
+ */
+bool PurgeableMemFd::ClaimBuild()
+{
+    uint32_t self = static_cast<uint32_t>(getpid());
+    while (IsPurged()) {
+        uint32_t owner = 0;
+        if (header_->buildOwner.compare_exchange_strong(owner, self)) {
+            if (IsPurged()) {
+                return true;
+            }
+            header_->buildOwner.store(0);
+            return false;
+        }
+        if (kill(static_cast<pid_t>(owner), 0) != 0 && errno == ESRCH) {
+            header_->buildOwner.compare_exchange_strong(owner, 0);
+            continue;
+        }
+        usleep(BUILD_WAIT_US);
+    }
+    return false;
+}
+
+bool PurgeableMemFd::BuildContent()
+{
+    std::unique_lock<std::mutex> lock;
+    if (shared_) {
+        lock = std::unique_lock<std::mutex>(shared_->buildLock);
+    }
+    /* other processes mapping the memfd may rebuild it, clearing the content under their readers */
+    if (!ClaimBuild()) {
+        return true;
+    }
+    /* mark it built before others waiting for the claim check it */
+    bool succ = PurgeableMemBase::BuildContent();
+    if (succ) {
+        AfterRebuildSucc();
+    }
+    header_->buildOwner.store(0);
+    return succ;
+}
+
+/* copy on write: move a shared content to a memfd of its own */
+bool PurgeableMemFd::BeforeWrite()
+{
+    if (!shared_) {
+        return true;
+    }
+    /* readers of this obj hold pointers into the shared mapping and pins of its header */
+    if (pins_.load() != 0) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: shared content pinned by this obj", __func__);
+        return false;
+    }
+    Pin();
+    bool present = buildDataCount_ > 0 && !IsPurged();
+    PurgeableMemFdHeader *header = header_;
+    void *dataPtr = dataPtr_;
+    int memFd = memFd_;
+    std::shared_ptr<SharedMemFd> shared = std::move(shared_);
+    header_ = nullptr;
+    dataPtr_ = nullptr;
+    memFd_ = -1;
+    if (!CreatePurgeableData()) {
+        header_ = header;
+        dataPtr_ = dataPtr;
+        memFd_ = memFd;
+        shared_ = std::move(shared);
+        Unpin();
+        return false;
+    }
+    if (present && memcpy_s(dataPtr_, dataSizeInput_, dataPtr, dataSizeInput_) == EOK) {
+        AfterRebuildSucc();
+    }
+    std::swap(header_, header);
+    std::swap(dataPtr_, dataPtr);
+    std::swap(memFd_, memFd);
+    shared_ = std::move(shared);
+    Unpin();
+    UnmapMemFd();
+    header_ = header;
+    dataPtr_ = dataPtr;
+    memFd_ = memFd;
+    return true;
+}
+
+void PurgeableMemFd::AfterRebuildSucc()
+{
+    IF_NULL_LOG_ACTION(header_, "header_ is nullptr in AfterRebuildSucc", return);
+    header_->builtGeneration.store(header_->purgeGeneration.load());
+}
+
+bool PurgeableMemFd::Purge()
+{
+    IF_NULL_LOG_ACTION(header_, "header_ is nullptr in Purge", return false);
+    uint32_t expected = 0;
+    /* lock out Pin() of all processes, like kernel reclaim locks an unpinned uxpte */
+    if (!header_->pinCount.compare_exchange_strong(expected, MEMFD_PURGING)) {
+        return false;
+    }
+    size_t size = RoundUp(dataSizeInput_, PAGE_SIZE);
+    bool succ = fallocate(memFd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, MEMFD_HEADER_SIZE, size) == 0;
+    if (!succ) {
+        succ = madvise(dataPtr_, size, MADV_REMOVE) == 0;
+    }
+    if (succ) {
+        header_->purgeGeneration.fetch_add(1);
+        MarkPurged(__atomic_load_n(&buildDataCount_, __ATOMIC_RELAXED));
+    } else {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: punch hole fail", __func__);
+    }
+    header_->pinCount.store(0);
+    return succ;
+}
+
+void PurgeableMemFd::ResizeData(size_t newSize)
+{
+    if (newSize <= 0 || newSize >= OHOS_MAXIMUM_PURGEABLE_MEMORY) {
+        PM_HILOG_DEBUG(LOG_CORE, "Failed to apply for memory");
+        return;
+    }
+    UnmapMemFd();
+    dataSizeInput_ = newSize;
+    if (!CreatePurgeableData()) {
+        PM_HILOG_DEBUG(LOG_CORE, "Failed to create purgeabledata");
+        return;
+    }
+}
+
+bool PurgeableMemFd::ChangeMemFdData(size_t size, int fd)
+{
+    if (size <= 0 || size >= OHOS_MAXIMUM_PURGEABLE_MEMORY || fd < 0) {
+        PM_HILOG_DEBUG(LOG_CORE, "Failed to apply for memory");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != MEMFD_HEADER_SIZE + RoundUp(size, PAGE_SIZE)) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: memfd size mismatch", __func__);
+        return false;
+    }
+    UnmapMemFd();
+    dataSizeInput_ = size;
+    if (!MapMemFd(fd, RoundUp(size, PAGE_SIZE))) {
+        return false;
+    }
+    if (header_->magic != MEMFD_HEADER_MAGIC || header_->version != MEMFD_HEADER_VERSION) {
+        PM_HILOG_ERROR(LOG_CORE, "%{public}s: not a purgeable memfd", __func__);
+        memFd_ = -1; /* not ours, caller keeps it */
+        UnmapMemFd();
+        return false;
+    }
+    buildDataCount_++;
+    return true;
+}
+
+inline std::string PurgeableMemFd::ToString() const
+{
+    return "memFd: " + std::to_string(memFd_) + ", pinCount: " + std::to_string(GetPinStatus());
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
@@ -69,6 +69,11 @@ bool UxPageTable::CheckPresent(uint64_t addr, size_t len)
     return UxpteIsPresent(uxpt_, addr, len);
 }
 
+void UxPageTable::MarkPresent(uint64_t addr, size_t len)
+{
+    UxpteMarkPresent(uxpt_, addr, len);
+}
+
 std::string UxPageTable::ToString() const
 {
     std::string uxptStr = uxpt_ ? std::to_string((unsigned long long)uxpt_) : "0";
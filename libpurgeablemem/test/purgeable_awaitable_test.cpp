@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory> /* unique_ptr */
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+#define private public
+#define protected public
+#include "purgeable_mem.h"
+#undef private
+#undef protected
+#include "purgeable_mem_awaitable.h"
+
+#if !defined(__cpp_impl_coroutine)
+#error "purgeable_awaitable_test must be built with -std=c++20"
+#endif
+
+namespace OHOS {
+namespace PurgeableMem {
+using namespace testing;
+using namespace testing::ext;
+
+class AlphabetBuilder : public PurgeableMemBuilder {
+public:
+    bool Build(void *data, size_t size)
+    {
+        char *str = static_cast<char *>(data);
+        for (size_t i = 0; i + 1 < size; i++) {
+            str[i] = 'A' + i % 26; /* 26 letters */
+        }
+        str[size - 1] = 0;
+        return true;
+    }
+};
+
+/* fire-and-forget coroutine, its frame is freed when it returns */
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object()
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+struct ReadResult {
+    bool done = false;
+    bool succ = false;
+    int cmp = 1;
+};
+
+static DetachedTask ReadAlphabet(PurgeableMem &obj, PurgeableExecutor executor, ReadResult *result)
+{
+    result->succ = co_await ReadAsync(obj, std::move(executor));
+    if (result->succ) {
+        result->cmp = strncmp("ABCDEFGHIJKLMNOPQRSTUVWXYZ", static_cast<char *>(obj.GetContent()), 26);
+        obj.EndRead();
+    }
+    result->done = true;
+}
+
+class PurgeableAwaitableTest : public testing::Test {
+};
+
+HWTEST_F(PurgeableAwaitableTest, ReadyTest, TestSize.Level1)
+{
+    PurgeableMem pobj(27, std::make_unique<AlphabetBuilder>());
+    ASSERT_TRUE(pobj.BeginRead());
+    pobj.EndRead();
+
+    int posted = 0;
+    ReadResult result;
+    ReadAlphabet(pobj, [&posted](std::function<void()> task) { posted++; task(); }, &result);
+    /* present content is pinned without suspending */
+    EXPECT_EQ(posted, 0);
+    EXPECT_TRUE(result.done);
+    EXPECT_TRUE(result.succ);
+    EXPECT_EQ(result.cmp, 0);
+}
+
+HWTEST_F(PurgeableAwaitableTest, DeferredExecutorTest, TestSize.Level1)
+{
+    PurgeableMem pobj(27, std::make_unique<AlphabetBuilder>());
+    std::vector<std::function<void()>> tasks;
+    ReadResult result;
+    ReadAlphabet(pobj, [&tasks](std::function<void()> task) { tasks.push_back(std::move(task)); }, &result);
+    /* never built, suspends until the executor rebuilds */
+    ASSERT_EQ(tasks.size(), 1U);
+    EXPECT_FALSE(result.done);
+
+    tasks[0]();
+    EXPECT_TRUE(result.done);
+    EXPECT_TRUE(result.succ);
+    EXPECT_EQ(result.cmp, 0);
+}
+
+HWTEST_F(PurgeableAwaitableTest, InlineExecutorTest, TestSize.Level1)
+{
+    PurgeableMem pobj(27, std::make_unique<AlphabetBuilder>());
+    ReadResult result;
+    std::shared_ptr<int> posted = std::make_shared<int>(0);
+    /* the coroutine finishes and frees the awaitable while the executor is running */
+    ReadAlphabet(pobj, [posted](std::function<void()> task) {
+        task();
+        (*posted)++;
+    }, &result);
+    EXPECT_EQ(*posted, 1);
+    EXPECT_TRUE(result.done);
+    EXPECT_TRUE(result.succ);
+    EXPECT_EQ(result.cmp, 0);
+}
+
+HWTEST_F(PurgeableAwaitableTest, ThreadExecutorTest, TestSize.Level1)
+{
+    PurgeableMem pobj(27, std::make_unique<AlphabetBuilder>());
+    std::thread worker;
+    ReadResult result;
+    ReadAlphabet(pobj, [&worker](std::function<void()> task) { worker = std::thread(std::move(task)); }, &result);
+    ASSERT_TRUE(worker.joinable());
+    worker.join();
+    EXPECT_TRUE(result.done);
+    EXPECT_TRUE(result.succ);
+    EXPECT_EQ(result.cmp, 0);
+}
+
+HWTEST_F(PurgeableAwaitableTest, NoExecutorTest, TestSize.Level1)
+{
+    PurgeableMem pobj(27, std::make_unique<AlphabetBuilder>());
+    ReadResult result;
+    ReadAlphabet(pobj, nullptr, &result);
+    EXPECT_TRUE(result.done);
+    EXPECT_TRUE(result.succ);
+    EXPECT_EQ(result.cmp, 0);
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
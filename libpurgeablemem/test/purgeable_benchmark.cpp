@@ -0,0 +1,551 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmarks of libpurgeablemem, run on device:
+ *     ./libpurgeablemem_benchmark
+ * Results are printed and also written as JSON to BENCHMARK_DEFAULT_OUT unless
+ * --benchmark_out is given, so runs can be compared with tools/compare.py of google benchmark.
+ */
+
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/mman.h> /* madvise */
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "benchmark/benchmark.h"
+#include "purgeable_ashmem.h"
+#include "purgeable_lru_cache.h"
+#include "purgeable_mem.h"
+#include "purgeable_mem_c.h"
+
+namespace OHOS {
+namespace PurgeableMem {
+namespace {
+constexpr const char *BENCHMARK_DEFAULT_OUT = "/data/local/tmp/libpurgeablemem_benchmark.json";
+constexpr int64_t BENCH_SIZE_MIN = 4 * 1024;
+constexpr int64_t BENCH_SIZE_MAX = 16 * 1024 * 1024;
+constexpr int64_t BENCH_SIZE_MULT = 16;
+constexpr int64_t CHAIN_MAX = 16;
+constexpr int64_t READ_SIZE = 64 * 1024;
+constexpr int THREADS_MAX = 8;
+constexpr char FILL_CHAR = 'A';
+
+bool FillFuncC(void *data, size_t size, void *param)
+{
+    (void)param;
+    (void)memset(data, FILL_CHAR, size);
+    return true;
+}
+
+bool IncFuncC(void *data, size_t size, void *param)
+{
+    (void)param;
+    static_cast<char *>(data)[0]++;
+    return true;
+}
+
+class FillBuilder : public PurgeableMemBuilder {
+public:
+    bool Build(void *data, size_t size) override
+    {
+        (void)memset(data, FILL_CHAR, size);
+        return true;
+    }
+};
+
+class IncBuilder : public PurgeableMemBuilder {
+public:
+    bool Build(void *data, size_t size) override
+    {
+        static_cast<char *>(data)[0]++;
+        return true;
+    }
+};
+
+template <class T>
+std::unique_ptr<T> MakeObj(size_t size)
+{
+    return std::make_unique<T>(size, std::make_unique<FillBuilder>());
+}
+
+void SetBytes(benchmark::State &state, int64_t bytesPerIter)
+{
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * bytesPerIter);
+}
+
+int OpenPageFaultCounter()
+{
+    struct perf_event_attr attr = {};
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+/*
+ * page fault traps of the calling thread, -1 if perf events are not available.
+ * Unlike ru_minflt, pages faulted in by MADV_POPULATE_WRITE are not counted.
+ */
+int64_t PageFaults()
+{
+    static thread_local int fd = OpenPageFaultCounter();
+    uint64_t count = 0;
+    if (fd < 0 || read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+        return -1;
+    }
+    return static_cast<int64_t>(count);
+}
+
+void SetFaults(benchmark::State &state, int64_t faults)
+{
+    if (PageFaults() < 0) {
+        return;
+    }
+    state.counters["pgfault"] = benchmark::Counter(static_cast<double>(faults), benchmark::Counter::kAvgIterations);
+}
+
+/* ---------------- create / destroy ---------------- */
+void BM_CCreateDestroy(benchmark::State &state)
+{
+    size_t size = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        struct PurgMem *obj = PurgMemCreate(size, FillFuncC, nullptr);
+        benchmark::DoNotOptimize(obj);
+        PurgMemDestroy(obj);
+    }
+    SetBytes(state, state.range(0));
+}
+BENCHMARK(BM_CCreateDestroy)->RangeMultiplier(BENCH_SIZE_MULT)->Range(BENCH_SIZE_MIN, BENCH_SIZE_MAX);
+
+template <class T>
+void BM_CppCreateDestroy(benchmark::State &state)
+{
+    size_t size = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        auto obj = MakeObj<T>(size);
+        benchmark::DoNotOptimize(obj.get());
+    }
+    SetBytes(state, state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_CppCreateDestroy, PurgeableMem)
+    ->RangeMultiplier(BENCH_SIZE_MULT)->Range(BENCH_SIZE_MIN, BENCH_SIZE_MAX);
+BENCHMARK_TEMPLATE(BM_CppCreateDestroy, PurgeableAshMem)
+    ->RangeMultiplier(BENCH_SIZE_MULT)->Range(BENCH_SIZE_MIN, BENCH_SIZE_MAX);
+
+/* ---------------- BeginRead / EndRead hot loop ---------------- */
+void BM_CReadHot(benchmark::State &state)
+{
+    struct PurgMem *obj = PurgMemCreate(static_cast<size_t>(state.range(0)), FillFuncC, nullptr);
+    if (obj == nullptr || !PurgMemBeginRead(obj)) {
+        state.SkipWithError("create or first read fail");
+        PurgMemDestroy(obj);
+        return;
+    }
+    PurgMemEndRead(obj);
+    for (auto _ : state) {
+        if (PurgMemBeginRead(obj)) {
+            benchmark::DoNotOptimize(*static_cast<char *>(PurgMemGetContent(obj)));
+            PurgMemEndRead(obj);
+        }
+    }
+    PurgMemDestroy(obj);
+}
+BENCHMARK(BM_CReadHot)->RangeMultiplier(BENCH_SIZE_MULT)->Range(BENCH_SIZE_MIN, BENCH_SIZE_MAX);
+
+template <class T>
+void BM_CppReadHot(benchmark::State &state)
+{
+    auto obj = MakeObj<T>(static_cast<size_t>(state.range(0)));
+    if (!obj->BeginRead()) {
+        state.SkipWithError("first read fail");
+        return;
+    }
+    obj->EndRead();
+    for (auto _ : state) {
+        if (obj->BeginRead()) {
+            benchmark::DoNotOptimize(*static_cast<char *>(obj->GetContent()));
+            obj->EndRead();
+        }
+    }
+}
+BENCHMARK_TEMPLATE(BM_CppReadHot, PurgeableMem)
+    ->RangeMultiplier(BENCH_SIZE_MULT)->Range(BENCH_SIZE_MIN, BENCH_SIZE_MAX);
+BENCHMARK_TEMPLATE(BM_CppReadHot, PurgeableAshMem)
+    ->RangeMultiplier(BENCH_SIZE_MULT)->Range(BENCH_SIZE_MIN, BENCH_SIZE_MAX);
+
+/*
+ * ---------------- rebuild vs size and chain length ----------------
+ * A new obj has never been built, so its first BeginRead runs the whole builder chain,
+ * that is the same work as a rebuild after purge, without depending on kernel reclaim.
+ */
+void BM_CRebuild(benchmark::State &state)
+{
+    size_t size = static_cast<size_t>(state.range(0));
+    int64_t chain = state.range(1);
+    for (auto _ : state) {
+        state.PauseTiming();
+        struct PurgMem *obj = PurgMemCreate(size, FillFuncC, nullptr);
+        for (int64_t i = 1; i < chain; i++) {
+            PurgMemAppendModify(obj, IncFuncC, nullptr);
+        }
+        state.ResumeTiming();
+        if (PurgMemBeginRead(obj)) {
+            PurgMemEndRead(obj);
+        }
+        state.PauseTiming();
+        PurgMemDestroy(obj);
+        state.ResumeTiming();
+    }
+    SetBytes(state, state.range(0));
+}
+BENCHMARK(BM_CRebuild)->ArgsProduct({
+    benchmark::CreateRange(BENCH_SIZE_MIN, BENCH_SIZE_MAX, BENCH_SIZE_MULT), benchmark::CreateRange(1, CHAIN_MAX, 4)});
+
+template <class T>
+void BM_CppRebuild(benchmark::State &state)
+{
+    size_t size = static_cast<size_t>(state.range(0));
+    int64_t chain = state.range(1);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto obj = MakeObj<T>(size);
+        for (int64_t i = 1; i < chain; i++) {
+            obj->ModifyContentByBuilder(std::make_unique<IncBuilder>());
+        }
+        state.ResumeTiming();
+        if (obj->BeginRead()) {
+            obj->EndRead();
+        }
+        state.PauseTiming();
+        obj.reset();
+        state.ResumeTiming();
+    }
+    SetBytes(state, state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_CppRebuild, PurgeableMem)->ArgsProduct({
+    benchmark::CreateRange(BENCH_SIZE_MIN, BENCH_SIZE_MAX, BENCH_SIZE_MULT), benchmark::CreateRange(1, CHAIN_MAX, 4)});
+BENCHMARK_TEMPLATE(BM_CppRebuild, PurgeableAshMem)->ArgsProduct({
+    benchmark::CreateRange(BENCH_SIZE_MIN, BENCH_SIZE_MAX, BENCH_SIZE_MULT), benchmark::CreateRange(1, CHAIN_MAX, 4)});
+
+/* FillBuilder building disjoint chunks concurrently */
+class ChunkFillBuilder : public FillBuilder {
+public:
+    bool IsChunkParallel() const override
+    {
+        return true;
+    }
+
+    bool BuildChunk(void *data, size_t offset, size_t len) override
+    {
+        (void)memset(static_cast<char *>(data) + offset, FILL_CHAR, len);
+        return true;
+    }
+};
+
+template <class B>
+void BM_CppRebuildLarge(benchmark::State &state)
+{
+    size_t size = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto obj = std::make_unique<PurgeableMem>(size, std::make_unique<B>());
+        state.ResumeTiming();
+        if (obj->BeginRead()) {
+            obj->EndRead();
+        }
+        state.PauseTiming();
+        obj.reset();
+        state.ResumeTiming();
+    }
+    SetBytes(state, state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_CppRebuildLarge, FillBuilder)->RangeMultiplier(4)->Range(4 << 20, 128 << 20)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CppRebuildLarge, ChunkFillBuilder)->RangeMultiplier(4)->Range(4 << 20, 128 << 20)->UseRealTime();
+
+/*
+ * ---------------- rebuild with and without prefault ----------------
+ * Pages are dropped before each rebuild like kernel reclaim does. pgfault counts the page
+ * fault traps taken by the rebuild, which MADV_POPULATE_WRITE saves. It is not reported
+ * if perf events are not available.
+ */
+void BM_CRebuildPrefault(benchmark::State &state)
+{
+    size_t size = static_cast<size_t>(state.range(0));
+    int64_t faults = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        struct PurgMem *obj = PurgMemCreate(size, FillFuncC, nullptr);
+        PurgMemSetPrefault(obj, state.range(1) != 0);
+        (void)madvise(PurgMemGetContent(obj), size, MADV_DONTNEED);
+        int64_t before = PageFaults();
+        state.ResumeTiming();
+        if (PurgMemBeginRead(obj)) {
+            PurgMemEndRead(obj);
+        }
+        state.PauseTiming();
+        faults += PageFaults() - before;
+        PurgMemDestroy(obj);
+        state.ResumeTiming();
+    }
+    SetBytes(state, state.range(0));
+    SetFaults(state, faults);
+}
+BENCHMARK(BM_CRebuildPrefault)->ArgsProduct({ benchmark::CreateRange(1 << 20, 64 << 20, 4), { 0, 1 } })
+    ->UseRealTime();
+
+void BM_CppRebuildPrefault(benchmark::State &state)
+{
+    size_t size = static_cast<size_t>(state.range(0));
+    int64_t faults = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto obj = MakeObj<PurgeableMem>(size);
+        obj->SetPrefault(state.range(1) != 0);
+        int64_t before = PageFaults();
+        state.ResumeTiming();
+        if (obj->BeginRead()) {
+            obj->EndRead();
+        }
+        state.PauseTiming();
+        faults += PageFaults() - before;
+        obj.reset();
+        state.ResumeTiming();
+    }
+    SetBytes(state, state.range(0));
+    SetFaults(state, faults);
+}
+BENCHMARK(BM_CppRebuildPrefault)->ArgsProduct({ benchmark::CreateRange(1 << 20, 64 << 20, 4), { 0, 1 } })
+    ->UseRealTime();
+
+/* ---------------- N thread contention ---------------- */
+struct PurgMem *SharedCObj()
+{
+    static struct PurgMem *obj = []() {
+        struct PurgMem *p = PurgMemCreate(READ_SIZE, FillFuncC, nullptr);
+        if (p != nullptr && PurgMemBeginRead(p)) {
+            PurgMemEndRead(p);
+        }
+        return p;
+    }();
+    return obj;
+}
+
+template <class T>
+T *SharedCppObj()
+{
+    static std::unique_ptr<T> obj = []() {
+        auto p = MakeObj<T>(READ_SIZE);
+        if (p->BeginRead()) {
+            p->EndRead();
+        }
+        return p;
+    }();
+    return obj.get();
+}
+
+void BM_CContendOneObj(benchmark::State &state)
+{
+    struct PurgMem *obj = SharedCObj();
+    for (auto _ : state) {
+        if (PurgMemBeginRead(obj)) {
+            benchmark::DoNotOptimize(*static_cast<char *>(PurgMemGetContent(obj)));
+            PurgMemEndRead(obj);
+        }
+    }
+}
+BENCHMARK(BM_CContendOneObj)->ThreadRange(1, THREADS_MAX)->UseRealTime();
+
+void BM_CContendManyObj(benchmark::State &state)
+{
+    struct PurgMem *obj = PurgMemCreate(READ_SIZE, FillFuncC, nullptr);
+    for (auto _ : state) {
+        if (PurgMemBeginRead(obj)) {
+            benchmark::DoNotOptimize(*static_cast<char *>(PurgMemGetContent(obj)));
+            PurgMemEndRead(obj);
+        }
+    }
+    PurgMemDestroy(obj);
+}
+BENCHMARK(BM_CContendManyObj)->ThreadRange(1, THREADS_MAX)->UseRealTime();
+
+template <class T>
+void BM_CppContendOneObj(benchmark::State &state)
+{
+    T *obj = SharedCppObj<T>();
+    for (auto _ : state) {
+        if (obj->BeginRead()) {
+            benchmark::DoNotOptimize(*static_cast<char *>(obj->GetContent()));
+            obj->EndRead();
+        }
+    }
+}
+BENCHMARK_TEMPLATE(BM_CppContendOneObj, PurgeableMem)->ThreadRange(1, THREADS_MAX)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CppContendOneObj, PurgeableAshMem)->ThreadRange(1, THREADS_MAX)->UseRealTime();
+
+template <class T>
+void BM_CppContendManyObj(benchmark::State &state)
+{
+    auto obj = MakeObj<T>(READ_SIZE);
+    for (auto _ : state) {
+        if (obj->BeginRead()) {
+            benchmark::DoNotOptimize(*static_cast<char *>(obj->GetContent()));
+            obj->EndRead();
+        }
+    }
+}
+BENCHMARK_TEMPLATE(BM_CppContendManyObj, PurgeableMem)->ThreadRange(1, THREADS_MAX)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CppContendManyObj, PurgeableAshMem)->ThreadRange(1, THREADS_MAX)->UseRealTime();
+
+struct CacheValue {
+    uint64_t words[32]; /* 32: 256 bytes per value */
+};
+
+bool LoadCacheValue(const uint64_t &key, CacheValue &value)
+{
+    for (uint64_t &word : value.words) {
+        word = key;
+    }
+    return true;
+}
+
+/* plain heap LRU as baseline of PurgeableLruCache, same capacity means same memory budget */
+class HeapLruCache {
+public:
+    HeapLruCache(size_t capacity, bool (*loader)(const uint64_t &, CacheValue &))
+        : capacity_(capacity), loader_(loader) {}
+
+    bool Get(uint64_t key, CacheValue &out)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            out = it->second->second;
+            return true;
+        }
+        CacheValue value;
+        if (!loader_(key, value)) {
+            return false;
+        }
+        if (entries_.size() >= capacity_ && !lru_.empty()) {
+            entries_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+        lru_.emplace_front(key, value);
+        entries_[key] = lru_.begin();
+        out = value;
+        return true;
+    }
+
+private:
+    size_t capacity_;
+    bool (*loader_)(const uint64_t &, CacheValue &);
+    std::mutex lock_;
+    std::list<std::pair<uint64_t, CacheValue>> lru_;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, CacheValue>>::iterator> entries_;
+};
+
+/* 80% of gets hit the hottest 20% of 2 * capacity keys */
+uint64_t NextCacheKey(uint64_t &seed, uint64_t capacity)
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; /* LCG of MMIX */
+    uint64_t rnd = seed >> 33; /* 33: use high bits */
+    uint64_t keys = capacity * 2;
+    return (rnd % 10 < 8) ? rnd % (keys / 5) : rnd % keys; /* 10, 8, 5: 80% in 20% */
+}
+
+constexpr int64_t CACHE_CAPACITY_MIN = 1024;
+constexpr int64_t CACHE_CAPACITY_MAX = 64 * 1024;
+
+void BM_PurgeableLruCacheGet(benchmark::State &state)
+{
+    static std::unique_ptr<PurgeableLruCache<uint64_t, CacheValue>> cache;
+    if (state.thread_index() == 0) {
+        cache = std::make_unique<PurgeableLruCache<uint64_t, CacheValue>>(state.range(0), LoadCacheValue);
+    }
+    uint64_t seed = static_cast<uint64_t>(state.thread_index()) + 1;
+    for (auto _ : state) {
+        auto handle = cache->Get(NextCacheKey(seed, state.range(0)));
+        if (handle) {
+            benchmark::DoNotOptimize(handle->words[0]);
+        }
+    }
+    if (state.thread_index() == 0) {
+        PurgeableLruCacheStats stats = cache->GetStats();
+        state.counters["hitRate"] = static_cast<double>(stats.hits) / (stats.hits + stats.misses);
+        state.counters["purgeRebuilds"] = stats.purgeRebuilds;
+        cache.reset();
+    }
+}
+BENCHMARK(BM_PurgeableLruCacheGet)->RangeMultiplier(BENCH_SIZE_MULT)->Range(CACHE_CAPACITY_MIN, CACHE_CAPACITY_MAX)
+    ->ThreadRange(1, THREADS_MAX)->UseRealTime();
+
+void BM_HeapLruCacheGet(benchmark::State &state)
+{
+    static std::unique_ptr<HeapLruCache> cache;
+    if (state.thread_index() == 0) {
+        cache = std::make_unique<HeapLruCache>(state.range(0), LoadCacheValue);
+    }
+    uint64_t seed = static_cast<uint64_t>(state.thread_index()) + 1;
+    CacheValue value;
+    for (auto _ : state) {
+        if (cache->Get(NextCacheKey(seed, state.range(0)), value)) {
+            benchmark::DoNotOptimize(value.words[0]);
+        }
+    }
+    if (state.thread_index() == 0) {
+        cache.reset();
+    }
+}
+BENCHMARK(BM_HeapLruCacheGet)->RangeMultiplier(BENCH_SIZE_MULT)->Range(CACHE_CAPACITY_MIN, CACHE_CAPACITY_MAX)
+    ->ThreadRange(1, THREADS_MAX)->UseRealTime();
+} /* namespace */
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
+
+int main(int argc, char **argv)
+{
+    std::vector<char *> args(argv, argv + argc);
+    bool hasOut = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--benchmark_out=", strlen("--benchmark_out=")) == 0) {
+            hasOut = true;
+        }
+    }
+    std::string outArg = std::string("--benchmark_out=") + OHOS::PurgeableMem::BENCHMARK_DEFAULT_OUT;
+    std::string formatArg = "--benchmark_out_format=json";
+    if (!hasOut) {
+        args.push_back(outArg.data());
+        args.push_back(formatArg.data());
+    }
+    int newArgc = static_cast<int>(args.size());
+    benchmark::Initialize(&newArgc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(newArgc, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -13,12 +13,28 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <cstdio>
 #include <climits>
+#include <cstring>
+#include <dirent.h>
+#include <string>
 #include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "gtest/gtest.h"
+#include "mem_stats_page.h"
+#include "pm_budget_c.h"
+#include "pm_pin_tracker_c.h"
+#include "pm_prefault_c.h"
+#include "pm_purge_notifier_c.h"
+#include "pm_stats_page_c.h"
+#include "pm_util.h"
 #include "purgeable_mem_c.h"
+#include "ux_page_table_c.h"
 
 namespace {
 using namespace testing;
@@ -38,6 +54,42 @@ static constexpr int PRINT_INTERVAL_SECONDS = 1;
 static constexpr int RECLAIM_INTERVAL_SECONDS = 1;
 static constexpr int MODIFY_INTERVAL_SECONDS = 2;
 
+/* map the stats page published by this process, as libmeminfo does for other processes */
+const struct MemStatsPage *MapStatsPageOfSelf(enum MemStatsSource source)
+{
+    const std::string link = std::string("/memfd:") + MEM_STATS_PAGE_NAME;
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == nullptr) {
+        return nullptr;
+    }
+    const struct MemStatsPage *found = nullptr;
+    struct dirent *ent;
+    while (found == nullptr && (ent = readdir(dir)) != nullptr) {
+        std::string path = std::string("/proc/self/fd/") + ent->d_name;
+        char buf[PATH_MAX] = {0};
+        if (readlink(path.c_str(), buf, sizeof(buf) - 1) <= 0 || strncmp(buf, link.c_str(), link.size()) != 0) {
+            continue;
+        }
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+        void *addr = mmap(nullptr, MEM_STATS_PAGE_LEN, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            continue;
+        }
+        const struct MemStatsPage *page = static_cast<const struct MemStatsPage *>(addr);
+        if (page->source == source) {
+            found = page;
+        } else {
+            munmap(addr, MEM_STATS_PAGE_LEN);
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
 bool InitData(void *data, size_t size, char start, char end);
 bool ModifyData(void *data, size_t size, char src, char dst);
 bool InitAlphabet(void *data, size_t size, void *param);
@@ -46,6 +98,7 @@ void LoopPrintAlphabet(struct PurgMem *pdata, unsigned int loopCount);
 bool ReclaimPurgeable(void);
 void LoopReclaimPurgeable(unsigned int loopCount);
 void ModifyPurgMemByFunc(struct PurgMem *pdata, PurgMemModifyFunc Modfunc, void *param);
+const struct MemStatsPage *MapStatsPageOfSelf(enum MemStatsSource source);
 
 class PurgeableCTest : public testing::Test {
 public:
@@ -175,6 +228,345 @@ HWTEST_F(PurgeableCTest, ReadWriteTest, TestSize.Level1)
     PurgMemDestroy(pobj);
 }
 
+HWTEST_F(PurgeableCTest, ReadOptimisticTest, TestSize.Level1)
+{
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+    char buf[4] = {0};
+    /* never built, falls back to rebuild */
+    ASSERT_TRUE(PurgMemTryReadOptimistic(pobj, 1, 3, buf));
+    ASSERT_EQ(strncmp(buf, "BCD", 3), 0);
+    ASSERT_TRUE(PurgMemTryReadOptimistic(pobj, 23, 3, buf));
+    ASSERT_EQ(strncmp(buf, "XYZ", 3), 0);
+    ASSERT_TRUE(PurgMemTryReadOptimistic(pobj, 0, 0, buf));
+    ASSERT_FALSE(PurgMemTryReadOptimistic(pobj, 26, 2, buf));
+    ASSERT_FALSE(PurgMemTryReadOptimistic(pobj, 0, 1, nullptr));
+    ASSERT_FALSE(PurgMemTryReadOptimistic(nullptr, 0, 1, buf));
+
+    struct AlphabetModifyParam a2b = {'A', 'B'};
+    ASSERT_TRUE(PurgMemBeginWrite(pobj));
+    PurgMemAppendModify(pobj, ModifyAlphabetX2Y, static_cast<void *>(&a2b));
+    PurgMemEndWrite(pobj);
+    ASSERT_TRUE(PurgMemTryReadOptimistic(pobj, 0, 2, buf));
+    ASSERT_EQ(strncmp(buf, "BB", 2), 0);
+
+    PurgMemDestroy(pobj);
+}
+
+HWTEST_F(PurgeableCTest, BudgetTest, TestSize.Level1)
+{
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    ASSERT_EQ(PurgMemCreate(OHOS_MAXIMUM_PURGEABLE_MEMORY, InitAlphabet, &initPara), nullptr);
+
+    size_t base = PmBudgetGetUsage();
+    PmBudgetSetLimit(base + PAGE_SIZE);
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE);
+    EXPECT_EQ(PurgMemCreate(27, InitAlphabet, &initPara), nullptr);
+    PurgMemDestroy(pobj);
+    EXPECT_EQ(PmBudgetGetUsage(), base);
+    PmBudgetSetLimit(0);
+}
+
+HWTEST_F(PurgeableCTest, PrefaultTest, TestSize.Level1)
+{
+    const size_t pages = 4;
+    char *region = static_cast<char *>(mmap(nullptr, pages * PAGE_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    ASSERT_NE(region, MAP_FAILED);
+    region[0] = 'A';
+    ASSERT_FALSE(PmPrefaultRange(nullptr, PAGE_SIZE));
+    ASSERT_FALSE(PmPrefaultRange(region + 1, PAGE_SIZE));
+    ASSERT_TRUE(PmPrefaultRange(region, pages * PAGE_SIZE));
+    unsigned char vec[pages] = {0};
+    ASSERT_EQ(mincore(region, pages * PAGE_SIZE, vec), 0);
+    for (size_t i = 0; i < pages; i++) {
+        EXPECT_EQ(vec[i] & 1, 1);
+    }
+    EXPECT_EQ(region[0], 'A');
+    munmap(region, pages * PAGE_SIZE);
+
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+    PurgMemSetPrefault(pobj, true);
+    LoopReclaimPurgeable(1);
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    ASSERT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+    PurgMemEndRead(pobj);
+    PurgMemDestroy(pobj);
+}
+
+HWTEST_F(PurgeableCTest, LazyFreeTest, TestSize.Level1)
+{
+    if (!UxpteIsLazyFree()) {
+        GTEST_SKIP() << "MADV_FREE fallback not used";
+    }
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    ASSERT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+    PurgMemEndRead(pobj);
+
+    /* unpinned but not freed by kernel: content is kept */
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    ASSERT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+    PurgMemEndRead(pobj);
+
+    /* drop the unpinned page like kernel reclaim does, content is rebuilt */
+    void *page = PurgMemGetContent(pobj);
+    ASSERT_EQ(madvise(page, PAGE_SIZE, MADV_DONTNEED), 0);
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    ASSERT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+    PurgMemEndRead(pobj);
+
+    PurgMemDestroy(pobj);
+}
+
+HWTEST_F(PurgeableCTest, LongPinWatchdogTest, TestSize.Level1)
+{
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+    static std::atomic<int> reports {0};
+    reports = 0;
+    auto onLongPin = [](const PmLongPinInfo *info, void *param) {
+        if (info->obj == param && info->size == 27) {
+            reports++;
+        }
+    };
+    ASSERT_TRUE(PmPinTrackerEnable(10, onLongPin, pobj));
+
+    /* short pin is not reported */
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    PurgMemEndRead(pobj);
+    ASSERT_TRUE(PurgMemBeginWrite(pobj));
+    for (int i = 0; i < 100 && reports == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(reports, 1);
+    PurgMemEndWrite(pobj);
+    EXPECT_EQ(PmPinTrackerCheck(), 0U);
+
+    /* destroying a pinned obj drops its record */
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    PurgMemDestroy(pobj);
+    EXPECT_EQ(PmPinTrackerCheck(), 0U);
+    PmPinTrackerDisable();
+}
+
+HWTEST_F(PurgeableCTest, UxptEmuReclaimTest, TestSize.Level1)
+{
+    /* all objs of previous cases are destroyed, so the emulator can be switched on */
+    if (UxpteIsKernel()) {
+        GTEST_SKIP() << "kernel supports uxpt";
+    }
+    ASSERT_TRUE(UxptEmuEnable());
+    ASSERT_TRUE(UxpteIsEmulated());
+
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+
+    /* pinned content is never dropped */
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    EXPECT_EQ(UxptEmuReclaim(0), 0U);
+    ASSERT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+    PurgMemEndRead(pobj);
+
+    /* unpinned content is dropped and rebuilt on next read */
+    EXPECT_GT(UxptEmuReclaim(0), 0U);
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    ASSERT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+    PurgMemEndRead(pobj);
+
+    ASSERT_TRUE(UxptEmuStartReclaimer(1, 0));
+    for (int i = 0; i < 3; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ASSERT_TRUE(PurgMemBeginRead(pobj));
+        ASSERT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+        PurgMemEndRead(pobj);
+    }
+    UxptEmuStopReclaimer();
+
+    /* can not switch back while an obj exists */
+    EXPECT_FALSE(UxptEmuDisable());
+    PurgMemDestroy(pobj);
+    ASSERT_TRUE(UxptEmuDisable());
+    EXPECT_FALSE(UxpteIsEmulated());
+}
+
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT 21
+#endif
+
+/* purge unpinned content like kernel reclaim does in the current uxpt mode */
+static bool PurgeContent(struct PurgMem *pobj)
+{
+    if (UxpteIsEmulated()) {
+        return UxptEmuReclaim(0) > 0;
+    }
+    /* lazyfree content is clean after MADV_FREE, so pageout discards it */
+    size_t size = (PurgMemGetContentSize(pobj) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    return madvise(PurgMemGetContent(pobj), size, MADV_PAGEOUT) == 0;
+}
+
+static void CheckPurgeNotify(void)
+{
+    int fd = PmPurgeNotifierGetEventFd();
+    ASSERT_GE(fd, 0);
+    uint64_t val = 0;
+    (void)read(fd, &val, sizeof(val)); /* drop counts of other cases */
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+    int purges = 0;
+    auto onPurge = [](struct PurgMem *purgObj, void *param) {
+        (*static_cast<int *>(param))++;
+    };
+    ASSERT_TRUE(PurgMemRegisterPurgeNotify(pobj, onPurge, &purges));
+
+    /* never built is not purged, and neither is unpinned content kept by kernel */
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    PurgMemEndRead(pobj);
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+
+    /* notified once per purge */
+    ASSERT_TRUE(PurgeContent(pobj));
+    EXPECT_EQ(PmPurgeNotifierScan(), 1U);
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+    EXPECT_EQ(purges, 1);
+    ASSERT_EQ(read(fd, &val, sizeof(val)), static_cast<ssize_t>(sizeof(val)));
+    EXPECT_EQ(val, 1U);
+
+    /* and again after rebuild, by the scanner */
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    EXPECT_STREQ(alphabet, static_cast<char *>(PurgMemGetContent(pobj)));
+    PurgMemEndRead(pobj);
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+    ASSERT_TRUE(PurgeContent(pobj));
+    ASSERT_TRUE(PmPurgeNotifierStart(1));
+    for (int i = 0; i < 100 && purges < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    PmPurgeNotifierStop();
+    EXPECT_EQ(purges, 2);
+
+    PurgMemUnregisterPurgeNotify(pobj);
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    PurgMemEndRead(pobj);
+    ASSERT_TRUE(PurgeContent(pobj));
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+    PurgMemDestroy(pobj);
+}
+
+HWTEST_F(PurgeableCTest, PurgeNotifyEmuTest, TestSize.Level1)
+{
+    if (UxpteIsKernel()) {
+        GTEST_SKIP() << "kernel supports uxpt";
+    }
+    ASSERT_TRUE(UxptEmuEnable());
+    CheckPurgeNotify();
+    ASSERT_TRUE(UxptEmuDisable());
+}
+
+HWTEST_F(PurgeableCTest, PurgeNotifyLazyFreeTest, TestSize.Level1)
+{
+    if (!UxpteIsLazyFree()) {
+        GTEST_SKIP() << "MADV_FREE fallback not used";
+    }
+    void *probe = mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    ASSERT_NE(probe, MAP_FAILED);
+    bool pageout = madvise(probe, PAGE_SIZE, MADV_PAGEOUT) == 0;
+    munmap(probe, PAGE_SIZE);
+    if (!pageout) {
+        GTEST_SKIP() << "MADV_PAGEOUT not supported";
+    }
+    CheckPurgeNotify();
+}
+
+HWTEST_F(PurgeableCTest, StatsPageTest, TestSize.Level1)
+{
+    ASSERT_TRUE(PmStatsPageEnable());
+    ASSERT_TRUE(PmStatsPageEnable());
+    const struct MemStatsPage *page = MapStatsPageOfSelf(MEM_STATS_SOURCE_PURGEABLE);
+    ASSERT_NE(page, nullptr);
+    EXPECT_EQ(page->pid, getpid());
+    struct MemStatsCounters before;
+    ASSERT_TRUE(MemStatsPageRead(page, &before, 1));
+    EXPECT_EQ(before.purgeableBytes, PmBudgetGetUsage());
+
+    struct AlphabetInitParam initPara = {'A', 'Z'};
+    struct PurgMem *pobj = PurgMemCreate(27, InitAlphabet, &initPara);
+    ASSERT_NE(pobj, nullptr);
+    ASSERT_TRUE(PurgMemBeginRead(pobj));
+    struct MemStatsCounters after;
+    ASSERT_TRUE(MemStatsPageRead(page, &after, 1));
+    EXPECT_EQ(after.purgeablePinnedBytes, before.purgeablePinnedBytes + PAGE_SIZE);
+    PurgMemEndRead(pobj);
+    ASSERT_TRUE(MemStatsPageRead(page, &after, 1));
+    EXPECT_EQ(after.purgeableBytes, before.purgeableBytes + PAGE_SIZE);
+    EXPECT_EQ(after.purgeableBuilds, before.purgeableBuilds + 1);
+    EXPECT_EQ(after.purgeablePinnedBytes, before.purgeablePinnedBytes);
+
+    /* the emulator is switched on by UxptEmuReclaimTest */
+    if (UxpteIsEmulated()) {
+        ASSERT_TRUE(PurgMemRegisterPurgeNotify(pobj, NULL, NULL));
+        EXPECT_GT(UxptEmuReclaim(0), 0U);
+        EXPECT_EQ(PmPurgeNotifierScan(), 1U);
+        ASSERT_TRUE(MemStatsPageRead(page, &after, 1));
+        EXPECT_EQ(after.purgeablePurgedBytes, before.purgeablePurgedBytes + PAGE_SIZE);
+        ASSERT_TRUE(PurgMemBeginRead(pobj));
+        PurgMemEndRead(pobj);
+        ASSERT_TRUE(MemStatsPageRead(page, &after, 1));
+        EXPECT_EQ(after.purgeableRebuilds, before.purgeableRebuilds + 1);
+        EXPECT_EQ(after.purgeablePurgedBytes, before.purgeablePurgedBytes);
+    }
+    PurgMemDestroy(pobj);
+    ASSERT_TRUE(MemStatsPageRead(page, &after, 1));
+    EXPECT_EQ(after.purgeableBytes, before.purgeableBytes);
+    munmap(const_cast<struct MemStatsPage *>(page), MEM_STATS_PAGE_LEN);
+}
+
+HWTEST_F(PurgeableCTest, StatsPageForkTest, TestSize.Level1)
+{
+    ASSERT_TRUE(PmStatsPageEnable());
+    const struct MemStatsPage *parentPage = MapStatsPageOfSelf(MEM_STATS_SOURCE_PURGEABLE);
+    ASSERT_NE(parentPage, nullptr);
+    struct MemStatsCounters before;
+    ASSERT_TRUE(MemStatsPageRead(parentPage, &before, 1));
+
+    /* the child finds only a page of its own, in which bytes are those it inherits */
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        const struct MemStatsPage *page = MapStatsPageOfSelf(MEM_STATS_SOURCE_PURGEABLE);
+        struct MemStatsCounters counters;
+        bool ok = page != nullptr && page->pid == getpid() && MemStatsPageRead(page, &counters, 1) &&
+            counters.purgeableBytes == PmBudgetGetUsage() && counters.purgeableBuilds == 0;
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    /* the page of the parent is kept */
+    EXPECT_EQ(parentPage->pid, getpid());
+    struct MemStatsCounters after;
+    ASSERT_TRUE(MemStatsPageRead(parentPage, &after, 1));
+    EXPECT_EQ(after.purgeableBytes, before.purgeableBytes);
+    EXPECT_EQ(after.purgeableBuilds, before.purgeableBuilds);
+    munmap(const_cast<struct MemStatsPage *>(parentPage), MEM_STATS_PAGE_LEN);
+}
+
 bool InitData(void *data, size_t size, char start, char end)
 {
     char *str = (char *)data;
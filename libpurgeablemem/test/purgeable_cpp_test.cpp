@@ -14,12 +14,17 @@
  */
 
 #include <sys/mman.h>
+#include <atomic>
 #include <cstdio>
 #include <thread>
 #include <memory> /* unique_ptr */
+#include <vector>
 #include <cstring>
 #include "gtest/gtest.h"
+#include "pm_pin_tracker_c.h"
+#include "pm_purge_notifier_c.h"
 #include "pm_util.h"
+#include "ux_page_table_c.h"
 
 #define private public
 #define protected public
@@ -288,6 +293,305 @@ HWTEST_F(PurgeableCppTest, ReadWriteTest, TestSize.Level1)
     EXPECT_EQ(ret, 0);
 }
 
+HWTEST_F(PurgeableCppTest, TryBeginReadTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    std::unique_ptr<PurgeableMemBuilder> builder = std::make_unique<TestDataBuilder>('A', 'Z');
+    PurgeableMem *pobj = new PurgeableMem(27, std::move(builder));
+    /* never built, TryBeginRead does not rebuild */
+    EXPECT_FALSE(pobj->TryBeginRead());
+    ASSERT_TRUE(pobj->BeginRead());
+    pobj->EndRead();
+
+    int ret = 1;
+    if (pobj->TryBeginRead()) {
+        ret = strncmp(alphabet, static_cast<char *>(pobj->GetContent()), 26);
+        pobj->EndRead();
+    }
+    delete pobj;
+    pobj = nullptr;
+    EXPECT_EQ(ret, 0);
+}
+
+HWTEST_F(PurgeableCppTest, PinDepthTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    std::unique_ptr<PurgeableMemBuilder> builder = std::make_unique<TestDataBuilder>('A', 'Z');
+    PurgeableMem pobj(27, std::move(builder));
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(pobj.GetPinStatus(), 1);
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(pobj.GetPinStatus(), 2);
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), 26), 0);
+    pobj.EndRead();
+    EXPECT_EQ(pobj.GetPinStatus(), 1);
+    EXPECT_FALSE(pobj.IsPurged());
+    pobj.EndRead();
+    EXPECT_EQ(pobj.GetPinStatus(), 0);
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&pobj, &alphabet]() {
+            for (int j = 0; j < 100; j++) {
+                if (pobj.BeginRead()) {
+                    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), 26), 0);
+                    pobj.EndRead();
+                }
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(pobj.GetPinStatus(), 0);
+}
+
+HWTEST_F(PurgeableCppTest, ReadOptimisticTest, TestSize.Level1)
+{
+    std::unique_ptr<PurgeableMemBuilder> builder = std::make_unique<TestDataBuilder>('A', 'Z');
+    PurgeableMem pobj(27, std::move(builder));
+    char buf[4] = {0};
+    ASSERT_TRUE(pobj.ReadOptimistic(1, 3, buf));
+    EXPECT_EQ(strncmp(buf, "BCD", 3), 0);
+    ASSERT_TRUE(pobj.ReadOptimistic(23, 3, buf));
+    EXPECT_EQ(strncmp(buf, "XYZ", 3), 0);
+    EXPECT_EQ(pobj.GetPinStatus(), 0);
+    EXPECT_FALSE(pobj.ReadOptimistic(26, 2, buf));
+    EXPECT_FALSE(pobj.ReadOptimistic(0, 1, nullptr));
+
+    ASSERT_TRUE(pobj.BeginWrite());
+    pobj.ModifyContentByBuilder(std::make_unique<TestDataModifier>('A', 'B'));
+    pobj.EndWrite();
+    ASSERT_TRUE(pobj.ReadOptimistic(0, 2, buf));
+    EXPECT_EQ(strncmp(buf, "BB", 2), 0);
+}
+
+class ChunkBuilder : public PurgeableMemBuilder {
+public:
+    bool IsChunkParallel() const override
+    {
+        return true;
+    }
+
+    bool Build(void *data, size_t size) override
+    {
+        builds_++;
+        return BuildChunk(data, 0, size);
+    }
+
+    bool BuildChunk(void *data, size_t offset, size_t len) override
+    {
+        unsigned char *bytes = static_cast<unsigned char *>(data);
+        for (size_t i = offset; i < offset + len; i++) {
+            bytes[i] = static_cast<unsigned char>(i % 251); /* 251: prime, not aligned to any chunk */
+        }
+        chunks_++;
+        return true;
+    }
+
+    std::atomic<int> builds_ {0};
+    std::atomic<int> chunks_ {0};
+};
+
+class IncFirstByteBuilder : public PurgeableMemBuilder {
+public:
+    bool Build(void *data, size_t size) override
+    {
+        static_cast<unsigned char *>(data)[0]++;
+        return true;
+    }
+};
+
+HWTEST_F(PurgeableCppTest, ParallelBuildTest, TestSize.Level1)
+{
+    size_t size = PurgeableMemBuilder::PARALLEL_BUILD_THRESHOLD * 2 + 1;
+    std::unique_ptr<ChunkBuilder> builder = std::make_unique<ChunkBuilder>();
+    ChunkBuilder *chunkBuilder = builder.get();
+    PurgeableMem pobj(size, std::move(builder));
+    ASSERT_TRUE(pobj.BeginWrite());
+    EXPECT_TRUE(pobj.ModifyContentByBuilder(std::make_unique<IncFirstByteBuilder>()));
+    pobj.EndWrite();
+    EXPECT_EQ(chunkBuilder->builds_, 0);
+    EXPECT_EQ(chunkBuilder->chunks_, (size + PurgeableMemBuilder::PARALLEL_BUILD_CHUNK - 1) /
+        PurgeableMemBuilder::PARALLEL_BUILD_CHUNK);
+
+    /* rebuild runs the chain in order, the modifier after all chunks */
+    pobj.buildDataCount_ = 0;
+    ASSERT_TRUE(pobj.BeginRead());
+    const unsigned char *bytes = static_cast<const unsigned char *>(pobj.GetContent());
+    EXPECT_EQ(bytes[0], 1);
+    bool same = true;
+    for (size_t i = 1; i < size; i++) {
+        same = same && (bytes[i] == i % 251); /* 251: same as ChunkBuilder */
+    }
+    EXPECT_TRUE(same);
+    pobj.EndRead();
+
+    /* small content is built by Build() */
+    std::unique_ptr<ChunkBuilder> smallBuilder = std::make_unique<ChunkBuilder>();
+    ChunkBuilder *smallChunkBuilder = smallBuilder.get();
+    PurgeableMem small(PAGE_SIZE, std::move(smallBuilder));
+    ASSERT_TRUE(small.BeginRead());
+    small.EndRead();
+    EXPECT_EQ(smallChunkBuilder->builds_, 1);
+}
+
+HWTEST_F(PurgeableCppTest, PrefaultTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    PurgeableMem pobj(PAGE_SIZE * 4, std::make_unique<TestDataBuilder>('A', 'Z'));
+    pobj.SetPrefault(true);
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), 26), 0);
+    pobj.EndRead();
+
+    /* rebuild prefaults again */
+    pobj.buildDataCount_ = 0;
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), 26), 0);
+    pobj.EndRead();
+}
+
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT 21
+#endif
+
+/* purge unpinned content like kernel reclaim does in the current uxpt mode */
+static bool PurgeContent(PurgeableMem &pobj)
+{
+    if (UxpteIsEmulated()) {
+        return UxptEmuReclaim(0) > 0;
+    }
+    /* lazyfree content is clean after MADV_FREE, so pageout discards it */
+    size_t size = (pobj.GetContentSize() + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    return madvise(pobj.GetContent(), size, MADV_PAGEOUT) == 0;
+}
+
+static void CheckPurgeNotify(void)
+{
+    int purges = 0;
+    std::unique_ptr<PurgeableMem> pobj =
+        std::make_unique<PurgeableMem>(PAGE_SIZE, std::make_unique<TestDataBuilder>('A', 'Z'));
+    ASSERT_TRUE(pobj->RegisterPurgeNotify([&purges] { purges++; }));
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U); /* never built */
+    ASSERT_TRUE(pobj->BeginRead());
+    pobj->EndRead();
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+
+    ASSERT_TRUE(PurgeContent(*pobj));
+    EXPECT_EQ(PmPurgeNotifierScan(), 1U);
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+    EXPECT_EQ(purges, 1);
+
+    /* rebuilt content is watched again */
+    ASSERT_TRUE(pobj->BeginRead());
+    pobj->EndRead();
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+    ASSERT_TRUE(PurgeContent(*pobj));
+    EXPECT_EQ(PmPurgeNotifierScan(), 1U);
+    EXPECT_EQ(purges, 2);
+
+    /* destroyed objs are not scanned */
+    pobj.reset();
+    EXPECT_EQ(PmPurgeNotifierScan(), 0U);
+    EXPECT_EQ(purges, 2);
+}
+
+HWTEST_F(PurgeableCppTest, PurgeNotifyEmuTest, TestSize.Level1)
+{
+    if (UxpteIsKernel()) {
+        GTEST_SKIP() << "kernel supports uxpt";
+    }
+    ASSERT_TRUE(UxptEmuEnable());
+    CheckPurgeNotify();
+    ASSERT_TRUE(UxptEmuDisable());
+}
+
+HWTEST_F(PurgeableCppTest, PurgeNotifyLazyFreeTest, TestSize.Level1)
+{
+    if (!UxpteIsLazyFree()) {
+        GTEST_SKIP() << "MADV_FREE fallback not used";
+    }
+    void *probe = mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    ASSERT_NE(probe, MAP_FAILED);
+    bool pageout = madvise(probe, PAGE_SIZE, MADV_PAGEOUT) == 0;
+    munmap(probe, PAGE_SIZE);
+    if (!pageout) {
+        GTEST_SKIP() << "MADV_PAGEOUT not supported";
+    }
+    CheckPurgeNotify();
+}
+
+HWTEST_F(PurgeableCppTest, BudgetTest, TestSize.Level1)
+{
+    size_t base = PmBudgetGetUsage();
+    std::unique_ptr<PurgeableMem> cold =
+        std::make_unique<PurgeableMem>(PAGE_SIZE, std::make_unique<TestDataBuilder>('A', 'Z'));
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE);
+    PmBudgetSetLimit(base + PAGE_SIZE * 2);
+
+    /* over budget and nothing to trim */
+    PurgeableMem over(PAGE_SIZE * 2, std::make_unique<TestDataBuilder>('A', 'Z'));
+    EXPECT_FALSE(over.BeginRead());
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE);
+
+    auto trimCold = [](size_t bytes, void *param) -> size_t {
+        auto obj = static_cast<std::unique_ptr<PurgeableMem> *>(param);
+        if (!*obj) {
+            return 0;
+        }
+        obj->reset();
+        return PAGE_SIZE;
+    };
+    ASSERT_TRUE(PmBudgetAddTrimmer(trimCold, &cold));
+    PurgeableMem hot(PAGE_SIZE * 2, std::make_unique<TestDataBuilder>('A', 'Z'));
+    EXPECT_EQ(cold, nullptr);
+    ASSERT_TRUE(hot.BeginRead());
+    hot.EndRead();
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE * 2);
+    PmBudgetRemoveTrimmer(trimCold, &cold);
+
+    hot.ResizeData(PAGE_SIZE);
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE);
+    PmBudgetSetLimit(0);
+}
+
+HWTEST_F(PurgeableCppTest, PinTrackerTest, TestSize.Level1)
+{
+    std::unique_ptr<PurgeableMemBuilder> builder = std::make_unique<TestDataBuilder>('A', 'Z');
+    PurgeableMem pobj(27, std::move(builder));
+    std::vector<PmLongPinInfo> longPins;
+    auto onLongPin = [](const PmLongPinInfo *info, void *param) {
+        static_cast<std::vector<PmLongPinInfo> *>(param)->push_back(*info);
+    };
+    ASSERT_TRUE(PmPinTrackerEnable(0, onLongPin, &longPins)); /* no watchdog, every pin is long */
+    EXPECT_FALSE(PmPinTrackerEnable(0, onLongPin, &longPins));
+    PmPinTrackerResetHistogram();
+
+    ASSERT_TRUE(pobj.BeginRead());
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(PmPinTrackerCheck(), 27);
+    EXPECT_EQ(PmPinTrackerCheck(), 27);
+    ASSERT_EQ(longPins.size(), 1); /* nested pin is one pin, reported once */
+    EXPECT_EQ(longPins[0].obj, &pobj);
+    EXPECT_EQ(longPins[0].size, 27);
+    EXPECT_NE(longPins[0].caller, nullptr);
+    pobj.EndRead();
+    EXPECT_EQ(PmPinTrackerCheck(), 27);
+    pobj.EndRead();
+    EXPECT_EQ(PmPinTrackerCheck(), 0);
+
+    uint64_t hist[PM_PIN_HIST_BUCKETS] = {0};
+    EXPECT_EQ(PmPinTrackerGetHistogram(hist, PM_PIN_HIST_BUCKETS + 1), PM_PIN_HIST_BUCKETS);
+    uint64_t pins = 0;
+    for (size_t i = 0; i < PM_PIN_HIST_BUCKETS; i++) {
+        pins += hist[i];
+    }
+    EXPECT_EQ(pins, 1);
+    PmPinTrackerDisable();
+    EXPECT_FALSE(PmPinTrackerIsEnabled());
+}
+
 HWTEST_F(PurgeableCppTest, MutiPageReadTest, TestSize.Level1)
 {
     char alphabet[4098];
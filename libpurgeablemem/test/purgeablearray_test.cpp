@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+
+#include "gtest/gtest.h"
+#include "pm_util.h"
+
+#define private public
+#define protected public
+#include "purgeable_array.h"
+#undef private
+#undef protected
+
+namespace OHOS {
+namespace PurgeableMem {
+using namespace testing;
+using namespace testing::ext;
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+
+class PurgeableArrayTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void PurgeableArrayTest::SetUpTestCase()
+{
+}
+
+void PurgeableArrayTest::TearDownTestCase()
+{
+}
+
+void PurgeableArrayTest::SetUp()
+{
+}
+
+void PurgeableArrayTest::TearDown()
+{
+}
+
+HWTEST_F(PurgeableArrayTest, ElementGeneratorTest, TestSize.Level1)
+{
+    int builds = 0;
+    auto arr = MakePurgeableArray<Point>(PAGE_SIZE, [&builds](size_t idx) {
+        if (idx == 0) {
+            builds++;
+        }
+        return Point { static_cast<int32_t>(idx), -static_cast<int32_t>(idx) };
+    });
+    EXPECT_EQ(arr->Size(), PAGE_SIZE);
+    {
+        auto view = arr->Read();
+        ASSERT_TRUE(view);
+        auto points = view.Span();
+        ASSERT_EQ(points.size(), PAGE_SIZE);
+        EXPECT_EQ(points[PAGE_SIZE - 1].x, static_cast<int32_t>(PAGE_SIZE - 1));
+        EXPECT_EQ(points[PAGE_SIZE - 1].y, -static_cast<int32_t>(PAGE_SIZE - 1));
+        EXPECT_EQ(arr->mem_.GetPinStatus(), 1);
+    }
+    EXPECT_EQ(arr->mem_.GetPinStatus(), 0);
+    {
+        auto view = arr->TryRead();
+        ASSERT_TRUE(view);
+    }
+    EXPECT_EQ(builds, 1);
+}
+
+HWTEST_F(PurgeableArrayTest, BulkGeneratorTest, TestSize.Level1)
+{
+    PurgeableArray<uint64_t, bool (*)(uint64_t *, size_t)> arr(100, [](uint64_t *data, size_t count) {
+        std::iota(data, data + count, 1);
+        return true;
+    });
+    auto view = arr.Read();
+    ASSERT_TRUE(view);
+    uint64_t sum = 0;
+    for (uint64_t val : view.Span()) {
+        sum += val;
+    }
+    EXPECT_EQ(sum, 5050);
+}
+
+HWTEST_F(PurgeableArrayTest, WriteTest, TestSize.Level1)
+{
+    auto arr = MakePurgeableArray<int>(10, [](size_t idx) { return static_cast<int>(idx); });
+    {
+        auto view = arr->Write();
+        ASSERT_TRUE(view);
+        EXPECT_TRUE(view.Modify([](int *data, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                data[i] *= 2;
+            }
+            return true;
+        }));
+        EXPECT_EQ(view.Span()[9], 18);
+    }
+    /* modify is replayed after rebuild */
+    arr->mem_.buildDataCount_ = 0;
+    auto view = arr->Read();
+    ASSERT_TRUE(view);
+    EXPECT_EQ(view.Span()[9], 18);
+}
+
+HWTEST_F(PurgeableArrayTest, InvalidTest, TestSize.Level1)
+{
+    auto gen = [](size_t idx) { return static_cast<char>(idx); };
+    auto empty = MakePurgeableArray<char>(0, gen);
+    EXPECT_FALSE(empty->Read());
+    EXPECT_FALSE(empty->Write());
+    EXPECT_TRUE(empty->Read().Span().empty());
+
+    auto huge = MakePurgeableArray<uint64_t>(SIZE_MAX / 4, [](size_t idx) { return idx; });
+    EXPECT_EQ(huge->Size(), 0);
+    EXPECT_FALSE(huge->Read());
+
+    auto failed = MakePurgeableArray<int>(10, [](int *data, size_t count) { return false; });
+    EXPECT_FALSE(failed->Read());
+    EXPECT_EQ(failed->mem_.GetPinStatus(), 0);
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "pm_budget_c.h"
+#include "pm_util.h"
+
+#define private public
+#define protected public
+#include "purgeable_dmabuf.h"
+#undef private
+#undef protected
+
+namespace OHOS {
+namespace PurgeableMem {
+using namespace testing;
+using namespace testing::ext;
+
+static constexpr size_t ALPHABET_LEN = 26;
+
+class CountDataBuilder : public PurgeableMemBuilder {
+public:
+    explicit CountDataBuilder(int *count) : count_(count) {}
+
+    bool Build(void *data, size_t size)
+    {
+        char *str = static_cast<char *>(data);
+        for (size_t i = 0; i < ALPHABET_LEN && i < size; i++) {
+            str[i] = static_cast<char>('A' + i);
+        }
+        (*count_)++;
+        return true;
+    }
+
+private:
+    int *count_;
+};
+
+class PurgeableDmaBufTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+    std::string heapName;
+};
+
+void PurgeableDmaBufTest::SetUpTestCase()
+{
+}
+
+void PurgeableDmaBufTest::TearDownTestCase()
+{
+}
+
+void PurgeableDmaBufTest::SetUp()
+{
+    std::string rootDir = "/dev/dma_heap/";
+    DIR *dir = opendir(rootDir.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent *ptr;
+    while ((ptr = readdir(dir)) != nullptr) {
+        std::string fileName = ptr->d_name;
+        if (fileName.find("system") != std::string::npos) {
+            heapName = fileName;
+            break;
+        }
+    }
+    closedir(dir);
+}
+
+void PurgeableDmaBufTest::TearDown()
+{
+    PurgeableDmaBuf::SetResidentLimit(0);
+}
+
+HWTEST_F(PurgeableDmaBufTest, ReadPurgeTest, TestSize.Level1)
+{
+    if (heapName.empty()) {
+        GTEST_SKIP() << "no system dma heap";
+    }
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    int count = 0;
+    PurgeableDmaBuf pobj(heapName, PAGE_SIZE, std::make_unique<CountDataBuilder>(&count));
+    void *content = pobj.GetContent();
+    ASSERT_NE(content, nullptr);
+    EXPECT_EQ(pobj.GetDmaBufFd(), -1); /* allocated on first access */
+
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    EXPECT_GE(pobj.GetDmaBufFd(), 0);
+    EXPECT_FALSE(pobj.Purge());
+    pobj.EndRead();
+    EXPECT_EQ(count, 1);
+
+    /* purged content is rebuilt at the same address */
+    EXPECT_TRUE(pobj.Purge());
+    EXPECT_EQ(pobj.GetDmaBufFd(), -1);
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(pobj.GetContent(), content);
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    pobj.EndRead();
+    EXPECT_EQ(count, 2);
+}
+
+HWTEST_F(PurgeableDmaBufTest, TrimTest, TestSize.Level1)
+{
+    if (heapName.empty()) {
+        GTEST_SKIP() << "no system dma heap";
+    }
+    int count1 = 0;
+    int count2 = 0;
+    PurgeableDmaBuf pobj1(heapName, PAGE_SIZE, std::make_unique<CountDataBuilder>(&count1));
+    PurgeableDmaBuf pobj2(heapName, PAGE_SIZE, std::make_unique<CountDataBuilder>(&count2));
+    size_t base = PurgeableDmaBuf::GetResidentBytes();
+    ASSERT_TRUE(pobj1.BeginRead());
+    pobj1.EndRead();
+    EXPECT_EQ(PurgeableDmaBuf::GetResidentBytes(), base + PAGE_SIZE);
+
+    /* allocating over the limit frees the least recently unpinned buffer */
+    PurgeableDmaBuf::SetResidentLimit(base + PAGE_SIZE);
+    ASSERT_TRUE(pobj2.BeginRead());
+    EXPECT_TRUE(pobj1.IsPurged());
+    EXPECT_EQ(PurgeableDmaBuf::GetResidentBytes(), base + PAGE_SIZE);
+
+    /* pinned buffers are never trimmed */
+    EXPECT_EQ(PurgeableDmaBuf::Trim(PAGE_SIZE), 0U);
+    pobj2.EndRead();
+    EXPECT_EQ(PurgeableDmaBuf::Trim(PAGE_SIZE), PAGE_SIZE);
+    EXPECT_EQ(PurgeableDmaBuf::GetResidentBytes(), base);
+}
+
+static size_t DmaBufTrimmer(size_t bytes, void *param)
+{
+    (void)param;
+    return PurgeableDmaBuf::Trim(bytes);
+}
+
+HWTEST_F(PurgeableDmaBufTest, ResizeTrimTest, TestSize.Level1)
+{
+    if (heapName.empty()) {
+        GTEST_SKIP() << "no system dma heap";
+    }
+    int count = 0;
+    PurgeableDmaBuf pobj(heapName, PAGE_SIZE, std::make_unique<CountDataBuilder>(&count));
+    ASSERT_TRUE(pobj.BeginRead());
+    pobj.EndRead();
+
+    /* the budget trims dmabufs, including the one being resized */
+    PmBudgetSetLimit(PmBudgetGetUsage());
+    ASSERT_TRUE(PmBudgetAddTrimmer(DmaBufTrimmer, nullptr));
+    pobj.ResizeData(PAGE_SIZE * 2);
+    PmBudgetRemoveTrimmer(DmaBufTrimmer, nullptr);
+    PmBudgetSetLimit(0);
+    EXPECT_TRUE(pobj.IsPurged());
+    EXPECT_EQ(pobj.dataSizeInput_, PAGE_SIZE);
+
+    pobj.ResizeData(PAGE_SIZE * 2);
+    EXPECT_EQ(pobj.dataSizeInput_, PAGE_SIZE * 2);
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(static_cast<char *>(pobj.GetContent())[0], 'A');
+    pobj.EndRead();
+}
+
+HWTEST_F(PurgeableDmaBufTest, InvalidInputTest, TestSize.Level1)
+{
+    int count = 0;
+    PurgeableDmaBuf pobj1("no_such_heap", PAGE_SIZE, std::make_unique<CountDataBuilder>(&count));
+    EXPECT_FALSE(pobj1.BeginRead());
+    EXPECT_FALSE(pobj1.Purge());
+    EXPECT_EQ(pobj1.GetDmaBufFd(), -1);
+    PurgeableDmaBuf pobj2(heapName, 0, std::make_unique<CountDataBuilder>(&count));
+    EXPECT_FALSE(pobj2.BeginRead());
+    PurgeableDmaBuf pobj3(heapName, PAGE_SIZE, nullptr);
+    EXPECT_FALSE(pobj3.BeginRead());
+    EXPECT_EQ(count, 0);
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits> /* PATH_MAX */
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h> /* fallocate */
+#include <linux/falloc.h> /* FALLOC_FL_PUNCH_HOLE */
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "mem_stats_page.h"
+#include "pm_stats_page_c.h"
+#include "pm_util.h"
+#include "securec.h"
+
+#define private public
+#define protected public
+#include "purgeable_file_mem.h"
+#undef private
+#undef protected
+
+namespace OHOS {
+namespace PurgeableMem {
+using namespace testing;
+using namespace testing::ext;
+
+static constexpr size_t ALPHABET_LEN = 26;
+static constexpr off_t ALPHABET_OFFSET = PAGE_SIZE + 100; /* not page aligned */
+
+class FillBuilder : public PurgeableMemBuilder {
+public:
+    bool Build(void *data, size_t size)
+    {
+        return memset_s(data, size, 'X', size) == EOK;
+    }
+};
+
+/* the kernel drops the first page again right after each refault */
+class DroppingFileMem : public PurgeableFileMem {
+public:
+    DroppingFileMem(int fd, off_t offset, size_t length) : PurgeableFileMem(fd, offset, length), fd_(fd) {}
+
+    bool BuildContent() override
+    {
+        bool succ = PurgeableFileMem::BuildContent();
+        /* the first page is a hole of zeros, punching it keeps the content */
+        EXPECT_EQ(fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, PAGE_SIZE), 0);
+        return succ;
+    }
+
+private:
+    int fd_;
+};
+
+/* read counters of the stats page of libpurgeablemem in this process */
+static bool ReadStatsPageOfSelf(struct MemStatsCounters &counters)
+{
+    const std::string link = std::string("/memfd:") + MEM_STATS_PAGE_NAME;
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == nullptr) {
+        return false;
+    }
+    bool found = false;
+    struct dirent *ent;
+    while (!found && (ent = readdir(dir)) != nullptr) {
+        std::string path = std::string("/proc/self/fd/") + ent->d_name;
+        char buf[PATH_MAX] = {0};
+        if (readlink(path.c_str(), buf, sizeof(buf) - 1) <= 0 || strncmp(buf, link.c_str(), link.size()) != 0) {
+            continue;
+        }
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+        void *addr = mmap(nullptr, MEM_STATS_PAGE_LEN, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            continue;
+        }
+        const struct MemStatsPage *page = static_cast<const struct MemStatsPage *>(addr);
+        found = page->source == MEM_STATS_SOURCE_PURGEABLE && MemStatsPageRead(page, &counters, 1);
+        munmap(addr, MEM_STATS_PAGE_LEN);
+    }
+    closedir(dir);
+    return found;
+}
+
+class PurgeableFileMemTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+
+    int fd_ = -1;
+};
+
+void PurgeableFileMemTest::SetUpTestCase()
+{
+}
+
+void PurgeableFileMemTest::TearDownTestCase()
+{
+}
+
+/* a file of 3 pages with the alphabet at ALPHABET_OFFSET */
+void PurgeableFileMemTest::SetUp()
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    fd_ = memfd_create("PurgeableFileMemTest", MFD_CLOEXEC);
+    ASSERT_GE(fd_, 0);
+    ASSERT_EQ(ftruncate(fd_, PAGE_SIZE * 3), 0);
+    ASSERT_EQ(pwrite(fd_, alphabet, ALPHABET_LEN, ALPHABET_OFFSET), static_cast<ssize_t>(ALPHABET_LEN));
+}
+
+void PurgeableFileMemTest::TearDown()
+{
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+HWTEST_F(PurgeableFileMemTest, ReadTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    PurgeableFileMem pobj(fd_, ALPHABET_OFFSET, ALPHABET_LEN);
+    close(fd_); /* the mapping does not need the fd */
+    fd_ = -1;
+    EXPECT_EQ(pobj.GetContentSize(), ALPHABET_LEN);
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    EXPECT_EQ(pobj.GetPinStatus(), 1);
+    pobj.EndRead();
+    EXPECT_EQ(pobj.GetPinStatus(), 0);
+    EXPECT_FALSE(pobj.IsPurged());
+    EXPECT_EQ(pobj.buildDataCount_, 1U);
+
+    /* rebuild only refaults, content is the file */
+    ASSERT_TRUE(pobj.BuildContent());
+    EXPECT_EQ(pobj.buildDataCount_, 2U);
+    ASSERT_TRUE(pobj.TryBeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    pobj.EndRead();
+}
+
+HWTEST_F(PurgeableFileMemTest, WriteTest, TestSize.Level1)
+{
+    PurgeableFileMem pobj(fd_, ALPHABET_OFFSET, ALPHABET_LEN);
+    EXPECT_FALSE(pobj.BeginWrite());
+    EXPECT_EQ(pobj.GetPinStatus(), 0);
+    /* the mapping is read-only */
+    EXPECT_FALSE(pobj.ModifyContentByBuilder(std::make_unique<FillBuilder>()));
+    pobj.ResizeData(PAGE_SIZE);
+    EXPECT_EQ(pobj.GetContentSize(), ALPHABET_LEN);
+}
+
+HWTEST_F(PurgeableFileMemTest, RefaultDroppedTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    DroppingFileMem pobj(fd_, 0, ALPHABET_OFFSET + ALPHABET_LEN);
+    ASSERT_EQ(fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, PAGE_SIZE), 0);
+    ASSERT_TRUE(pobj.IsPurged());
+
+    /* a finished refault is final even if pages are dropped again */
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(pobj.buildDataCount_, 2U);
+    EXPECT_FALSE(pobj.IsPurged());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()) + ALPHABET_OFFSET, ALPHABET_LEN), 0);
+    pobj.EndRead();
+
+    /* and checked again after the last unpin */
+    EXPECT_TRUE(pobj.IsPurged());
+}
+
+HWTEST_F(PurgeableFileMemTest, StatsPageTest, TestSize.Level1)
+{
+    ASSERT_TRUE(PmStatsPageEnable());
+    struct MemStatsCounters before;
+    ASSERT_TRUE(ReadStatsPageOfSelf(before));
+    PurgeableFileMem pobj(fd_, 0, ALPHABET_OFFSET + ALPHABET_LEN);
+    ASSERT_EQ(fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, PAGE_SIZE), 0);
+    ASSERT_TRUE(pobj.IsPurged());
+
+    /* a refault is a rebuild like that of the other backends */
+    ASSERT_TRUE(pobj.BeginRead());
+    pobj.EndRead();
+    struct MemStatsCounters after;
+    ASSERT_TRUE(ReadStatsPageOfSelf(after));
+    EXPECT_EQ(after.purgeableRebuilds, before.purgeableRebuilds + 1);
+    EXPECT_EQ(after.purgeableBuilds, before.purgeableBuilds);
+}
+
+HWTEST_F(PurgeableFileMemTest, InvalidInputTest, TestSize.Level1)
+{
+    PurgeableFileMem pobj1(-1, 0, ALPHABET_LEN);
+    EXPECT_FALSE(pobj1.BeginRead());
+    PurgeableFileMem pobj2(fd_, 0, 0);
+    EXPECT_FALSE(pobj2.BeginRead());
+    PurgeableFileMem pobj3(fd_, -1, ALPHABET_LEN);
+    EXPECT_FALSE(pobj3.BeginRead());
+    PurgeableFileMem pobj4(fd_, PAGE_SIZE * 3 - 1, 2); /* beyond end of file */
+    EXPECT_FALSE(pobj4.BeginRead());
+    PurgeableFileMem pobj5(fd_, PAGE_SIZE * 3 - 1, 1);
+    EXPECT_TRUE(pobj5.BeginRead());
+    pobj5.EndRead();
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pm_util.h"
+
+#define private public
+#define protected public
+#include "purgeable_lru_cache.h"
+#undef private
+#undef protected
+
+namespace OHOS {
+namespace PurgeableMem {
+using namespace testing;
+using namespace testing::ext;
+
+struct Value {
+    uint64_t key;
+    uint64_t square;
+};
+
+using Cache = PurgeableLruCache<uint64_t, Value>;
+
+static bool LoadValue(const uint64_t &key, Value &value)
+{
+    value.key = key;
+    value.square = key * key;
+    return true;
+}
+
+class PurgeableLruCacheTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void PurgeableLruCacheTest::SetUpTestCase()
+{
+}
+
+void PurgeableLruCacheTest::TearDownTestCase()
+{
+}
+
+void PurgeableLruCacheTest::SetUp()
+{
+}
+
+void PurgeableLruCacheTest::TearDown()
+{
+}
+
+HWTEST_F(PurgeableLruCacheTest, HitMissTest, TestSize.Level1)
+{
+    Cache cache(16, LoadValue, 1);
+    {
+        auto handle = cache.Get(3);
+        ASSERT_TRUE(handle);
+        EXPECT_EQ(handle->square, 9);
+    }
+    {
+        auto handle = cache.Get(3);
+        ASSERT_TRUE(handle);
+        EXPECT_EQ((*handle).key, 3);
+    }
+    PurgeableLruCacheStats stats = cache.GetStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(cache.Size(), 1);
+    EXPECT_TRUE(cache.Erase(3));
+    EXPECT_FALSE(cache.Erase(3));
+    EXPECT_EQ(cache.Size(), 0);
+}
+
+HWTEST_F(PurgeableLruCacheTest, EvictTest, TestSize.Level1)
+{
+    Cache cache(4, LoadValue, 1);
+    auto pinned = cache.Get(0);
+    ASSERT_TRUE(pinned);
+    for (uint64_t key = 1; key < 4; key++) {
+        ASSERT_TRUE(cache.Get(key));
+    }
+    ASSERT_TRUE(cache.Get(1)); /* 2 is the least recently used now */
+    ASSERT_TRUE(cache.Get(4));
+    EXPECT_EQ(cache.Size(), 4);
+    EXPECT_EQ(cache.GetStats().evictions, 1);
+    EXPECT_FALSE(cache.Erase(0)); /* pinned */
+    EXPECT_TRUE(cache.Erase(3));
+    EXPECT_FALSE(cache.Erase(2));
+    EXPECT_EQ(pinned->square, 0);
+
+    /* all pinned, nothing to evict */
+    Cache full(1, LoadValue, 1);
+    auto handle = full.Get(1);
+    ASSERT_TRUE(handle);
+    EXPECT_FALSE(full.Get(2));
+    handle = full.Get(1);
+    ASSERT_TRUE(handle);
+}
+
+HWTEST_F(PurgeableLruCacheTest, PurgeRebuildTest, TestSize.Level1)
+{
+    Cache cache(8, LoadValue, 1);
+    ASSERT_TRUE(cache.Get(5));
+    ASSERT_TRUE(cache.Get(6));
+
+    /* as if the slab is purged */
+    auto &slab = cache.shards_[0]->slabs[0];
+    slab->mem->buildDataCount_ = 0;
+    auto handle = cache.Get(6);
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(handle->square, 36);
+    EXPECT_EQ(cache.GetStats().purgeRebuilds, 2);
+    EXPECT_EQ(cache.GetStats().hits, 1);
+}
+
+HWTEST_F(PurgeableLruCacheTest, LoadFailTest, TestSize.Level1)
+{
+    Cache cache(8, [](const uint64_t &key, Value &value) { return key % 2 == 0; }, 1);
+    EXPECT_FALSE(cache.Get(1));
+    EXPECT_EQ(cache.Size(), 0);
+    ASSERT_TRUE(cache.Get(2));
+    EXPECT_EQ(cache.Size(), 1);
+}
+
+HWTEST_F(PurgeableLruCacheTest, ConcurrentTest, TestSize.Level1)
+{
+    constexpr int threadCount = 4;
+    constexpr uint64_t keyCount = 64;
+    Cache cache(keyCount / 2, LoadValue);
+    std::atomic<int> wrong {0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&cache, &wrong, i]() {
+            for (uint64_t j = 0; j < 1000; j++) {
+                uint64_t key = (j * (i + 1)) % keyCount;
+                auto handle = cache.Get(key);
+                if (!handle || handle->square != key * key) {
+                    wrong++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(wrong, 0);
+    PurgeableLruCacheStats stats = cache.GetStats();
+    EXPECT_EQ(stats.hits + stats.misses, threadCount * 1000);
+    EXPECT_LE(cache.Size(), keyCount / 2);
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "pm_budget_c.h"
+#include "pm_util.h"
+
+#define private public
+#define protected public
+#include "purgeable_memfd.h"
+#undef private
+#undef protected
+
+namespace OHOS {
+namespace PurgeableMem {
+using namespace testing;
+using namespace testing::ext;
+
+static constexpr size_t ALPHABET_LEN = 26;
+
+class CountDataBuilder : public PurgeableMemBuilder {
+public:
+    CountDataBuilder(char start, char end, int *count) : start_(start), end_(end), count_(count) {}
+
+    bool Build(void *data, size_t size)
+    {
+        if (size <= 0) {
+            return true;
+        }
+        char *str = static_cast<char *>(data);
+        size_t len = 0;
+        for (char ch = start_; ch <= end_ && len < size; ch++) {
+            str[len++] = ch;
+        }
+        str[size - 1] = 0;
+        if (count_) {
+            (*count_)++;
+        }
+        return true;
+    }
+
+private:
+    char start_;
+    char end_;
+    int *count_;
+};
+
+class KeyedDataBuilder : public CountDataBuilder {
+public:
+    KeyedDataBuilder(char start, char end, int *count)
+        : CountDataBuilder(start, end, count), key_(std::string(1, start) + "-" + std::string(1, end)) {}
+
+    bool GetContentKey(std::string &key) const override
+    {
+        key = key_;
+        return true;
+    }
+
+private:
+    std::string key_;
+};
+
+static ino_t GetInode(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 ? st.st_ino : 0;
+}
+
+class TestDataModifier : public PurgeableMemBuilder {
+public:
+    TestDataModifier(char from, char to) : from_(from), to_(to) {}
+
+    bool Build(void *data, size_t size)
+    {
+        char *str = static_cast<char *>(data);
+        for (size_t i = 0; i < size && str[i]; i++) {
+            if (str[i] == from_) {
+                str[i] = to_;
+            }
+        }
+        return true;
+    }
+
+private:
+    char from_;
+    char to_;
+};
+
+class PurgeableMemFdTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void PurgeableMemFdTest::SetUpTestCase()
+{
+}
+
+void PurgeableMemFdTest::TearDownTestCase()
+{
+}
+
+void PurgeableMemFdTest::SetUp()
+{
+}
+
+void PurgeableMemFdTest::TearDown()
+{
+}
+
+HWTEST_F(PurgeableMemFdTest, ReadTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    int count = 0;
+    std::unique_ptr<PurgeableMemBuilder> builder = std::make_unique<CountDataBuilder>('A', 'Z', &count);
+    PurgeableMemFd pobj(27, std::move(builder));
+    EXPECT_NE(pobj.GetMemFd(), -1);
+    EXPECT_EQ(pobj.GetContentSize(), 27);
+
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    EXPECT_EQ(pobj.GetPinStatus(), 1);
+    pobj.EndRead();
+    EXPECT_EQ(pobj.GetPinStatus(), 0);
+
+    ASSERT_TRUE(pobj.BeginRead());
+    pobj.EndRead();
+    EXPECT_EQ(count, 1);
+}
+
+HWTEST_F(PurgeableMemFdTest, WriteTest, TestSize.Level1)
+{
+    const char alphabet[] = "CCCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    std::unique_ptr<PurgeableMemBuilder> builder = std::make_unique<CountDataBuilder>('A', 'Z', nullptr);
+    PurgeableMemFd pobj(27, std::move(builder));
+
+    ASSERT_TRUE(pobj.BeginWrite());
+    pobj.ModifyContentByBuilder(std::make_unique<TestDataModifier>('A', 'B'));
+    pobj.ModifyContentByBuilder(std::make_unique<TestDataModifier>('B', 'C'));
+    pobj.EndWrite();
+
+    /* modifiers are replayed after purge */
+    EXPECT_TRUE(pobj.Purge());
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    pobj.EndRead();
+}
+
+HWTEST_F(PurgeableMemFdTest, PurgeTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    int count = 0;
+    std::unique_ptr<PurgeableMemBuilder> builder = std::make_unique<CountDataBuilder>('A', 'Z', &count);
+    PurgeableMemFd pobj(PAGE_SIZE * 4, std::move(builder));
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_FALSE(pobj.Purge()); /* pinned */
+    pobj.EndRead();
+    EXPECT_FALSE(pobj.IsPurged());
+
+    EXPECT_TRUE(pobj.Purge());
+    EXPECT_TRUE(pobj.IsPurged());
+    EXPECT_EQ(static_cast<char *>(pobj.GetContent())[0], 0);
+
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    pobj.EndRead();
+    EXPECT_EQ(count, 2);
+}
+
+HWTEST_F(PurgeableMemFdTest, ShareTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    int count1 = 0;
+    int count2 = 0;
+    PurgeableMemFd pobj1(27, std::make_unique<CountDataBuilder>('A', 'Z', &count1));
+    ASSERT_TRUE(pobj1.BeginRead());
+    pobj1.EndRead();
+
+    /* as if the fd is received from another process */
+    PurgeableMemFd pobj2(std::make_unique<CountDataBuilder>('A', 'Z', &count2));
+    int fd = dup(pobj1.GetMemFd());
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(pobj2.ChangeMemFdData(27, fd));
+    ASSERT_TRUE(pobj2.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj2.GetContent()), ALPHABET_LEN), 0);
+    EXPECT_EQ(pobj1.GetPinStatus(), 1);
+    EXPECT_FALSE(pobj1.Purge());
+    pobj2.EndRead();
+    EXPECT_EQ(count2, 0);
+
+    /* purge by one side is seen by the other */
+    EXPECT_TRUE(pobj1.Purge());
+    ASSERT_TRUE(pobj2.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj2.GetContent()), ALPHABET_LEN), 0);
+    pobj2.EndRead();
+    EXPECT_EQ(count2, 1);
+    EXPECT_FALSE(pobj1.IsPurged());
+}
+
+/* counts builds of all processes in @builds, which is in a shared mapping */
+class SlowSharedCountBuilder : public PurgeableMemBuilder {
+public:
+    explicit SlowSharedCountBuilder(std::atomic<int> *builds) : builds_(builds) {}
+
+    bool Build(void *data, size_t size)
+    {
+        builds_->fetch_add(1);
+        const useconds_t buildUs = 50000;
+        usleep(buildUs);
+        char *str = static_cast<char *>(data);
+        for (size_t i = 0; i + 1 < size; i++) {
+            str[i] = static_cast<char>('A' + i % ALPHABET_LEN);
+        }
+        return true;
+    }
+
+private:
+    std::atomic<int> *builds_;
+};
+
+HWTEST_F(PurgeableMemFdTest, ShareRebuildTest, TestSize.Level1)
+{
+    void *shm = mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(shm, MAP_FAILED);
+    std::atomic<int> *builds = new (shm) std::atomic<int>(0);
+    PurgeableMemFd pobj(27, std::make_unique<SlowSharedCountBuilder>(builds));
+    ASSERT_GE(pobj.GetMemFd(), 0);
+    ASSERT_TRUE(pobj.BeginRead());
+    pobj.EndRead();
+    ASSERT_TRUE(pobj.Purge());
+    builds->store(0);
+
+    /* the child maps the same memfd by fork, both rebuild the purged content at once */
+    int go[2];
+    ASSERT_EQ(pipe(go), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        close(go[1]);
+        char c;
+        (void)read(go[0], &c, 1);
+        bool ok = pobj.BeginRead() && static_cast<char *>(pobj.GetContent())[0] == 'A';
+        if (ok) {
+            usleep(50000); /* keep reading while the parent may rebuild */
+            ok = static_cast<char *>(pobj.GetContent())[0] == 'A';
+            pobj.EndRead();
+        }
+        _exit(ok ? 0 : 1);
+    }
+    close(go[0]);
+    close(go[1]);
+    bool ok = pobj.BeginRead();
+    EXPECT_TRUE(ok);
+    if (ok) {
+        EXPECT_EQ(static_cast<char *>(pobj.GetContent())[0], 'A');
+        pobj.EndRead();
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_EQ(builds->load(), 1);
+    munmap(shm, PAGE_SIZE);
+}
+
+HWTEST_F(PurgeableMemFdTest, DedupTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    const char modified[] = "BBCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    int count = 0;
+    size_t base = PmBudgetGetUsage();
+    std::unique_ptr<PurgeableMemFd> pobj1 =
+        std::make_unique<PurgeableMemFd>(27, std::make_unique<KeyedDataBuilder>('A', 'Z', &count));
+    std::unique_ptr<PurgeableMemFd> pobj2 =
+        std::make_unique<PurgeableMemFd>(27, std::make_unique<KeyedDataBuilder>('A', 'Z', &count));
+    PurgeableMemFd other(PAGE_SIZE * 2, std::make_unique<KeyedDataBuilder>('A', 'Z', &count));
+    EXPECT_EQ(GetInode(pobj1->GetMemFd()), GetInode(pobj2->GetMemFd()));
+    EXPECT_NE(GetInode(pobj1->GetMemFd()), GetInode(other.GetMemFd()));
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE * 3);
+
+    /* built once for both */
+    ASSERT_TRUE(pobj1->BeginRead());
+    ASSERT_TRUE(pobj2->BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj2->GetContent()), ALPHABET_LEN), 0);
+    EXPECT_EQ(pobj1->GetPinStatus(), 2);
+    pobj2->EndRead();
+    pobj1->EndRead();
+    EXPECT_EQ(count, 1);
+    EXPECT_TRUE(pobj1->Purge());
+    ASSERT_TRUE(pobj2->BeginRead());
+    pobj2->EndRead();
+    ASSERT_TRUE(pobj1->BeginRead());
+    pobj1->EndRead();
+    EXPECT_EQ(count, 2);
+
+    /* write copies the content to a memfd of its own */
+    ASSERT_TRUE(pobj1->BeginWrite());
+    EXPECT_NE(GetInode(pobj1->GetMemFd()), GetInode(pobj2->GetMemFd()));
+    EXPECT_EQ(pobj1->ModifyContentByBuilder(std::make_unique<TestDataModifier>('A', 'B')), true);
+    pobj1->EndWrite();
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE * 4);
+    ASSERT_TRUE(pobj1->BeginRead());
+    EXPECT_EQ(strncmp(modified, static_cast<char *>(pobj1->GetContent()), ALPHABET_LEN), 0);
+    pobj1->EndRead();
+    ASSERT_TRUE(pobj2->BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj2->GetContent()), ALPHABET_LEN), 0);
+    pobj2->EndRead();
+
+    pobj2.reset();
+    pobj1.reset();
+    EXPECT_EQ(PmBudgetGetUsage(), base + PAGE_SIZE * 2);
+}
+
+/* release the shared obj in @param, as an owner of cold objs does */
+static size_t DestroySharedTrimmer(size_t bytes, void *param)
+{
+    (void)bytes;
+    auto *pobj = static_cast<std::unique_ptr<PurgeableMemFd> *>(param);
+    if (!*pobj) {
+        return 0;
+    }
+    pobj->reset();
+    return PAGE_SIZE;
+}
+
+HWTEST_F(PurgeableMemFdTest, TrimSharedTest, TestSize.Level1)
+{
+    int count = 0;
+    std::unique_ptr<PurgeableMemFd> cold =
+        std::make_unique<PurgeableMemFd>(27, std::make_unique<KeyedDataBuilder>('A', 'Z', &count));
+    ASSERT_GE(cold->GetMemFd(), 0);
+    ASSERT_TRUE(cold->shared_ != nullptr);
+    PmBudgetSetLimit(PmBudgetGetUsage());
+    ASSERT_TRUE(PmBudgetAddTrimmer(DestroySharedTrimmer, &cold));
+
+    /* the trimmer destroys a shared obj while another one is being created */
+    PurgeableMemFd pobj(27, std::make_unique<KeyedDataBuilder>('a', 'z', &count));
+    PmBudgetRemoveTrimmer(DestroySharedTrimmer, &cold);
+    PmBudgetSetLimit(0);
+    EXPECT_TRUE(cold == nullptr);
+    EXPECT_GE(pobj.GetMemFd(), 0);
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(static_cast<char *>(pobj.GetContent())[0], 'a');
+    pobj.EndRead();
+}
+
+HWTEST_F(PurgeableMemFdTest, WritePinnedSharedTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    PurgeableMemFd pobj1(27, std::make_unique<KeyedDataBuilder>('A', 'Z', nullptr));
+    PurgeableMemFd pobj2(27, std::make_unique<KeyedDataBuilder>('A', 'Z', nullptr));
+    ASSERT_EQ(GetInode(pobj1.GetMemFd()), GetInode(pobj2.GetMemFd()));
+
+    /* the reader's content must stay mapped, so the copy is refused while pinned */
+    ASSERT_TRUE(pobj1.BeginRead());
+    char *content = static_cast<char *>(pobj1.GetContent());
+    EXPECT_FALSE(pobj1.BeginWrite());
+    EXPECT_FALSE(pobj1.ModifyContentByBuilder(std::make_unique<TestDataModifier>('A', 'B')));
+    EXPECT_EQ(strncmp(alphabet, content, ALPHABET_LEN), 0);
+    pobj1.EndRead();
+    EXPECT_EQ(pobj1.GetPinStatus(), 0);
+    EXPECT_EQ(GetInode(pobj1.GetMemFd()), GetInode(pobj2.GetMemFd()));
+
+    /* copied once unpinned, and the pin counts of both memfds are balanced */
+    ASSERT_TRUE(pobj1.BeginWrite());
+    EXPECT_NE(GetInode(pobj1.GetMemFd()), GetInode(pobj2.GetMemFd()));
+    pobj1.EndWrite();
+    EXPECT_EQ(pobj1.GetPinStatus(), 0);
+    EXPECT_EQ(pobj2.GetPinStatus(), 0);
+    EXPECT_TRUE(pobj2.Purge());
+    ASSERT_TRUE(pobj1.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj1.GetContent()), ALPHABET_LEN), 0);
+    pobj1.EndRead();
+}
+
+HWTEST_F(PurgeableMemFdTest, ModifySharedTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    const char modified[] = "BBCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    int count = 0;
+    PurgeableMemFd pobj1(27, std::make_unique<KeyedDataBuilder>('A', 'Z', &count));
+    PurgeableMemFd pobj2(27, std::make_unique<KeyedDataBuilder>('A', 'Z', &count));
+    ASSERT_TRUE(pobj1.BeginRead());
+    pobj1.EndRead();
+
+    /* modify without BeginWrite copies the content too */
+    ASSERT_TRUE(pobj1.ModifyContentByBuilder(std::make_unique<TestDataModifier>('A', 'B')));
+    EXPECT_NE(GetInode(pobj1.GetMemFd()), GetInode(pobj2.GetMemFd()));
+    ASSERT_TRUE(pobj1.BeginRead());
+    EXPECT_EQ(strncmp(modified, static_cast<char *>(pobj1.GetContent()), ALPHABET_LEN), 0);
+    pobj1.EndRead();
+    ASSERT_TRUE(pobj2.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj2.GetContent()), ALPHABET_LEN), 0);
+    pobj2.EndRead();
+    EXPECT_EQ(count, 1);
+
+    /* each rebuild replays only its own modifiers */
+    EXPECT_TRUE(pobj1.Purge());
+    EXPECT_TRUE(pobj2.Purge());
+    ASSERT_TRUE(pobj1.BeginRead());
+    EXPECT_EQ(strncmp(modified, static_cast<char *>(pobj1.GetContent()), ALPHABET_LEN), 0);
+    pobj1.EndRead();
+    ASSERT_TRUE(pobj2.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj2.GetContent()), ALPHABET_LEN), 0);
+    pobj2.EndRead();
+}
+
+HWTEST_F(PurgeableMemFdTest, ChangeMemFdDataTest, TestSize.Level1)
+{
+    PurgeableMemFd pobj(std::make_unique<CountDataBuilder>('A', 'Z', nullptr));
+    EXPECT_FALSE(pobj.ChangeMemFdData(0, 0));
+    EXPECT_FALSE(pobj.ChangeMemFdData(27, -1));
+
+    int fd = memfd_create("NotPurgeableMemFd", MFD_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(ftruncate(fd, PAGE_SIZE * 2), 0);
+    EXPECT_FALSE(pobj.ChangeMemFdData(PAGE_SIZE * 4, fd));
+    EXPECT_FALSE(pobj.ChangeMemFdData(27, fd));
+    close(fd);
+    EXPECT_FALSE(pobj.BeginRead());
+}
+
+HWTEST_F(PurgeableMemFdTest, ResizeDataTest, TestSize.Level1)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\0";
+    PurgeableMemFd pobj(27, std::make_unique<CountDataBuilder>('A', 'Z', nullptr));
+    pobj.ResizeData(0);
+    EXPECT_EQ(pobj.GetContentSize(), 27);
+    pobj.ResizeData(PAGE_SIZE * 2);
+    EXPECT_EQ(pobj.GetContentSize(), PAGE_SIZE * 2);
+    ASSERT_TRUE(pobj.BeginRead());
+    EXPECT_EQ(strncmp(alphabet, static_cast<char *>(pobj.GetContent()), ALPHABET_LEN), 0);
+    pobj.EndRead();
+}
+
+HWTEST_F(PurgeableMemFdTest, InvalidInputTest, TestSize.Level1)
+{
+    PurgeableMemFd pobj1(0, std::make_unique<CountDataBuilder>('A', 'Z', nullptr));
+    EXPECT_FALSE(pobj1.BeginRead());
+    PurgeableMemFd pobj2(27, nullptr);
+    EXPECT_FALSE(pobj2.BeginRead());
+    EXPECT_FALSE(pobj2.Purge());
+    EXPECT_EQ(pobj2.GetPinStatus(), 0);
+}
+} /* namespace PurgeableMem */
+} /* namespace OHOS */
@@ -15,6 +15,63 @@
 #ifndef COMM_UTILS_SYNC_H
 #define COMM_UTILS_SYNC_H
 
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
 int SyncWait(int num, int time);
 
-#endif
\ No newline at end of file
+/*
+ * SyncReactor: an epoll based reactor which waits for many fences on few threads.
+ * A fence added to the reactor is watched until it signals or its timeout expires,
+ * then its callback is invoked once from the thread calling SyncReactorPoll().
+ */
+struct SyncReactor;
+
+/*
+ * Function pointer, it is called once a fence added to a SyncReactor is done.
+ * Input:   int: fence fd passed to SyncReactorAddFence().
+ * Input:   int: 0 if the fence signaled, -ETIME if it timed out, -EINVAL on fence error.
+ * Input:   void *: private data passed to SyncReactorAddFence().
+ */
+typedef void (*SyncFenceCallback)(int, int, void *);
+
+struct SyncReactor *SyncReactorCreate(void);
+
+/* Pending fences are dropped without calling their callbacks. */
+void SyncReactorDestroy(struct SyncReactor *reactor);
+
+/*
+ * SyncReactorAddFence: watch @fd until it signals or @timeout(ms) expires, -1 means no timeout.
+ * @fd is duplicated, so the caller may close it once this function returns.
+ * Thread safe, it may be called from a fence callback.
+ * Return:  0 on success, -1 with errno set on failure.
+ */
+int SyncReactorAddFence(struct SyncReactor *reactor, int fd, int timeout, SyncFenceCallback callback, void *data);
+
+/*
+ * SyncReactorRemoveFence: stop watching the fences added with @fd and @data, their callbacks are not invoked.
+ * Thread safe, it may be called from a fence callback.
+ * Return:  0 on success, -1 with errno ENOENT if none is pending, its callback may then be running.
+ */
+int SyncReactorRemoveFence(struct SyncReactor *reactor, int fd, void *data);
+
+/*
+ * SyncReactorPoll: wait up to @timeout(ms) for fences and dispatch their callbacks.
+ * Concurrent callers are serialized.
+ * Return:  number of callbacks dispatched, -1 with errno set on failure.
+ */
+int SyncReactorPoll(struct SyncReactor *reactor, int timeout);
+
+/* Process wide reactor, polled by a background thread started on first use. */
+struct SyncReactor *SyncReactorGetDefault(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* End of #if __cplusplus */
+#endif /* End of #ifdef __cplusplus */
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef COMM_UTILS_SYNC_AWAITABLE_H
+#define COMM_UTILS_SYNC_AWAITABLE_H
+
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+
+#include <cerrno>
+#include <coroutine>
+
+#include "sync.h"
+
+namespace OHOS {
+namespace Sync {
+/*
+ * FenceReady: awaitable of a fence fd, usage: int status = co_await FenceReady(fd, timeout);
+ * status is 0 if the fence signaled, -ETIME if it timed out, -EINVAL on fence error.
+ * The awaiting coroutine is resumed on the thread polling @reactor, which is the
+ * background thread of SyncReactorGetDefault() if no reactor is given.
+ */
+class FenceReady {
+public:
+    FenceReady(int fd, int timeout, SyncReactor *reactor = nullptr)
+        : fd_(fd), timeout_(timeout), reactor_(reactor ? reactor : SyncReactorGetDefault())
+    {
+    }
+
+    bool await_ready()
+    {
+        /* already signaled fences never suspend */
+        if (SyncWait(fd_, 0) == 0) {
+            status_ = 0;
+            return true;
+        }
+        if (errno != ETIME) {
+            status_ = -EINVAL;
+            return true;
+        }
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        handle_ = handle;
+        if (reactor_ == nullptr || SyncReactorAddFence(reactor_, fd_, timeout_, OnFenceDone, this) != 0) {
+            status_ = -EINVAL;
+            return false;
+        }
+        return true;
+    }
+
+    int await_resume() const
+    {
+        return status_;
+    }
+
+private:
+    static void OnFenceDone(int fd, int status, void *data)
+    {
+        FenceReady *self = static_cast<FenceReady *>(data);
+        self->status_ = status;
+        self->handle_.resume();
+    }
+
+    int fd_;
+    int timeout_;
+    SyncReactor *reactor_;
+    int status_ = 0;
+    std::coroutine_handle<> handle_;
+};
+} /* namespace Sync */
+} /* namespace OHOS */
+
+#endif /* __cpp_impl_coroutine */
+#endif /* COMM_UTILS_SYNC_AWAITABLE_H */
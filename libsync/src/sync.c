@@ -14,8 +14,40 @@
  */
 #include "sync.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SYNC_REACTOR_MAX_EVENTS 64
+#define MSEC_PER_SEC 1000LL
+#define NSEC_PER_MSEC 1000000LL
+
+struct SyncWaiter {
+    struct SyncWaiter *next;
+    int fd; /* duplicated fence fd, owned by the waiter */
+    int userFd;
+    int status;
+    long long deadline; /* CLOCK_MONOTONIC ms, -1 means never */
+    SyncFenceCallback callback;
+    void *data;
+};
+
+struct SyncReactor {
+    int epollFd;
+    int wakeFd;
+    pthread_mutex_t listLock; /* protects waiters */
+    pthread_mutex_t pollLock; /* serializes SyncReactorPoll */
+    struct SyncWaiter *waiters;
+    struct SyncWaiter *removed; /* freed by the next poll, a polled event may still point to them */
+};
 
 int SyncWait(int num, int time)
 {
@@ -46,3 +78,287 @@ int SyncWait(int num, int time)
 
     return result;
 }
+
+static long long NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * MSEC_PER_SEC + ts.tv_nsec / NSEC_PER_MSEC;
+}
+
+static void FreeWaiter(struct SyncWaiter *waiter)
+{
+    if (waiter->fd >= 0) {
+        close(waiter->fd);
+    }
+    free(waiter);
+}
+
+static void FreeWaiterList(struct SyncWaiter *curr)
+{
+    while (curr) {
+        struct SyncWaiter *next = curr->next;
+        FreeWaiter(curr);
+        curr = next;
+    }
+}
+
+struct SyncReactor *SyncReactorCreate(void)
+{
+    struct SyncReactor *reactor = (struct SyncReactor *)calloc(1, sizeof(struct SyncReactor));
+    if (reactor == NULL) {
+        return NULL;
+    }
+    reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epollFd < 0) {
+        goto free_reactor;
+    }
+    reactor->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (reactor->wakeFd < 0) {
+        goto close_epoll;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    if (epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->wakeFd, &ev) != 0) {
+        goto close_wake;
+    }
+    pthread_mutex_init(&reactor->listLock, NULL);
+    pthread_mutex_init(&reactor->pollLock, NULL);
+    return reactor;
+
+close_wake:
+    close(reactor->wakeFd);
+close_epoll:
+    close(reactor->epollFd);
+free_reactor:
+    free(reactor);
+    return NULL;
+}
+
+void SyncReactorDestroy(struct SyncReactor *reactor)
+{
+    if (reactor == NULL) {
+        return;
+    }
+    FreeWaiterList(reactor->waiters);
+    FreeWaiterList(reactor->removed);
+    close(reactor->wakeFd);
+    close(reactor->epollFd);
+    pthread_mutex_destroy(&reactor->listLock);
+    pthread_mutex_destroy(&reactor->pollLock);
+    free(reactor);
+}
+
+int SyncReactorAddFence(struct SyncReactor *reactor, int fd, int timeout, SyncFenceCallback callback, void *data)
+{
+    if (reactor == NULL || fd < 0 || callback == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct SyncWaiter *waiter = (struct SyncWaiter *)calloc(1, sizeof(struct SyncWaiter));
+    if (waiter == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    /* one epoll registration per waiter, so the same fence may be awaited more than once */
+    waiter->fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (waiter->fd < 0) {
+        free(waiter);
+        return -1;
+    }
+    waiter->userFd = fd;
+    waiter->deadline = timeout < 0 ? -1 : NowMs() + timeout;
+    waiter->callback = callback;
+    waiter->data = data;
+
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = waiter };
+    pthread_mutex_lock(&reactor->listLock);
+    if (epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, waiter->fd, &ev) != 0) {
+        int err = errno;
+        pthread_mutex_unlock(&reactor->listLock);
+        FreeWaiter(waiter);
+        errno = err;
+        return -1;
+    }
+    waiter->next = reactor->waiters;
+    reactor->waiters = waiter;
+    pthread_mutex_unlock(&reactor->listLock);
+
+    if (timeout >= 0) {
+        /* the poller may sleep past the new deadline, wake it to recompute */
+        uint64_t one = 1;
+        (void)write(reactor->wakeFd, &one, sizeof(one));
+    }
+    return 0;
+}
+
+/* caller holds listLock, return false if @waiter is not pending */
+static bool UnlinkWaiter(struct SyncReactor *reactor, struct SyncWaiter *waiter)
+{
+    struct SyncWaiter **pp = &reactor->waiters;
+    while (*pp) {
+        if (*pp == waiter) {
+            *pp = waiter->next;
+            waiter->next = NULL;
+            return true;
+        }
+        pp = &(*pp)->next;
+    }
+    return false;
+}
+
+int SyncReactorRemoveFence(struct SyncReactor *reactor, int fd, void *data)
+{
+    if (reactor == NULL || fd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    int count = 0;
+    pthread_mutex_lock(&reactor->listLock);
+    struct SyncWaiter **pp = &reactor->waiters;
+    while (*pp) {
+        struct SyncWaiter *curr = *pp;
+        if (curr->userFd != fd || curr->data != data) {
+            pp = &curr->next;
+            continue;
+        }
+        *pp = curr->next;
+        (void)epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, curr->fd, NULL);
+        close(curr->fd);
+        curr->fd = -1;
+        curr->next = reactor->removed;
+        reactor->removed = curr;
+        count++;
+    }
+    pthread_mutex_unlock(&reactor->listLock);
+    if (count == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
+/* caller holds listLock */
+static int NextWaitMs(struct SyncReactor *reactor, int timeout, long long now)
+{
+    long long wait = timeout;
+    for (struct SyncWaiter *curr = reactor->waiters; curr; curr = curr->next) {
+        if (curr->deadline < 0) {
+            continue;
+        }
+        long long left = curr->deadline > now ? curr->deadline - now : 0;
+        if (wait < 0 || left < wait) {
+            wait = left;
+        }
+    }
+    return (int)wait;
+}
+
+/* move waiters whose deadline passed to @done, caller holds listLock */
+static void CollectExpired(struct SyncReactor *reactor, long long now, struct SyncWaiter **done)
+{
+    struct SyncWaiter **pp = &reactor->waiters;
+    while (*pp) {
+        struct SyncWaiter *curr = *pp;
+        if (curr->deadline < 0 || curr->deadline > now) {
+            pp = &curr->next;
+            continue;
+        }
+        *pp = curr->next;
+        (void)epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, curr->fd, NULL);
+        curr->status = -ETIME;
+        curr->next = *done;
+        *done = curr;
+    }
+}
+
+int SyncReactorPoll(struct SyncReactor *reactor, int timeout)
+{
+    if (reactor == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct epoll_event events[SYNC_REACTOR_MAX_EVENTS];
+    struct SyncWaiter *done = NULL;
+
+    pthread_mutex_lock(&reactor->pollLock);
+    pthread_mutex_lock(&reactor->listLock);
+    int wait = NextWaitMs(reactor, timeout, NowMs());
+    pthread_mutex_unlock(&reactor->listLock);
+
+    int num = epoll_wait(reactor->epollFd, events, SYNC_REACTOR_MAX_EVENTS, wait);
+    if (num < 0 && errno != EINTR) {
+        int err = errno;
+        pthread_mutex_unlock(&reactor->pollLock);
+        errno = err;
+        return -1;
+    }
+
+    pthread_mutex_lock(&reactor->listLock);
+    for (int i = 0; i < num; i++) {
+        struct SyncWaiter *waiter = (struct SyncWaiter *)events[i].data.ptr;
+        if (waiter == NULL) {
+            uint64_t cnt;
+            (void)read(reactor->wakeFd, &cnt, sizeof(cnt));
+            continue;
+        }
+        if (!UnlinkWaiter(reactor, waiter)) {
+            /* removed after epoll_wait returned */
+            continue;
+        }
+        /* the caller still holds the fence, so closing the dup'ed fd keeps the registration */
+        (void)epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, waiter->fd, NULL);
+        waiter->status = (events[i].events & EPOLLERR) ? -EINVAL : 0;
+        waiter->next = done;
+        done = waiter;
+    }
+    CollectExpired(reactor, NowMs(), &done);
+    struct SyncWaiter *removed = reactor->removed;
+    reactor->removed = NULL;
+    pthread_mutex_unlock(&reactor->listLock);
+    FreeWaiterList(removed);
+
+    /* only the poller frees waiters, so callbacks may add new fences safely */
+    int dispatched = 0;
+    while (done) {
+        struct SyncWaiter *next = done->next;
+        done->callback(done->userFd, done->status, done->data);
+        FreeWaiter(done);
+        dispatched++;
+        done = next;
+    }
+    pthread_mutex_unlock(&reactor->pollLock);
+    return dispatched;
+}
+
+static struct SyncReactor *g_defaultReactor = NULL;
+static pthread_once_t g_defaultReactorOnce = PTHREAD_ONCE_INIT;
+
+static void *DefaultReactorLoop(void *arg)
+{
+    struct SyncReactor *reactor = (struct SyncReactor *)arg;
+    while (true) {
+        (void)SyncReactorPoll(reactor, -1);
+    }
+    return NULL;
+}
+
+static void InitDefaultReactor(void)
+{
+    struct SyncReactor *reactor = SyncReactorCreate();
+    if (reactor == NULL) {
+        return;
+    }
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, DefaultReactorLoop, reactor) != 0) {
+        SyncReactorDestroy(reactor);
+        return;
+    }
+    pthread_detach(tid);
+    g_defaultReactor = reactor;
+}
+
+struct SyncReactor *SyncReactorGetDefault(void)
+{
+    pthread_once(&g_defaultReactorOnce, InitDefaultReactor);
+    return g_defaultReactor;
+}
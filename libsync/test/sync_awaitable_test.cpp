@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "sync_awaitable.h"
+
+#if !defined(__cpp_impl_coroutine)
+#error "sync_awaitable_test must be built with -std=c++20"
+#endif
+
+namespace OHOS {
+namespace Sync {
+using namespace testing;
+using namespace testing::ext;
+
+/* fire-and-forget coroutine, its frame is freed when it returns */
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object()
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+struct AwaitResult {
+    bool done = false;
+    int status = 1;
+};
+
+/* a poll may return early without dispatching, e.g. woken by a new timeout */
+static int PollFor(SyncReactor *reactor, int timeout)
+{
+    constexpr int step = 10;
+    for (int waited = 0; waited < timeout; waited += step) {
+        int num = SyncReactorPoll(reactor, step);
+        if (num != 0) {
+            return num;
+        }
+    }
+    return 0;
+}
+
+static DetachedTask AwaitFence(int fd, int timeout, SyncReactor *reactor, AwaitResult *result)
+{
+    result->status = co_await FenceReady(fd, timeout, reactor);
+    result->done = true;
+}
+
+class SyncAwaitableTest : public testing::Test {
+public:
+    void SetUp() override
+    {
+        reactor_ = SyncReactorCreate();
+        ASSERT_NE(reactor_, nullptr);
+        fd_ = eventfd(0, EFD_CLOEXEC);
+        ASSERT_GE(fd_, 0);
+    }
+
+    void TearDown() override
+    {
+        close(fd_);
+        SyncReactorDestroy(reactor_);
+    }
+
+    void Signal()
+    {
+        uint64_t one = 1;
+        ASSERT_EQ(write(fd_, &one, sizeof(one)), static_cast<ssize_t>(sizeof(one)));
+    }
+
+protected:
+    SyncReactor *reactor_ = nullptr;
+    int fd_ = -1;
+};
+
+HWTEST_F(SyncAwaitableTest, ReadyTest, TestSize.Level1)
+{
+    AwaitResult result;
+    Signal();
+    AwaitFence(fd_, -1, reactor_, &result);
+    /* a signaled fence never suspends */
+    EXPECT_TRUE(result.done);
+    EXPECT_EQ(result.status, 0);
+    EXPECT_EQ(SyncReactorPoll(reactor_, 0), 0);
+}
+
+HWTEST_F(SyncAwaitableTest, ResumeTest, TestSize.Level1)
+{
+    AwaitResult result;
+    AwaitFence(fd_, -1, reactor_, &result);
+    EXPECT_FALSE(result.done);
+
+    Signal();
+    EXPECT_EQ(PollFor(reactor_, 1000), 1);
+    EXPECT_TRUE(result.done);
+    EXPECT_EQ(result.status, 0);
+}
+
+HWTEST_F(SyncAwaitableTest, TimeoutTest, TestSize.Level1)
+{
+    AwaitResult result;
+    AwaitFence(fd_, 10, reactor_, &result);
+    EXPECT_FALSE(result.done);
+    EXPECT_EQ(PollFor(reactor_, 1000), 1);
+    EXPECT_TRUE(result.done);
+    EXPECT_EQ(result.status, -ETIME);
+}
+
+HWTEST_F(SyncAwaitableTest, InvalidFenceTest, TestSize.Level1)
+{
+    AwaitResult result;
+    AwaitFence(-1, -1, reactor_, &result);
+    EXPECT_TRUE(result.done);
+    EXPECT_EQ(result.status, -EINVAL);
+}
+} /* namespace Sync */
+} /* namespace OHOS */
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "sync.h"
+
+namespace OHOS {
+namespace Sync {
+using namespace testing;
+using namespace testing::ext;
+
+struct FenceResult {
+    int calls = 0;
+    int fd = -1;
+    int status = 1;
+};
+
+/* a poll may return early without dispatching, e.g. woken by a new timeout */
+static int PollFor(SyncReactor *reactor, int timeout)
+{
+    constexpr int step = 10;
+    for (int waited = 0; waited < timeout; waited += step) {
+        int num = SyncReactorPoll(reactor, step);
+        if (num != 0) {
+            return num;
+        }
+    }
+    return 0;
+}
+
+static void OnFence(int fd, int status, void *data)
+{
+    FenceResult *result = static_cast<FenceResult *>(data);
+    result->calls++;
+    result->fd = fd;
+    result->status = status;
+}
+
+static void Signal(int fd)
+{
+    uint64_t one = 1;
+    ASSERT_EQ(write(fd, &one, sizeof(one)), static_cast<ssize_t>(sizeof(one)));
+}
+
+class SyncReactorTest : public testing::Test {
+public:
+    void SetUp() override
+    {
+        reactor_ = SyncReactorCreate();
+        ASSERT_NE(reactor_, nullptr);
+        fd_ = eventfd(0, EFD_CLOEXEC);
+        ASSERT_GE(fd_, 0);
+    }
+
+    void TearDown() override
+    {
+        close(fd_);
+        SyncReactorDestroy(reactor_);
+    }
+
+protected:
+    SyncReactor *reactor_ = nullptr;
+    int fd_ = -1;
+};
+
+HWTEST_F(SyncReactorTest, SignalTest, TestSize.Level1)
+{
+    FenceResult result;
+    ASSERT_EQ(SyncReactorAddFence(reactor_, fd_, -1, OnFence, &result), 0);
+    EXPECT_EQ(SyncReactorPoll(reactor_, 0), 0);
+    EXPECT_EQ(result.calls, 0);
+
+    Signal(fd_);
+    EXPECT_EQ(PollFor(reactor_, 1000), 1);
+    EXPECT_EQ(result.calls, 1);
+    EXPECT_EQ(result.fd, fd_);
+    EXPECT_EQ(result.status, 0);
+
+    /* the callback runs once, the fence is not watched any more */
+    EXPECT_EQ(SyncReactorPoll(reactor_, 0), 0);
+    EXPECT_EQ(result.calls, 1);
+}
+
+HWTEST_F(SyncReactorTest, AwaitAgainTest, TestSize.Level1)
+{
+    /* a signaled fence is awaited again after its first callback */
+    Signal(fd_);
+    for (int i = 1; i <= 3; i++) {
+        FenceResult result;
+        ASSERT_EQ(SyncReactorAddFence(reactor_, fd_, -1, OnFence, &result), 0);
+        EXPECT_EQ(PollFor(reactor_, 1000), 1);
+        EXPECT_EQ(result.calls, 1);
+        EXPECT_EQ(result.status, 0);
+    }
+}
+
+HWTEST_F(SyncReactorTest, TimeoutTest, TestSize.Level1)
+{
+    FenceResult result;
+    ASSERT_EQ(SyncReactorAddFence(reactor_, fd_, 10, OnFence, &result), 0);
+    EXPECT_EQ(PollFor(reactor_, 1000), 1);
+    EXPECT_EQ(result.calls, 1);
+    EXPECT_EQ(result.status, -ETIME);
+}
+
+HWTEST_F(SyncReactorTest, RemoveTest, TestSize.Level1)
+{
+    FenceResult removed;
+    FenceResult kept;
+    ASSERT_EQ(SyncReactorAddFence(reactor_, fd_, -1, OnFence, &removed), 0);
+    ASSERT_EQ(SyncReactorAddFence(reactor_, fd_, -1, OnFence, &kept), 0);
+    EXPECT_EQ(SyncReactorRemoveFence(reactor_, fd_, &removed), 0);
+
+    Signal(fd_);
+    EXPECT_EQ(PollFor(reactor_, 1000), 1);
+    EXPECT_EQ(removed.calls, 0);
+    EXPECT_EQ(kept.calls, 1);
+
+    errno = 0;
+    EXPECT_EQ(SyncReactorRemoveFence(reactor_, fd_, &removed), -1);
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(SyncReactorRemoveFence(reactor_, fd_, &kept), -1);
+}
+
+HWTEST_F(SyncReactorTest, RemoveSignaledTest, TestSize.Level1)
+{
+    FenceResult result;
+    ASSERT_EQ(SyncReactorAddFence(reactor_, fd_, 10, OnFence, &result), 0);
+    Signal(fd_);
+    /* neither the signal nor the timeout is reported once removed */
+    EXPECT_EQ(SyncReactorRemoveFence(reactor_, fd_, &result), 0);
+    usleep(20000);
+    EXPECT_EQ(SyncReactorPoll(reactor_, 0), 0);
+    EXPECT_EQ(result.calls, 0);
+}
+
+HWTEST_F(SyncReactorTest, InvalidInputTest, TestSize.Level1)
+{
+    FenceResult result;
+    EXPECT_EQ(SyncReactorAddFence(nullptr, fd_, -1, OnFence, &result), -1);
+    EXPECT_EQ(SyncReactorAddFence(reactor_, -1, -1, OnFence, &result), -1);
+    EXPECT_EQ(SyncReactorAddFence(reactor_, fd_, -1, nullptr, &result), -1);
+    EXPECT_EQ(SyncReactorRemoveFence(nullptr, fd_, &result), -1);
+    EXPECT_EQ(SyncReactorPoll(nullptr, 0), -1);
+}
+} /* namespace Sync */
+} /* namespace OHOS */